@@ -0,0 +1,11 @@
+local sw = os.clock()
+for _ = 1,1000000 do
+end
+local dw = os.clock() - sw
+
+print(
+    string.format(
+        "Average delay per iteration: %sus",
+        dw
+    )
+)
@@ -18,12 +18,17 @@
 #include "ten_dat.h"
 #include "ten_ptr.h"
 #include "ten_lib.h"
+#include "ten_msg.h"
+#include "ten_pool.h"
+#include "ten_ssym.h"
 
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <ctype.h>
 #include <errno.h>
 #include <stdarg.h>
+#include <stdio.h>
 
 ten_Version const ten_VERSION = {
     .major = 0,
@@ -45,11 +50,47 @@ struct ApiState {
     TVal    typeVals[OBJ_LAST];
     
     Fiber* fib;
+    
+    ten_Pattern* pats;
+    ten_Prep*    preps;
+};
+
+struct ten_Pattern {
+    ten_Pattern*  next;
+    ten_Pattern** link;
+    uint          size;
+    
+    // Set if the pattern only has 'U' and 'N' entries, so
+    // takes no arguments.
+    bool  plain;
+    char  kinds[];
+};
+
+struct ten_Prep {
+    ten_Prep*  next;
+    ten_Prep** link;
+    Closure*   cls;
+    uint       argc;
 };
 
 void
 apiFinl( State* state, Finalizer* finl ) {
     ApiState* api = structFromFinl( ApiState, finl );
+    
+    ten_Pattern* it = api->pats;
+    while( it ) {
+        ten_Pattern* pat = it;
+        it = it->next;
+        stateFreeRaw( state, pat, sizeof(ten_Pattern) + pat->size );
+    }
+    
+    ten_Prep* pIt = api->preps;
+    while( pIt ) {
+        ten_Prep* prep = pIt;
+        pIt = pIt->next;
+        stateFreeRaw( state, prep, sizeof(ten_Prep) );
+    }
+    
     stateRemoveScanner( state, &api->scan );
     stateFreeRaw( state, api, sizeof(ApiState) );
 }
@@ -63,6 +104,12 @@ apiScan( State* state, Scanner* scan ) {
     if( api->fib )
         stateMark( state, api->fib );
     
+    ten_Prep* pIt = api->preps;
+    while( pIt ) {
+        stateMark( state, pIt->cls );
+        pIt = pIt->next;
+    }
+    
     if( !state->gcFull )
         return;
     
@@ -77,6 +124,8 @@ apiInit( State* state ) {
     api->val1 = tvUdf();
     api->val2 = tvUdf();
     api->fib  = NULL;
+    api->pats  = NULL;
+    api->preps = NULL;
     for( uint i = 0 ; i < OBJ_LAST ; i++ ) {
         api->typeVals[i] = tvUdf();
         api->typeVars[i] = (ten_Var){ (ten_Tup*)&api->typeTup, .loc = i };
@@ -145,6 +194,18 @@ ten_free( ten_State* s ) {
     frealloc( udata, s, sizeof(State), 0 );
 }
 
+size_t
+ten_memUsed( ten_State* s ) {
+    State* state = (State*)s;
+    return state->memUsed;
+}
+
+size_t
+ten_memPeak( ten_State* s ) {
+    State* state = (State*)s;
+    return state->memPeak;
+}
+
 ten_Tup
 ten_pushA( ten_State* s, char const* pat, ... ) {
     va_list ap; va_start( ap, pat );
@@ -201,6 +262,213 @@ ten_pushV( ten_State* s, char const* pat, va_list ap ) {
     return t;
 }
 
+ten_Pattern*
+ten_addPattern( ten_State* s, char const* pat ) {
+    State*    state = (State*)s;
+    ApiState* api   = state->apiState;
+    uint      n     = (uint)strlen( pat );
+    
+    bool plain = true;
+    for( uint i = 0 ; i < n ; i++ ) {
+        switch( pat[i] ) {
+            case 'U': case 'N':
+            break;
+            case 'L': case 'I': case 'D': case 'S': case 'P': case 'V':
+                plain = false;
+            break;
+            default:
+                stateErrFmtA( state, ten_ERR_USER, "Invalid type char '%c' in pattern", pat[i] );
+            break;
+        }
+    }
+    
+    Part patP;
+    ten_Pattern* p = stateAllocRaw( state, &patP, sizeof(ten_Pattern) + n );
+    p->size  = n;
+    p->plain = plain;
+    memcpy( p->kinds, pat, n );
+    addNode( &api->pats, p );
+    
+    stateCommitRaw( state, &patP );
+    return p;
+}
+
+void
+ten_freePattern( ten_State* s, ten_Pattern* pat ) {
+    State* state = (State*)s;
+    remNode( pat );
+    stateFreeRaw( state, pat, sizeof(ten_Pattern) + pat->size );
+}
+
+ten_Tup
+ten_pushP( ten_State* s, ten_Pattern* pat, ... ) {
+    va_list ap; va_start( ap, pat );
+    ten_Tup t = ten_pushPV( s, pat, ap );
+    va_end( ap );
+    return t;
+}
+
+ten_Tup
+ten_pushPV( ten_State* s, ten_Pattern* pat, va_list ap ) {
+    State* state = (State*)s;
+    Tup    tup   = statePush( state, pat->size );
+    
+    // The pushed values all start out as `udf`, so plain
+    // patterns only have their `nil`s to fill in.
+    if( pat->plain ) {
+        for( uint i = 0 ; i < pat->size ; i++ )
+            if( pat->kinds[i] == 'N' )
+                tupSet( tup, i, tvNil() );
+        
+        ten_Tup t; memcpy( &t, &tup, sizeof(Tup) );
+        return t;
+    }
+    
+    for( uint i = 0 ; i < pat->size ; i++ ) {
+        switch( pat->kinds[i] ) {
+            case 'U':
+            break;
+            case 'N':
+                tupSet( tup, i, tvNil() );
+            break;
+            case 'L':
+                tupSet( tup, i, tvLog( va_arg( ap, int ) ) );
+            break;
+            case 'I':
+                tupSet( tup, i, tvInt( va_arg( ap, long ) ) );
+            break;
+            case 'D': {
+                double d = va_arg( ap, double );
+                funAssert( !isnan( d ), "NaN given as Dec value", NULL );
+                tupSet( tup, i, tvDec( d ) );
+            } break;
+            case 'S': {
+                char const* str = va_arg( ap, char const* );
+                SymT        sym = symGet( state, str, strlen( str ) );
+                tupSet( tup, i, tvSym( sym ) );
+            } break;
+            case 'P': {
+                PtrT ptr = ptrGet( state, NULL, va_arg( ap, void* ) );
+                tupSet( tup, i, tvPtr( ptr ) );
+            } break;
+            case 'V': {
+                ten_Var* var = va_arg( ap, ten_Var* );
+                tupSet( tup, i, varGet( *var ) );
+            } break;
+        }
+    }
+    
+    ten_Tup t; memcpy( &t, &tup, sizeof(Tup) );
+    return t;
+}
+
+void
+ten_readP( ten_State* s, ten_Pattern* pat, ten_Tup* tup, void* dst, size_t const* offs ) {
+    State* state = (State*)s;
+    Tup*   t     = (Tup*)tup;
+    char*  base  = dst;
+    
+    if( t->size != pat->size )
+        stateErrFmtA(
+            state, ten_ERR_TUPLE,
+            "Tuple has %u values, pattern needs %u",
+            t->size, pat->size
+        );
+    
+    for( uint i = 0 ; i < pat->size ; i++ ) {
+        TVal val = tupGet( *t, i );
+        switch( pat->kinds[i] ) {
+            case 'U':
+                if( !tvIsUdf( val ) )
+                    goto bad;
+            break;
+            case 'N':
+                if( !tvIsNil( val ) )
+                    goto bad;
+            break;
+            case 'L':
+                if( !tvIsLog( val ) )
+                    goto bad;
+                *(bool*)( base + offs[i] ) = tvGetLog( val );
+            break;
+            case 'I':
+                if( !tvIsInt( val ) )
+                    goto bad;
+                *(long*)( base + offs[i] ) = tvGetInt( val );
+            break;
+            case 'D':
+                if( !tvIsDec( val ) )
+                    goto bad;
+                *(double*)( base + offs[i] ) = tvGetDec( val );
+            break;
+            case 'S': {
+                // Short symbols are decoded into a buffer shared
+                // by all of them, so the symbol itself is stored
+                // and left to the caller to decode.
+                if( !tvIsSym( val ) )
+                    goto bad;
+                ten_Var* var = *(ten_Var**)( base + offs[i] );
+                varSet( *var, val );
+            } break;
+            case 'P':
+                if( !tvIsPtr( val ) )
+                    goto bad;
+                *(void**)( base + offs[i] ) = ptrAddr( state, tvGetPtr( val ) );
+            break;
+            case 'V':
+            break;
+        }
+        continue;
+        
+        bad:
+        stateErrFmtA(
+            state, ten_ERR_TYPE,
+            "Wrong type for tuple value %u, pattern needs '%c'",
+            i, pat->kinds[i]
+        );
+    }
+}
+
+ten_Tup
+ten_pushInts( ten_State* s, long const* vals, unsigned n ) {
+    State* state = (State*)s;
+    Tup    tup   = statePush( state, n );
+    for( uint i = 0 ; i < n ; i++ )
+        tupSet( tup, i, tvInt( vals[i] ) );
+    
+    ten_Tup t; memcpy( &t, &tup, sizeof(Tup) );
+    return t;
+}
+
+ten_Tup
+ten_pushDecs( ten_State* s, double const* vals, unsigned n ) {
+    State* state = (State*)s;
+    Tup    tup   = statePush( state, n );
+    for( uint i = 0 ; i < n ; i++ ) {
+        funAssert( !isnan( vals[i] ), "NaN given as Dec value", NULL );
+        tupSet( tup, i, tvDec( vals[i] ) );
+    }
+    
+    ten_Tup t; memcpy( &t, &tup, sizeof(Tup) );
+    return t;
+}
+
+ten_Tup
+ten_pushStrs( ten_State* s, char const* const* strs, unsigned n ) {
+    State* state = (State*)s;
+    Tup    tup   = statePush( state, n );
+    
+    // Each String is on the stack before the next is allocated,
+    // so the earlier ones are safe from collection.
+    for( uint i = 0 ; i < n ; i++ ) {
+        String* str = strNew( state, strs[i], strlen( strs[i] ) );
+        tupSet( tup, i, tvObj( str ) );
+    }
+    
+    ten_Tup t; memcpy( &t, &tup, sizeof(Tup) );
+    return t;
+}
+
 void
 ten_pop( ten_State* s ) {
     State* state = (State*)s;
@@ -244,9 +512,11 @@ ten_set( ten_State* s, ten_Var* name, ten_Var* val ) {
     TVal nameV = varGet( *name );
     funAssert( tvIsSym( nameV ), "Wrong type for 'name', need Sym", NULL );
     
-    SymT  nameS = tvGetSym( nameV );
-    TVal* gval  = envGetGlobalByName( state, nameS );
-    *gval = varGet( *val );
+    uint loc = envFindGlobal( state, tvGetSym( nameV ) );
+    if( loc == UINT_MAX || tvIsUdf( envGetGlobalVal( state, loc ) ) )
+        stateErrFmtA( state, ten_ERR_ASSIGN, "Mutation of undefined variable" );
+    
+    envSetGlobalVal( state, loc, varGet( *val ) );
 }
 
 void
@@ -255,14 +525,62 @@ ten_get( ten_State* s, ten_Var* name, ten_Var* dst ) {
     TVal nameV = varGet( *name );
     funAssert( tvIsSym( nameV ), "Wrong type for 'name', need Sym", NULL );
     
-    SymT     nameS = tvGetSym( nameV );
-    TVal*    gval  = envGetGlobalByName( state, nameS );
-    if( gval )
-        varSet( *dst, *gval );
+    uint loc = envFindGlobal( state, tvGetSym( nameV ) );
+    if( loc != UINT_MAX )
+        varSet( *dst, envGetGlobalVal( state, loc ) );
     else
         varSet( *dst, tvUdf() );
 }
 
+ten_GlobalRef
+ten_globalRef( ten_State* s, ten_Var* name ) {
+    State* state = (State*)s;
+    TVal nameV = varGet( *name );
+    funAssert( tvIsSym( nameV ), "Wrong type for 'name', need Sym", NULL );
+    
+    // Adding the global just reserves its slot, it stays
+    // undefined until something defines it; and the slot
+    // doesn't move after that, so the location is good for
+    // the life of the State.
+    uint loc = envAddGlobal( state, tvGetSym( nameV ) );
+    return (ten_GlobalRef){ .loc = loc };
+}
+
+void
+ten_getGlobal( ten_State* s, ten_GlobalRef ref, ten_Var* dst ) {
+    State* state = (State*)s;
+    varSet( *dst, envGetGlobalVal( state, ref.loc ) );
+}
+
+void
+ten_setGlobal( ten_State* s, ten_GlobalRef ref, ten_Var* val ) {
+    State* state = (State*)s;
+    envSetGlobalVal( state, ref.loc, varGet( *val ) );
+}
+
+static void
+snapGlobal( State* state, void* udat, SymT name, uint loc ) {
+    Record* rec = udat;
+    TVal    val = envGetGlobalVal( state, loc );
+    if( !tvIsUdf( val ) )
+        recDef( state, rec, tvSym( name ), val );
+}
+
+void
+ten_globals( ten_State* s, ten_Var* dst ) {
+    State*    state = (State*)s;
+    ApiState* api   = state->apiState;
+    
+    api->val1 = tvObj( idxNew( state ) );
+    Record* rec = recNew( state, tvGetObj( api->val1 ) );
+    api->val1 = tvObj( rec );
+    
+    envForEachGlobal( state, rec, snapGlobal );
+    
+    varSet( *dst, api->val1 );
+    api->val1 = tvUdf();
+}
+
 void
 ten_type( ten_State* s, ten_Var* var, ten_Var* dst ) {
     State*    state = (State*)s;
@@ -909,6 +1227,12 @@ ten_newStr( ten_State* s, char const* str, size_t len, ten_Var* dst ) {
     varSet( *dst, tvObj( strNew( state, str, len ) ) );
 }
 
+void
+ten_newExtStr( ten_State* s, char const* buf, size_t len, ten_StrDestr destr, void* udata, ten_Var* dst ) {
+    State* state = (State*)s;
+    varSet( *dst, tvObj( strNewExt( state, buf, len, destr, udata ) ) );
+}
+
 char const*
 ten_getStrBuf( ten_State* s, ten_Var* var ) {
     State* state = (State*)s;
@@ -940,6 +1264,142 @@ ten_strType( ten_State* s ) {
     return &state->apiState->typeVars[OBJ_STR];
 }
 
+bool
+ten_isBuilder( ten_State* s, ten_Var* var ) {
+    State* state = (State*)s;
+    return libIsBuilder( state, varGet( *var ) );
+}
+
+void
+ten_newBuilder( ten_State* s, ten_Var* dst ) {
+    State* state = (State*)s;
+    varSet( *dst, tvObj( libBuilder( state ) ) );
+}
+
+void
+ten_append( ten_State* s, ten_Var* bld, char const* str, size_t len ) {
+    State* state = (State*)s;
+    TVal bldV = varGet( *bld );
+    funAssert( libIsBuilder( state, bldV ), "Wrong type for 'bld', need Builder", NULL );
+    
+    libAppendBuf( state, tvGetObj( bldV ), str, len );
+}
+
+void
+ten_appendVal( ten_State* s, ten_Var* bld, ten_Var* val ) {
+    State* state = (State*)s;
+    TVal bldV = varGet( *bld );
+    funAssert( libIsBuilder( state, bldV ), "Wrong type for 'bld', need Builder", NULL );
+    
+    libAppend( state, tvGetObj( bldV ), varGet( *val ) );
+}
+
+void
+ten_build( ten_State* s, ten_Var* bld, ten_Var* dst ) {
+    State* state = (State*)s;
+    TVal bldV = varGet( *bld );
+    funAssert( libIsBuilder( state, bldV ), "Wrong type for 'bld', need Builder", NULL );
+    
+    varSet( *dst, tvObj( libBuild( state, tvGetObj( bldV ) ) ) );
+}
+
+bool
+ten_isBuf( ten_State* s, ten_Var* var ) {
+    State* state = (State*)s;
+    return libIsBuf( state, varGet( *var ) );
+}
+
+void
+ten_newBuf( ten_State* s, ten_Var* dst ) {
+    State* state = (State*)s;
+    varSet( *dst, tvObj( libBuf( state ) ) );
+}
+
+void
+ten_bufAdd( ten_State* s, ten_Var* buf, char const* bytes, size_t len ) {
+    State* state = (State*)s;
+    TVal bufV = varGet( *buf );
+    funAssert( libIsBuf( state, bufV ), "Wrong type for 'buf', need Buf", NULL );
+    
+    libBufAddBytes( state, tvGetObj( bufV ), bytes, len );
+}
+
+char*
+ten_getBufBytes( ten_State* s, ten_Var* buf ) {
+    State* state = (State*)s;
+    TVal bufV = varGet( *buf );
+    funAssert( libIsBuf( state, bufV ), "Wrong type for 'buf', need Buf", NULL );
+    
+    return libBufBytes( state, tvGetObj( bufV ) );
+}
+
+size_t
+ten_getBufLen( ten_State* s, ten_Var* buf ) {
+    State* state = (State*)s;
+    TVal bufV = varGet( *buf );
+    funAssert( libIsBuf( state, bufV ), "Wrong type for 'buf', need Buf", NULL );
+    
+    return libBufLen( state, tvGetObj( bufV ) );
+}
+
+void
+ten_bufStr( ten_State* s, ten_Var* buf, ten_Var* dst ) {
+    State* state = (State*)s;
+    TVal bufV = varGet( *buf );
+    funAssert( libIsBuf( state, bufV ), "Wrong type for 'buf', need Buf", NULL );
+    
+    Data* b = tvGetObj( bufV );
+    varSet( *dst, tvObj( libBufSub( state, b, 0, libBufLen( state, b ) ) ) );
+}
+
+bool
+ten_isVec( ten_State* s, ten_Var* var ) {
+    State* state = (State*)s;
+    return libIsVec( state, varGet( *var ) );
+}
+
+void
+ten_newVec( ten_State* s, ten_VecType type, size_t len, ten_Var* dst ) {
+    State* state = (State*)s;
+    varSet( *dst, tvObj( libVec( state, type == ten_VEC_DEC, len ) ) );
+}
+
+ten_VecType
+ten_getVecType( ten_State* s, ten_Var* vec ) {
+    State* state = (State*)s;
+    TVal vecV = varGet( *vec );
+    funAssert( libIsVec( state, vecV ), "Wrong type for 'vec', need Vec", NULL );
+    
+    return libVecIsDec( state, tvGetObj( vecV ) ) ? ten_VEC_DEC : ten_VEC_INT;
+}
+
+size_t
+ten_getVecLen( ten_State* s, ten_Var* vec ) {
+    State* state = (State*)s;
+    TVal vecV = varGet( *vec );
+    funAssert( libIsVec( state, vecV ), "Wrong type for 'vec', need Vec", NULL );
+    
+    return libVecLen( state, tvGetObj( vecV ) );
+}
+
+void*
+ten_getVecBuf( ten_State* s, ten_Var* vec ) {
+    State* state = (State*)s;
+    TVal vecV = varGet( *vec );
+    funAssert( libIsVec( state, vecV ), "Wrong type for 'vec', need Vec", NULL );
+    
+    return libVecValues( state, tvGetObj( vecV ) );
+}
+
+void
+ten_resizeVec( ten_State* s, ten_Var* vec, size_t len ) {
+    State* state = (State*)s;
+    TVal vecV = varGet( *vec );
+    funAssert( libIsVec( state, vecV ), "Wrong type for 'vec', need Vec", NULL );
+    
+    libVecResize( state, tvGetObj( vecV ), len );
+}
+
 bool
 ten_isIdx( ten_State* s, ten_Var* var ) {
     State* state = (State*)s;
@@ -1090,14 +1550,22 @@ ten_newFun( ten_State* s, ten_FunParams* p, ten_Var* dst ) {
     SymT* params = stateAllocRaw( state, &paramsP, sizeof(SymT)*nParams );
     memcpy( params, sparams, sizeof(SymT)*nParams );
     
-    Function* fun =
-        funNewNat( state, nParams, vParams ? idxNew( state ) : NULL, p->cb );
-    fun->u.nat.params = params;
-    if( p->name )
-        fun->u.nat.name = symGet( state, p->name, strlen( p->name ) );
+    // Keep the variadic index and function in `dst` as
+    // they're made, so they aren't collected while the
+    // others are allocated or the name is interned.
+    Index* vargIdx = NULL;
+    if( vParams ) {
+        vargIdx = idxNew( state );
+        varSet( *dst, tvObj( vargIdx ) );
+    }
     
+    Function* fun = funNewNat( state, nParams, vargIdx, p->cb );
+    fun->u.nat.params = params;
     stateCommitRaw( state, &paramsP );
     varSet( *dst, tvObj( fun ) );
+    
+    if( p->name )
+        fun->u.nat.name = symGet( state, p->name, strlen( p->name ) );
 }
 
 ten_Var*
@@ -1282,6 +1750,64 @@ ten_call_( ten_State* s, ten_Var* cls, ten_Tup* args, char const* file, unsigned
     return tup;
 }
 
+ten_Prep*
+ten_prepareCall( ten_State* s, ten_Var* cls, unsigned argc ) {
+    State*    state = (State*)s;
+    ApiState* api   = state->apiState;
+    
+    TVal clsV = varGet( *cls );
+    funAssert(
+        tvIsObj( clsV ) && datGetTag( tvGetObj( clsV ) ) == OBJ_CLS,
+        "Wrong type for 'cls', need Cls",
+        NULL
+    );
+    Closure* clsO = tvGetObj( clsV );
+    
+    uint parc = clsO->fun->nParams;
+    if( argc < parc || ( argc > parc && !clsO->fun->vargIdx ) )
+        stateErrFmtA(
+            state, ten_ERR_CALL,
+            "Prepared call passes %u arguments, function takes %u",
+            argc, parc
+        );
+    
+    Part prepP;
+    ten_Prep* prep = stateAllocRaw( state, &prepP, sizeof(ten_Prep) );
+    prep->cls  = clsO;
+    prep->argc = argc;
+    addNode( &api->preps, prep );
+    
+    stateCommitRaw( state, &prepP );
+    return prep;
+}
+
+void
+ten_freePrep( ten_State* s, ten_Prep* prep ) {
+    State* state = (State*)s;
+    remNode( prep );
+    stateFreeRaw( state, prep, sizeof(ten_Prep) );
+}
+
+ten_Tup
+ten_pushCall( ten_State* s, ten_Prep* prep ) {
+    State* state = (State*)s;
+    funAssert( state->fiber, "Call without running fiber", NULL );
+    
+    ten_Tup tup = { 0 };
+    *(Tup*)&tup = fibPushCall( state, prep->cls, prep->argc );
+    return tup;
+}
+
+ten_Tup
+ten_callPrepared_( ten_State* s, ten_Prep* prep, char const* file, unsigned line ) {
+    State* state = (State*)s;
+    funAssert( state->fiber, "Call without running fiber", NULL );
+    
+    ten_Tup tup = { 0 };
+    *(Tup*)&tup = fibCallPushed_( state, prep->argc, file, line );
+    return tup;
+}
+
 void
 ten_yield( ten_State* s, ten_Tup* vals ) {
     State* state = (State*)s;
@@ -1536,3 +2062,122 @@ ten_members( ten_State* s, ten_Var* dat ) {
     };
     return tup;
 }
+
+ten_Msg*
+ten_pack( ten_State* s, ten_Tup* tup ) {
+    State* state = (State*)s;
+    return (ten_Msg*)msgPack( state, (Tup*)tup );
+}
+
+ten_Tup
+ten_unpack( ten_State* s, ten_Msg* msg ) {
+    State* state = (State*)s;
+    
+    ten_Tup tup = { 0 };
+    *(Tup*)&tup = msgUnpack( state, (Msg*)msg );
+    return tup;
+}
+
+void
+ten_freeMsg( ten_Msg* msg ) {
+    msgFree( (Msg*)msg );
+}
+
+ten_Image*
+ten_snapshot( ten_State* s ) {
+    State* state = (State*)s;
+    return (ten_Image*)msgPackImage( state );
+}
+
+void
+ten_restore( ten_State* s, ten_Image* img ) {
+    State* state = (State*)s;
+    msgLoadImage( state, (Msg*)img );
+}
+
+void
+ten_freeImage( ten_Image* img ) {
+    msgFree( (Msg*)img );
+}
+
+ten_State*
+ten_fork( ten_State* s, jmp_buf* errJmp ) {
+    State* parent = (State*)s;
+    Msg*   img    = msgPackImage( parent );
+    
+    ten_Config config = parent->config;
+    State*     child  = config.frealloc( config.udata, NULL, 0, sizeof(State) );
+    if( !child ) {
+        msgFree( img );
+        stateErrVal( parent, ten_ERR_FATAL, parent->errOutOfMem );
+    }
+    
+    // Errors raised while the child is being initialized are
+    // re-raised in the parent, since the caller doesn't have
+    // the child to get the error from yet.  The message is
+    // copied to the stack first, so nothing is left behind
+    // if the parent fails to allocate its error string.
+    jmp_buf forkJmp;
+    if( setjmp( forkJmp ) ) {
+        msgFree( img );
+        
+        char buf[256];
+        snprintf( buf, sizeof(buf), "%s", fmtA( child, false, "%v", child->errVal ) );
+        ten_ErrNum err = child->errNum;
+        ten_free( (ten_State*)child );
+        
+        stateErrFmtA( parent, err, "%s", buf );
+    }
+    
+    stateInit( child, &config, &forkJmp );
+    msgLoadImage( child, img );
+    msgFree( img );
+    
+    stateSwapErrJmp( child, errJmp );
+    return (ten_State*)child;
+}
+
+ten_Pool*
+ten_makePool( ten_PoolConfig* config ) {
+    ten_Config notnull = { 0 };
+    if( config->config )
+        notnull = *config->config;
+    
+    if( notnull.frealloc == NULL )
+        notnull.frealloc = frealloc;
+    if( notnull.memGrowth == 0.0 )
+        notnull.memGrowth = DEFAULT_MEM_GROWTH;
+    
+    Pool* pool = poolMake( &notnull, config->workers, config->setup, config->udata );
+    return (ten_Pool*)pool;
+}
+
+void
+ten_freePool( ten_Pool* pool ) {
+    poolFree( (Pool*)pool );
+}
+
+unsigned
+ten_workers( ten_Pool* pool ) {
+    if( !pool )
+        return 0;
+    return poolSize( (Pool*)pool );
+}
+
+ten_SymTab*
+ten_makeSymTab( ten_Config* config ) {
+    ten_Config notnull = { 0 };
+    if( config )
+        notnull = *config;
+    
+    if( notnull.frealloc == NULL )
+        notnull.frealloc = frealloc;
+    
+    SymTab* tab = ssymMake( notnull.frealloc, notnull.udata );
+    return (ten_SymTab*)tab;
+}
+
+void
+ten_freeSymTab( ten_SymTab* symtab ) {
+    ssymFree( (SymTab*)symtab );
+}
@@ -17,6 +17,12 @@ can be found in `../docs/manual`.
 typedef struct ten_State       ten_State;
 typedef struct ten_Call        ten_Call;
 typedef struct ten_DatInfo     ten_DatInfo;
+typedef struct ten_Pattern     ten_Pattern;
+typedef struct ten_Prep        ten_Prep;
+typedef struct ten_Pool        ten_Pool;
+typedef struct ten_Msg         ten_Msg;
+typedef struct ten_SymTab      ten_SymTab;
+typedef struct ten_Image       ten_Image;
 
 typedef struct {
     char const* tag;
@@ -41,6 +47,10 @@ typedef struct {
     unsigned       loc;
 } ten_Var;
 
+typedef struct {
+    unsigned loc;
+} ten_GlobalRef;
+
 struct ten_Call {
     ten_State* ten;
     ten_Tup    args;
@@ -50,6 +60,8 @@ struct ten_Call {
 
 typedef ten_Tup (*ten_FunCb)( ten_Call const* call );
 
+typedef void (*ten_StrDestr)( char const* buf, size_t len, void* udata );
+
 typedef struct {
     char const*  name;
     char const** params;
@@ -95,6 +107,11 @@ typedef enum {
     ten_FIB_FAILED
 } ten_FibState;
 
+typedef enum {
+    ten_VEC_INT,
+    ten_VEC_DEC
+} ten_VecType;
+
 typedef struct ten_Trace ten_Trace;
 struct ten_Trace {
     char const* unit;
@@ -122,8 +139,19 @@ typedef struct ten_Config {
     bool ndebug;
     
     double memGrowth;
+    size_t memMax;
+    
+    ten_Pool*   pool;
+    ten_SymTab* symtab;
 } ten_Config;
 
+typedef struct {
+    ten_Config* config;
+    unsigned    workers;
+    void      (*setup)( ten_State* s, void* udata );
+    void*       udata;
+} ten_PoolConfig;
+
 
 typedef struct {
     unsigned major;
@@ -147,6 +175,13 @@ ten_make( ten_Config* config, jmp_buf* errJmp );
 void
 ten_free( ten_State* s );
 
+// Memory accounting.
+size_t
+ten_memUsed( ten_State* s );
+
+size_t
+ten_memPeak( ten_State* s );
+
 
 // Stack manipulation.
 ten_Tup
@@ -164,6 +199,33 @@ ten_dup( ten_State* s, ten_Tup* tup );
 unsigned
 ten_size( ten_State* state, ten_Tup* tup );
 
+// Push patterns compiled once up front, for bindings that push
+// or read the same shape of tuple on every call.
+ten_Pattern*
+ten_addPattern( ten_State* s, char const* pat );
+
+void
+ten_freePattern( ten_State* s, ten_Pattern* pat );
+
+ten_Tup
+ten_pushP( ten_State* s, ten_Pattern* pat, ... );
+
+ten_Tup
+ten_pushPV( ten_State* s, ten_Pattern* pat, va_list ap );
+
+void
+ten_readP( ten_State* s, ten_Pattern* pat, ten_Tup* tup, void* dst, size_t const* offs );
+
+// Bulk pushes from C arrays.
+ten_Tup
+ten_pushInts( ten_State* s, long const* vals, unsigned n );
+
+ten_Tup
+ten_pushDecs( ten_State* s, double const* vals, unsigned n );
+
+ten_Tup
+ten_pushStrs( ten_State* s, char const* const* strs, unsigned n );
+
 // Global variables.
 void
 ten_def( ten_State* s, ten_Var* name, ten_Var* val );
@@ -174,6 +236,19 @@ ten_set( ten_State* s, ten_Var* name, ten_Var* val );
 void
 ten_get( ten_State* s, ten_Var* name, ten_Var* dst );
 
+// Global variables by handle, resolved once by name.
+ten_GlobalRef
+ten_globalRef( ten_State* s, ten_Var* name );
+
+void
+ten_getGlobal( ten_State* s, ten_GlobalRef ref, ten_Var* dst );
+
+void
+ten_setGlobal( ten_State* s, ten_GlobalRef ref, ten_Var* val );
+
+void
+ten_globals( ten_State* s, ten_Var* dst );
+
 // Types.
 void
 ten_type( ten_State* s, ten_Var* var, ten_Var* dst );
@@ -220,6 +295,22 @@ ten_panic( ten_State* s, ten_Var* val );
 ten_Tup
 ten_call_( ten_State* s, ten_Var* cls, ten_Tup* args, char const* file, unsigned line );
 
+// Prepared calls, for calling the same closure repeatedly.
+ten_Prep*
+ten_prepareCall( ten_State* s, ten_Var* cls, unsigned argc );
+
+void
+ten_freePrep( ten_State* s, ten_Prep* prep );
+
+ten_Tup
+ten_pushCall( ten_State* s, ten_Prep* prep );
+
+#define ten_callPrepared( S, PREP ) \
+    ten_callPrepared_( S, PREP, __FILE__, __LINE__ )
+
+ten_Tup
+ten_callPrepared_( ten_State* s, ten_Prep* prep, char const* file, unsigned line );
+
 void
 ten_yield( ten_State* s, ten_Tup* vals );
 
@@ -380,6 +471,9 @@ ten_isStr( ten_State* s, ten_Var* var );
 void
 ten_newStr( ten_State* s, char const* str, size_t len, ten_Var* dst );
 
+void
+ten_newExtStr( ten_State* s, char const* buf, size_t len, ten_StrDestr destr, void* udata, ten_Var* dst );
+
 char const*
 ten_getStrBuf( ten_State* s, ten_Var* var );
 
@@ -389,6 +483,60 @@ ten_getStrLen( ten_State* s, ten_Var* var );
 ten_Var*
 ten_strType( ten_State* s );
 
+// String builders.
+bool
+ten_isBuilder( ten_State* s, ten_Var* var );
+
+void
+ten_newBuilder( ten_State* s, ten_Var* dst );
+
+void
+ten_append( ten_State* s, ten_Var* bld, char const* str, size_t len );
+
+void
+ten_appendVal( ten_State* s, ten_Var* bld, ten_Var* val );
+
+void
+ten_build( ten_State* s, ten_Var* bld, ten_Var* dst );
+
+// Byte buffers.
+bool
+ten_isBuf( ten_State* s, ten_Var* var );
+
+void
+ten_newBuf( ten_State* s, ten_Var* dst );
+
+void
+ten_bufAdd( ten_State* s, ten_Var* buf, char const* bytes, size_t len );
+
+char*
+ten_getBufBytes( ten_State* s, ten_Var* buf );
+
+size_t
+ten_getBufLen( ten_State* s, ten_Var* buf );
+
+void
+ten_bufStr( ten_State* s, ten_Var* buf, ten_Var* dst );
+
+// Packed numeric vectors.
+bool
+ten_isVec( ten_State* s, ten_Var* var );
+
+void
+ten_newVec( ten_State* s, ten_VecType type, size_t len, ten_Var* dst );
+
+ten_VecType
+ten_getVecType( ten_State* s, ten_Var* vec );
+
+size_t
+ten_getVecLen( ten_State* s, ten_Var* vec );
+
+void*
+ten_getVecBuf( ten_State* s, ten_Var* vec );
+
+void
+ten_resizeVec( ten_State* s, ten_Var* vec, size_t len );
+
 // Index objects.
 bool
 ten_isIdx( ten_State* s, ten_Var* var );
@@ -494,6 +642,46 @@ ten_datType( ten_State* s, ten_DatInfo* info );
 ten_Tup
 ten_members( ten_State* s, ten_Var* dat );
 
+// Messages.
+ten_Msg*
+ten_pack( ten_State* s, ten_Tup* tup );
+
+ten_Tup
+ten_unpack( ten_State* s, ten_Msg* msg );
+
+void
+ten_freeMsg( ten_Msg* msg );
+
+// Images.
+ten_Image*
+ten_snapshot( ten_State* s );
+
+void
+ten_restore( ten_State* s, ten_Image* img );
+
+void
+ten_freeImage( ten_Image* img );
+
+ten_State*
+ten_fork( ten_State* s, jmp_buf* errJmp );
+
+// Worker pools.
+ten_Pool*
+ten_makePool( ten_PoolConfig* config );
+
+void
+ten_freePool( ten_Pool* pool );
+
+unsigned
+ten_workers( ten_Pool* pool );
+
+// Shared symbol tables.
+ten_SymTab*
+ten_makeSymTab( ten_Config* config );
+
+void
+ten_freeSymTab( ten_SymTab* symtab );
+
 // Errors.
 
 ten_ErrNum
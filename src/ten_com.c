@@ -37,6 +37,13 @@ enum {
 };
 typedef ulong TokType;
 
+// States for recognizing counted loops, see `parLoop()`.
+typedef enum {
+    LOOP_NONE,
+    LOOP_RANGE,
+    LOOP_DEFER
+} LoopState;
+
 typedef struct {
     TokType type;
     TVal    value;
@@ -84,6 +91,14 @@ struct ComState {
     // Symbol for special 'this' identifier.
     SymT this;
     
+    // Names of the prelude functions recognized for counted loops.
+    SymT each;
+    SymT irange;
+    SymT drange;
+    
+    // Where we are in recognizing a counted loop.
+    LoopState loop;
+    
     // The name of the current function, set for single variable
     // definitions, and cleared if the right hand side isn't a
     // closure constructor.
@@ -1039,34 +1054,43 @@ parTupleEntry( State* state, void* udat ) {
     return true;
 }
 
-static bool
-parTuple( State* state ) {
+static void
+finTuple( State* state, TupDat* dat ) {
     ComState* com = state->comState;
     
-    TupDat dat = { .size = 0, .rexp = false };
+    if( dat->size > IN_OPR_MAX )
+        errLimit( state, "tuple entry count" );
+    if( !dat->rexp && dat->size != 1 )
+        genInstr( state, OPC_MAKE_TUP, dat->size );
+    else
+    if( dat->rexp )
+        genInstr( state, OPC_MAKE_VTUP, dat->size );
+    
+    com->popc = dat->size;
+}
+
+static bool
+parTupleDat( State* state, TupDat* dat ) {
     bool r = parSequence(
         state,
         '(', ')',
         "tuple",
         ")",
-        &dat, parTupleEntry
+        dat, parTupleEntry
     );
     if( !r )
         return false;
     
-    
-    if( dat.size > IN_OPR_MAX )
-        errLimit( state, "tuple entry count" );
-    if( !dat.rexp && dat.size != 1 )
-        genInstr( state, OPC_MAKE_TUP, dat.size );
-    else
-    if( dat.rexp )
-        genInstr( state, OPC_MAKE_VTUP, dat.size );
-    
-    com->popc = dat.size;
+    finTuple( state, dat );
     return true;
 }
 
+static bool
+parTuple( State* state ) {
+    TupDat dat = { .size = 0, .rexp = false };
+    return parTupleDat( state, &dat );
+}
+
 static bool
 parPrim( State* state, bool tail );
 
@@ -1532,11 +1556,152 @@ typedef struct {
     bool tail;
 } OperDat;
 
+static void
+genCall( State* state, bool tail ) {
+    genInstr( state, OPC_CALL, 0 );
+    
+    // Tail call?  We can only be sure if both
+    // the `tail` flag is set and the next token
+    // is a delimiter, and thus not another operator.
+    if( tail && state->comState->tok.type == TOK_DELIM )
+        genInstr( state, OPC_RETURN, 0 );
+}
+
+static void
+genLoop( State* state ) {
+    ComState* com = state->comState;
+    
+    genOpenLblScope( state, com->gen );
+    
+    SymT    nextSym = symGet( state, "$n", 2 );
+    GenLbl* nextLbl = genLbl( state, nextSym );
+    SymT    callSym = symGet( state, "$c", 2 );
+    GenLbl* callLbl = genLbl( state, callSym );
+    SymT    exitSym = symGet( state, "$e", 2 );
+    GenLbl* exitLbl = genLbl( state, exitSym );
+    
+    // LOOP_INIT checks that the functions being called are
+    // those from the prelude, if so it replaces the values
+    // on the stack with the loop's state; otherwise it
+    // jumps to the normal calls.
+    genInstr( state, OPC_LOOP_INIT, callLbl->which );
+    
+    // LOOP_NEXT pushes the closure and the next value for
+    // each iteration, or the empty tuple `each()` returns
+    // and jumps out when the range is done.
+    uint place = genGetPlace( state, com->gen );
+    genMovLbl( state, com->gen, nextLbl, place );
+    genInstr( state, OPC_LOOP_NEXT, exitLbl->which );
+    genInstr( state, OPC_CALL, 0 );
+    genInstr( state, OPC_POP, 0 );
+    genInstr( state, OPC_JUMP, nextLbl->which );
+    
+    // The normal calls, the range constructor's is made first
+    // with the closure held beneath it, then `each()`.
+    place = genGetPlace( state, com->gen );
+    genMovLbl( state, com->gen, callLbl, place );
+    genInstr( state, OPC_LOOP_SINK, 0 );
+    genInstr( state, OPC_CALL, 0 );
+    genInstr( state, OPC_LOOP_SWAP, 0 );
+    genInstr( state, OPC_MAKE_TUP, 2 );
+    genInstr( state, OPC_CALL, 0 );
+    
+    place = genGetPlace( state, com->gen );
+    genMovLbl( state, com->gen, exitLbl, place );
+    
+    genCloseLblScope( state, com->gen );
+}
+
+// Since `each()`, `irange()`, and `drange()` are just globals
+// we can't know which functions they'll refer to at runtime;
+// so for calls of the form `each( irange( a, b ), [ i ] ... )`
+// we instead delay the call to the range constructor until the
+// body's closure has been made, then emit a LOOP_INIT to check
+// the functions at runtime.  If they're the prelude's then the
+// loop runs in the current frame, without making an iterator
+// or going through `each()`, otherwise the calls are made in the
+// usual order.  Making the closure is the only thing moved ahead
+// of the range constructor's call, and it has no visible effects.
+//
+// Returns true if the loop was emitted, otherwise the argument
+// tuple has been emitted and it's up to the caller to make the
+// call to `each()`.
+static bool
+parLoop( State* state ) {
+    ComState* com = state->comState;
+    
+    // Skip opening parenthesis and delimiters.
+    lex( state );
+    parDelim( state );
+    
+    TupDat dat = { .size = 0, .rexp = false };
+    
+    // If the first argument is a call to one of the range
+    // constructors then parSecondary() will leave the call
+    // to us, setting `com->loop` to LOOP_DEFER.
+    bool defer = false;
+    if( com->tok.type != ')' ) {
+        if( com->tok.type == TOK_IDENT ) {
+            SymT name = tvGetSym( com->tok.value );
+            if( name == com->irange || name == com->drange )
+                com->loop = LOOP_RANGE;
+        }
+        parTupleEntry( state, &dat );
+        defer = com->loop == LOOP_DEFER;
+        com->loop = LOOP_NONE;
+        
+        if( com->tok.type != ')' && !parDelim( state ) )
+            errPar( state, "Missing ')'" );
+    }
+    
+    // A closure literal as the second and last argument makes
+    // this a loop.  If there are more arguments then we still
+    // have to make the delayed call.
+    if( defer && com->tok.type == '[' ) {
+        parTupleEntry( state, &dat );
+        if( com->tok.type != ')' && !parDelim( state ) )
+            errPar( state, "Missing ')'" );
+        
+        if( com->tok.type == ')' ) {
+            lex( state );
+            genLoop( state );
+            
+            com->popc = 0;
+            return true;
+        }
+        
+        genInstr( state, OPC_LOOP_SINK, 0 );
+        genInstr( state, OPC_CALL, 0 );
+        genInstr( state, OPC_LOOP_SWAP, 0 );
+    }
+    else
+    if( defer ) {
+        genInstr( state, OPC_CALL, 0 );
+    }
+    
+    // Anything else is parsed as a normal tuple.
+    while( com->tok.type != ')' ) {
+        parTupleEntry( state, &dat );
+        if( com->tok.type != ')' && !parDelim( state ) )
+            errPar( state, "Missing ')'" );
+    }
+    lex( state );
+    
+    finTuple( state, &dat );
+    return false;
+}
+
 static bool
 parSecondary( State* state, void* udat ) {
     ComState* com = state->comState;
     OperDat*  dat = udat;
     
+    // Check if the primary might be the `each()` or range
+    // constructor of a counted loop, see `parLoop()`.
+    bool each  = com->tok.type == TOK_IDENT && tvGetSym( com->tok.value ) == com->each;
+    bool range = com->loop == LOOP_RANGE;
+    com->loop = LOOP_NONE;
+    
     // It's safe to pass `true` to indicate a tailcall
     // here since the only primary expressions that'll
     // be effected `do-for`, `if-else`, and `when-in`
@@ -1566,19 +1731,34 @@ parSecondary( State* state, void* udat ) {
             lex( state );
         }
         else
-        if( parPrim( state, false ) ) {
-            genInstr( state, OPC_CALL, 0 );
-
+        if( each && com->tok.type == '(' ) {
+            if( !parLoop( state ) )
+                genCall( state, dat->tail );
+        }
+        else
+        if( range && com->tok.type == '(' ) {
+            TupDat args = { .size = 0, .rexp = false };
+            parTupleDat( state, &args );
             
-            // Tail call?  We can only be sure if both
-            // the `tail` flag is set and the next token
-            // is a delimiter, and thus not another operator.
-            if( dat->tail && state->comState->tok.type == TOK_DELIM )
-                genInstr( state, OPC_RETURN, 0 );
+            // If the call makes up the whole of the loop's first
+            // argument then leave it to `parLoop()`.
+            bool last = com->tok.type == TOK_DELIM || com->tok.type == ')';
+            if( args.size == 2 && !args.rexp && last ) {
+                com->loop = LOOP_DEFER;
+                break;
+            }
+            genCall( state, dat->tail );
+        }
+        else
+        if( parPrim( state, false ) ) {
+            genCall( state, dat->tail );
         }
         else {
             break;
         }
+        
+        each  = false;
+        range = false;
     }
     
     state->comState->popc = 0;
@@ -2201,6 +2381,9 @@ comScan( State* state, Scanner* scan ) {
     
     if( state->gcFull ) {
         symMark( state, com->this );
+        symMark( state, com->each );
+        symMark( state, com->irange );
+        symMark( state, com->drange );
         tvMark( com->func );
     }
 }
@@ -2218,6 +2401,10 @@ comInit( State* state ) {
     com->val1      = tvUdf();
     com->val2      = tvUdf();
     com->this      = symGet( state, "this", 4 );
+    com->each      = symGet( state, "each", 4 );
+    com->irange    = symGet( state, "irange", 6 );
+    com->drange    = symGet( state, "drange", 6 );
+    com->loop      = LOOP_NONE;
     com->func      = tvUdf();
     com->tok.value = tvUdf();
     
@@ -2242,6 +2429,7 @@ comCompile( State* state, ComParams* p ) {
     com->val1    = tvUdf();
     com->val2    = tvUdf();
     com->popc    = 0;
+    com->loop    = LOOP_NONE;
     com->tok.value = tvUdf();
     
     com->gen = genMake( state, NULL, NULL, p->global, p->debug );
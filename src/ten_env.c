@@ -5,6 +5,7 @@
 #include "ten_ntab.h"
 #include "ten_sym.h"
 #include "ten_ptr.h"
+#include "ten_upv.h"
 #include <string.h>
 #include <limits.h>
 
@@ -136,6 +137,12 @@ envGetGlobalByName( State* state, SymT name ) {
     return &env->gVals.buf[loc];
 }
 
+uint
+envFindGlobal( State* state, SymT name ) {
+    EnvState* env = state->envState;
+    return ntabGet( state, env->gNames, name );
+}
+
 TVal*
 envGetGlobalByLoc( State* state, uint loc ) {
     EnvState* env = state->envState;
@@ -144,3 +151,39 @@ envGetGlobalByLoc( State* state, uint loc ) {
     else
         return &env->gVals.buf[loc];
 }
+
+TVal
+envGetGlobalVal( State* state, uint loc ) {
+    EnvState* env = state->envState;
+    tenAssert( loc < env->gVals.top );
+    
+    TVal val = env->gVals.buf[loc];
+    if( tvIsObjType( val, OBJ_UPV ) )
+        return ((Upvalue*)tvGetObj( val ))->val;
+    else
+        return val;
+}
+
+void
+envSetGlobalVal( State* state, uint loc, TVal val ) {
+    EnvState* env = state->envState;
+    tenAssert( loc < env->gVals.top );
+    
+    TVal* ptr = &env->gVals.buf[loc];
+    if( tvIsObjType( *ptr, OBJ_UPV ) )
+        ((Upvalue*)tvGetObj( *ptr ))->val = val;
+    else
+        *ptr = val;
+}
+
+uint
+envNumGlobals( State* state ) {
+    EnvState* env = state->envState;
+    return env->gVals.top;
+}
+
+void
+envForEachGlobal( State* state, void* udat, ProcNameCb proc ) {
+    EnvState* env = state->envState;
+    ntabForEach( state, env->gNames, udat, proc );
+}
@@ -7,6 +7,7 @@ fibers are running.
 #ifndef ten_env_h
 #define ten_env_h
 #include "ten_types.h"
+#include "ten_ntab.h"
 
 // Initialize the component.
 void
@@ -29,7 +30,26 @@ envAddGlobal( State* state, SymT name );
 TVal*
 envGetGlobalByName( State* state, SymT name );
 
+// Location of the named global, or UINT_MAX if there isn't one.
+uint
+envFindGlobal( State* state, SymT name );
+
 TVal*
 envGetGlobalByLoc( State* state, uint loc );
 
+// Get and set a global's value, looking through the Upvalue
+// it's moved into once a closure captures it.
+TVal
+envGetGlobalVal( State* state, uint loc );
+
+void
+envSetGlobalVal( State* state, uint loc, TVal val );
+
+// Enumerate the global variables, in no particular order.
+uint
+envNumGlobals( State* state );
+
+void
+envForEachGlobal( State* state, void* udat, ProcNameCb proc );
+
 #endif
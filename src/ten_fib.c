@@ -13,6 +13,7 @@
 #include "ten_macros.h"
 #include "ten_cls.h"
 #include "ten_fun.h"
+#include "ten_lib.h"
 #include "ten_math.h"
 #include <string.h>
 #include <limits.h>
@@ -30,6 +31,9 @@ contNext( State* state, Fiber* fib, Tup* args );
 static void
 doCall( State* state, Fiber* fib );
 
+static void
+enterCall( State* state, Fiber* fib, Closure* cls, TVal* argv, uint argc );
+
 static void
 doLoop( State* state, Fiber* fib );
 
@@ -366,6 +370,54 @@ fibCall_( State* state, Closure* cls, Tup* args, char const* file, uint line ) {
     return fibTop( state, fib );
 }
 
+Tup
+fibPushCall( State* state, Closure* cls, uint argc ) {
+    Fiber* fib = state->fiber;
+    tenAssert( fib );
+    
+    Tup cit = fibPush( state, fib, 1 );
+    tupSet( cit, 0, tvObj( cls ) );
+    
+    return fibPush( state, fib, argc );
+}
+
+Tup
+fibCallPushed_( State* state, uint argc, char const* file, uint line ) {
+    Fiber* fib  = state->fiber;
+    Regs*  regs = fib->rptr;
+    tenAssert( fib );
+    
+    TVal* argv = regs->sp - argc - ( argc != 1 ) - 1;
+    tenAssert( tvIsObjType( argv[0], OBJ_CLS ) );
+    
+    Closure* cls = tvGetObj( argv[0] );
+    tenAssert( argc >= cls->fun->nParams );
+    
+    NatAR nat = { .file = file, .line = line };
+    fib->push( state, fib, &nat );
+    
+    // Variadic functions still need their argument record
+    // built, but otherwise the arguments are already where
+    // the call frame needs them, so only the tuple header
+    // has to go.
+    if( cls->fun->vargIdx ) {
+        doCall( state, fib );
+    }
+    else {
+        tenAssert( argc == cls->fun->nParams );
+        for( uint i = 1 ; i <= argc ; i++ )
+            if( tvIsUdf( argv[i] ) )
+                errUdfAsArg( state, cls->fun, i );
+        
+        if( argc != 1 )
+            regs->sp--;
+        enterCall( state, fib, cls, argv, argc );
+    }
+    fib->pop( state, fib );
+    
+    return fibTop( state, fib );
+}
+
 void
 fibClearError( State* state, Fiber* fib ) {
     if( fib->errNum == ten_ERR_NONE )
@@ -596,6 +648,16 @@ doCall( State* state, Fiber* fib ) {
             errTooManyArgs( state, cls->fun, argc );
     }
     
+    enterCall( state, fib, cls, argv, argc );
+}
+
+// Run the call to `cls` with the `argc` arguments following
+// it at `argv`, which have already been checked against its
+// parameters.
+static void
+enterCall( State* state, Fiber* fib, Closure* cls, TVal* argv, uint argc ) {
+    Regs* regs = fib->rptr;
+    
     regs->lcl = argv;
     regs->cls = cls;
     if( cls->fun->type == FUN_VIR ) {
@@ -621,6 +683,12 @@ doCall( State* state, Fiber* fib ) {
             dstv[i] = retv[i];
         regs->sp = dstv + retc;
     }
+    else
+    if( cls->fun->u.nat.fast ) {
+        TVal ret = cls->fun->u.nat.fast( state, argv + 1 );
+        regs->sp  = regs->lcl + 1;
+        regs->lcl[0] = ret;
+    }
     else {
         
         regs->ip         = NULL;
@@ -1112,6 +1180,20 @@ doLoop( State* state, Fiber* fib ) {
             ushort const opr = inGetOpr( in );
             #include "inc/ops/JUMP.inc"
         BREAK;
+        CASE(LOOP_INIT)
+            ushort const opr = inGetOpr( in );
+            #include "inc/ops/LOOP_INIT.inc"
+        BREAK;
+        CASE(LOOP_NEXT)
+            ushort const opr = inGetOpr( in );
+            #include "inc/ops/LOOP_NEXT.inc"
+        BREAK;
+        CASE(LOOP_SINK)
+            #include "inc/ops/LOOP_SINK.inc"
+        BREAK;
+        CASE(LOOP_SWAP)
+            #include "inc/ops/LOOP_SWAP.inc"
+        BREAK;
         CASE(CALL)
             #include "inc/ops/CALL.inc"
         BREAK;
@@ -1560,6 +1642,11 @@ onError( State* state, Defer* defer ) {
 
     state->fiber->rbuf  = *state->fiber->rptr;
     state->fiber->rptr  = &state->fiber->rbuf;
+    
+    // A failed fiber can't be continued, so drop whatever's
+    // left on its stack; otherwise it would keep the values
+    // reachable for as long as the fiber itself is.
+    fib->rptr->sp = fib->stack.buf;
 }
 
 static void
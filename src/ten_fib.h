@@ -162,6 +162,20 @@ fibCont( State* state, Fiber* fib, Tup* args );
 Tup
 fibCall_( State* state, Closure* cls, Tup* args, char const* file, uint line );
 
+// Prepared calls push the Closure and argument slots first,
+// then make the call once the arguments are filled in, without
+// copying them to a new frame.  The Closure must take `argc`
+// arguments, or at least that many if it's variadic; it's up
+// to the caller to check this beforehand.
+Tup
+fibPushCall( State* state, Closure* cls, uint argc );
+
+#define fibCallPushed( STATE, ARGC ) \
+    fibCallPushed_( STATE, ARGC, __FILE__, __LINE__ )
+
+Tup
+fibCallPushed_( State* state, uint argc, char const* file, uint line );
+
 void
 fibYield( State* state, Tup* vals, bool pop );
 
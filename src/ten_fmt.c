@@ -12,6 +12,7 @@
 #include "ten_macros.h"
 #include "ten_math.h"
 #include <string.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <ctype.h>
 
@@ -69,6 +70,8 @@ fmtA( State* state, bool append, char const* fmt, ... ) {
 static void
 fmtStdV( State* state, char const* fmt, va_list ap ) {
     FmtState* fmtState = state->fmtState;
+    if( fmt[0] == '\0' )
+        return;
     
     // Figure out how much room it'll take to format the segment.
     va_list ac;
@@ -233,8 +236,8 @@ static void
 fmtStr( State* state, String* str, bool q ) {
     FmtState* fmtState = state->fmtState;
     
-    size_t      len = strLen( state, str );
-    char const* buf = strBuf( state, str );
+    size_t      len = str->len;
+    char const* buf = str->buf;
     
     bool alt = false;
     if( q ) {
@@ -376,29 +379,318 @@ fmtObj( State* state, void* obj, bool q ) {
     }
 }
 
+// Decimals are formatted with Grisu2, from Florian Loitsch's
+// "Printing Floating-Point Numbers Quickly and Accurately with
+// Integers".  It picks the shortest digit string within the
+// rounding interval of the double, give or take a digit in rare
+// cases, so the output always reads back as the same double.
+// The value is scaled by a cached power of ten to bring it into
+// a range where the digits can be found with 64-bit integers.
+typedef struct {
+    uint64_t f;
+    int      e;
+} DiyFp;
+
+#define DP_HIDDEN_BIT (0x0010000000000000ull)
+#define DP_SIG_MASK   (0x000FFFFFFFFFFFFFull)
+#define DP_SIG_SIZE   (52)
+
+// Normalized powers of ten from 10^-348 to 10^340 in steps of 8,
+// `powF[i]*2^powE[i]` is `10^(8*i - 348)`, rounded.
+static uint64_t const powF[] = {
+    0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull,
+    0xcf42894a5dce35eaull, 0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull,
+    0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full, 0xbe5691ef416bd60cull,
+    0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+    0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull,
+    0xc21094364dfb5637ull, 0x9096ea6f3848984full, 0xd77485cb25823ac7ull,
+    0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull, 0xb23867fb2a35b28eull,
+    0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+    0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull,
+    0xb5b5ada8aaff80b8ull, 0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull,
+    0x964e858c91ba2655ull, 0xdff9772470297ebdull, 0xa6dfbd9fb8e5b88full,
+    0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+    0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull,
+    0xaa242499697392d3ull, 0xfd87b5f28300ca0eull, 0xbce5086492111aebull,
+    0x8cbccc096f5088ccull, 0xd1b71758e219652cull, 0x9c40000000000000ull,
+    0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+    0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull,
+    0x9f4f2726179a2245ull, 0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull,
+    0x83c7088e1aab65dbull, 0xc45d1df942711d9aull, 0x924d692ca61be758ull,
+    0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+    0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull,
+    0x952ab45cfa97a0b3ull, 0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull,
+    0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull, 0x88fcf317f22241e2ull,
+    0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+    0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull,
+    0x8bab8eefb6409c1aull, 0xd01fef10a657842cull, 0x9b10a4e5e9913129ull,
+    0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull, 0x80444b5e7aa7cf85ull,
+    0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+    0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull
+};
+
+static short const powE[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066
+};
+
+static uint64_t const pow10Tab[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+    10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+    100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull,
+    10000000000000000000ull
+};
+
+static DiyFp
+diyMul( DiyFp x, DiyFp y ) {
+    uint64_t const m32 = 0xFFFFFFFFull;
+    
+    uint64_t a = x.f >> 32, b = x.f & m32;
+    uint64_t c = y.f >> 32, d = y.f & m32;
+    uint64_t ac = a*c, bc = b*c, ad = a*d, bd = b*d;
+    
+    uint64_t tmp = ( bd >> 32 ) + ( ad & m32 ) + ( bc & m32 );
+    tmp += 1ull << 31;
+    return (DiyFp){ ac + ( ad >> 32 ) + ( bc >> 32 ) + ( tmp >> 32 ), x.e + y.e + 64 };
+}
+
+static DiyFp
+diyNormalize( DiyFp x ) {
+    while( !( x.f & ( 1ull << 63 ) ) ) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+// Find the normalized boundaries of the rounding interval of
+// `v`, halfway to its neighbors.  The lower one is closer when
+// `v` is a power of two, since the exponent changes below it.
+static void
+diyBoundaries( DiyFp v, DiyFp* minus, DiyFp* plus ) {
+    DiyFp pl = { ( v.f << 1 ) + 1, v.e - 1 };
+    while( !( pl.f & ( DP_HIDDEN_BIT << 1 ) ) ) {
+        pl.f <<= 1;
+        pl.e--;
+    }
+    pl.f <<= 64 - DP_SIG_SIZE - 2;
+    pl.e  -= 64 - DP_SIG_SIZE - 2;
+    
+    DiyFp mi;
+    if( v.f == DP_HIDDEN_BIT )
+        mi = (DiyFp){ ( v.f << 2 ) - 1, v.e - 2 };
+    else
+        mi = (DiyFp){ ( v.f << 1 ) - 1, v.e - 1 };
+    mi.f <<= mi.e - pl.e;
+    mi.e   = pl.e;
+    
+    *plus  = pl;
+    *minus = mi;
+}
+
+// Get a cached power of ten `c` such that multiplying by it
+// brings a number with binary exponent `e` to an exponent in
+// [-60, -32]; `*k` is set to the negated decimal exponent.
+static DiyFp
+cachedPow( int e, int* k ) {
+    double dk = ( -61 - e )*0.30102999566398114 + 347;
+    int    ik = (int)dk;
+    if( dk - ik > 0.0 )
+        ik++;
+    
+    uint i = ( ik >> 3 ) + 1;
+    *k = -( -348 + (int)i*8 );
+    return (DiyFp){ powF[i], powE[i] };
+}
+
+static uint
+countDigits( uint32_t n ) {
+    uint c = 1;
+    while( n >= 10 ) {
+        n /= 10;
+        c++;
+    }
+    return c;
+}
+
+// Nudge the last digit down while that brings the result closer
+// to the exact value without leaving the rounding interval.
+static void
+grisuRound( char* buf, int len, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t wpw ) {
+    while(
+        rest < wpw && delta - rest >= tenKappa &&
+        ( rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw )
+    ) {
+        buf[len - 1]--;
+        rest += tenKappa;
+    }
+}
+
+static void
+grisuDigits( DiyFp w, DiyFp mp, uint64_t delta, char* buf, int* len, int* k ) {
+    DiyFp    one = { 1ull << -mp.e, mp.e };
+    uint64_t wpw = mp.f - w.f;
+    uint32_t p1  = (uint32_t)( mp.f >> -one.e );
+    uint64_t p2  = mp.f & ( one.f - 1 );
+    
+    // Integral part.
+    int kappa = countDigits( p1 );
+    *len = 0;
+    while( kappa > 0 ) {
+        uint32_t div = (uint32_t)pow10Tab[kappa - 1];
+        uint32_t d   = p1 / div;
+        p1 %= div;
+        if( d || *len )
+            buf[(*len)++] = '0' + d;
+        kappa--;
+        
+        uint64_t rest = ( (uint64_t)p1 << -one.e ) + p2;
+        if( rest <= delta ) {
+            *k += kappa;
+            grisuRound( buf, *len, delta, rest, pow10Tab[kappa] << -one.e, wpw );
+            return;
+        }
+    }
+    
+    // Fractional part.
+    for( ;; ) {
+        p2    *= 10;
+        delta *= 10;
+        char d = (char)( p2 >> -one.e );
+        if( d || *len )
+            buf[(*len)++] = '0' + d;
+        p2 &= one.f - 1;
+        kappa--;
+        if( p2 < delta ) {
+            *k += kappa;
+            uint64_t scale = -kappa < 20 ? pow10Tab[-kappa] : 0;
+            grisuRound( buf, *len, delta, p2, one.f, wpw*scale );
+            return;
+        }
+    }
+}
+
+int
+fmtDigits( double d, char* buf, int* k ) {
+    uint64_t u;
+    memcpy( &u, &d, sizeof(u) );
+    
+    int   be = (int)( ( u >> DP_SIG_SIZE ) & 0x7FF );
+    DiyFp v;
+    if( be ) {
+        v.f = ( u & DP_SIG_MASK ) + DP_HIDDEN_BIT;
+        v.e = be - 1075;
+    }
+    else {
+        v.f = u & DP_SIG_MASK;
+        v.e = -1074;
+    }
+    
+    DiyFp wm, wp;
+    diyBoundaries( v, &wm, &wp );
+    
+    DiyFp c  = cachedPow( wp.e, k );
+    DiyFp w  = diyMul( diyNormalize( v ), c );
+    DiyFp mp = diyMul( wp, c );
+    DiyFp mm = diyMul( wm, c );
+    mm.f++;
+    mp.f--;
+    
+    int len;
+    grisuDigits( w, mp, mp.f - mm.f, buf, &len, k );
+    return len;
+}
+
+// Longest possible output of `fmtDec()`, the fixed notation
+// of the smallest subnormal plus a sign.
+#define DEC_MAX (352)
+
 static void
 fmtDec( State* state, DecT d ) {
+    FmtState* fmtState = state->fmtState;
+    
     if( !isfinite( d ) ) {
         fmtStdA( state, "%f", (double)d );
         return;
     }
     
-    if( d*100000.0 > trunc( d*100000.0 ) )
-        fmtStdA( state, "%.17f", (double)d );
-    else
-    if( d*10000.0 > trunc( d*10000.0 ) )
-        fmtStdA( state, "%.5f", (double)d );
-    else
-    if( d*1000.0 > trunc( d*1000.0 ) )
-        fmtStdA( state, "%.4f", (double)d );
-    else
-    if( d*100.0 > trunc( d*100.0 ) )
-        fmtStdA( state, "%.3f", (double)d );
-    else
-    if( d*10.0 > trunc( d*10.0 ) )
-        fmtStdA( state, "%.2f", (double)d );
+    ensureCharBuf( state, &fmtState->buf, DEC_MAX );
+    char* dst = fmtState->buf.buf + fmtState->buf.top;
+    char* c   = dst;
+    
+    if( signbit( d ) ) {
+        *c++ = '-';
+        d = -d;
+    }
+    if( d == 0.0 ) {
+        memcpy( c, "0.0", 3 );
+        fmtState->buf.top += c + 3 - dst;
+        return;
+    }
+    
+    // Decimals are always shown in fixed notation, with at least
+    // one digit after the point, since that's what the lexer and
+    // `dec()` accept.
+    char digits[20];
+    int  k;
+    int  n  = fmtDigits( d, digits, &k );
+    int  pt = n + k;
+    if( pt <= 0 ) {
+        *c++ = '0';
+        *c++ = '.';
+        memset( c, '0', -pt );
+        c += -pt;
+        memcpy( c, digits, n );
+        c += n;
+    }
     else
-        fmtStdA( state, "%.1f", (double)d );
+    if( pt >= n ) {
+        memcpy( c, digits, n );
+        c += n;
+        memset( c, '0', pt - n );
+        c += pt - n;
+        *c++ = '.';
+        *c++ = '0';
+    }
+    else {
+        memcpy( c, digits, pt );
+        c += pt;
+        *c++ = '.';
+        memcpy( c, digits + pt, n - pt );
+        c += n - pt;
+    }
+    fmtState->buf.top += c - dst;
+}
+
+static void
+fmtInt( State* state, IntT i ) {
+    FmtState* fmtState = state->fmtState;
+    
+    // Digits are found from the right, so fill a scratch
+    // buffer backwards.
+    char  tmp[12];
+    char* c = tmp + sizeof(tmp);
+    
+    uint32_t u = i < 0 ? -(uint32_t)i : (uint32_t)i;
+    do {
+        *--c = '0' + u % 10;
+        u /= 10;
+    } while( u );
+    if( i < 0 )
+        *--c = '-';
+    
+    size_t len = tmp + sizeof(tmp) - c;
+    ensureCharBuf( state, &fmtState->buf, len );
+    memcpy( fmtState->buf.buf + fmtState->buf.top, c, len );
+    fmtState->buf.top += len;
 }
 
 static void
@@ -423,7 +715,7 @@ fmtVal( State* state, TVal val, bool q ) {
     }
     else
     if( tvIsInt( val ) )
-        fmtStdA( state, "%lli", (llong)tvGetInt( val ) );
+        fmtInt( state, tvGetInt( val ) );
     else
     if( tvIsDec( val ) )
         fmtDec( state, tvGetDec( val ) );
@@ -450,6 +742,19 @@ fmtV( State* state, bool append, char const* fmt, va_list ap ) {
         fmtState->buf.top--;
     else
         fmtState->buf.top = 0;
+    
+    // A lone `%v` or `%q` is by far the most common format,
+    // used to stringify values; so skip the setup for those.
+    if( fmt[0] == '%' && ( fmt[1] == 'v' || fmt[1] == 'q' ) && fmt[2] == '\0' ) {
+        bool q = fmt[1] == 'q';
+        if( fmtState->mode == FMT_VALS )
+            fmtVal( state, va_arg( ap, TVal ), q );
+        else
+            fmtVar( state, va_arg( ap, ten_Var* ), q );
+        
+        *putCharBuf( state, &fmtState->buf ) = '\0';
+        return fmtState->buf.buf;
+    }
         
     // Copy the format string so we can insert '\0'
     // take efficient substrings of the format.
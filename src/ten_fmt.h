@@ -43,4 +43,10 @@ fmtLen( State* state );
 char const*
 fmtBuf( State* state );
 
+// Put the shortest digits that read back as the positive, finite
+// `d` in `buf`, which needs room for 17, such that the value is
+// `buf*10^k`; returns the number of digits.
+int
+fmtDigits( double d, char* buf, int* k );
+
 #endif
@@ -47,8 +47,18 @@ typedef struct {
     DbgInfo* dbg;
 } VirFun;
 
+// Natives with a fixed number of parameters and a single
+// result can also provide a `fast` callback, which takes its
+// arguments in place on the stack and returns the result
+// directly, so the interpreter can call it without setting up
+// a frame or a `ten_Call`.  These mustn't yield or call back
+// into Ten, and should read their arguments before doing
+// anything that might grow the stack.
+typedef TVal (*FastCb)( State* state, TVal* args );
+
 typedef struct {
     ten_FunCb cb;
+    FastCb    fast;
     SymT      name;
     SymT*     params;
 } NatFun;
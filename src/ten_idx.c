@@ -5,6 +5,7 @@
 #include "ten_macros.h"
 #include "ten_sym.h"
 #include "ten_ptr.h"
+#include "ten_str.h"
 #include <string.h>
 #include <limits.h>
 
@@ -18,7 +19,7 @@ static void
 growRefs( State* state, Index* idx );
 
 static uint
-find( TVal* keys, uint cap, uint* steps, TVal key );
+find( State* state, TVal* keys, uint cap, uint* steps, TVal key );
 
 
 void
@@ -119,7 +120,7 @@ idxSub( State* state, Index* idx, uint top ) {
             continue;
         
         uint s = 0;
-        uint j = find( keys, mcap, &s, idx->map.keys[i] );
+        uint j = find( state, keys, mcap, &s, idx->map.keys[i] );
         tenAssert( s < mcap );
         
         keys[j] = idx->map.keys[i];
@@ -149,7 +150,7 @@ idxAddByKey( State* state, Index* idx, TVal key ) {
     // Find a slot for the key, this puts the number
     // of steps from the key's ideal location in `s`.
     uint s = 0;
-    uint i = find( idx->map.keys, idx->map.cap, &s, key );
+    uint i = find( state, idx->map.keys, idx->map.cap, &s, key );
     tenAssert( i < idx->map.cap );
     
     // If an entry for the key doesn't exist then add one.
@@ -199,7 +200,7 @@ uint
 idxGetByKey( State* state, Index* idx, TVal key ) {
     // Find the key's map slot, this'll only try stepLimit
     // steps beyond the key's ideal location.
-    uint i = find( idx->map.keys, idx->map.cap, &idx->stepLimit, key );
+    uint i = find( state, idx->map.keys, idx->map.cap, &idx->stepLimit, key );
     if( i == UINT_MAX )
         return UINT_MAX;
     
@@ -210,7 +211,7 @@ void
 idxRemByKey( State* state, Index* idx, TVal key ) {
     // Find the key's map slot, this'll only try stepLimit
     // steps beyond the key's ideal location.
-    uint i = find( idx->map.keys, idx->map.cap, &idx->stepLimit, key );
+    uint i = find( state, idx->map.keys, idx->map.cap, &idx->stepLimit, key );
     if( i == UINT_MAX )
         return;
     
@@ -301,7 +302,7 @@ growMap( State* state, Index* idx, bool clean ) {
         
         // Figure out where to put the key in the new allocations.
         uint s = 0;
-        uint j = find( keys, mcap, &s, idx->map.keys[i] );
+        uint j = find( state, keys, mcap, &s, idx->map.keys[i] );
         if( s > steps )
             steps = s;
         
@@ -319,7 +320,7 @@ growMap( State* state, Index* idx, bool clean ) {
             continue;
         
         uint s = 0;
-        uint j = find( keys, mcap, &s, idx->map.keys[i] );
+        uint j = find( state, keys, mcap, &s, idx->map.keys[i] );
         
         if( !clean )
             keys[j] = idx->map.keys[i];
@@ -357,15 +358,34 @@ growRefs( State* state, Index* idx ) {
     idx->refs.buf = buf;
 }
 
+// Strings are keyed by their contents, so parsed input can be
+// used as a key without interning it as a symbol; other values
+// are keyed by identity.
+static inline uint
+keyHash( State* state, TVal key ) {
+    if( tvIsObjType( key, OBJ_STR ) )
+        return strHash( state, (String*)tvGetObj( key ) );
+    return tvHash( key );
+}
+
+static inline bool
+keyEqual( State* state, TVal key1, TVal key2 ) {
+    if( tvEqual( key1, key2 ) )
+        return true;
+    if( tvIsObjType( key1, OBJ_STR ) && tvIsObjType( key2, OBJ_STR ) )
+        return strEqual( state, tvGetObj( key1 ), tvGetObj( key2 ) );
+    return false;
+}
+
 static uint
-find( TVal* keys, uint cap, uint* steps, TVal key ) {
-    uint hash = tvHash( key );
+find( State* state, TVal* keys, uint cap, uint* steps, TVal key ) {
+    uint hash = keyHash( state, key );
     uint lim  = *steps > 0 ? *steps : cap;
     
     register uint s = 0;
     register uint i = hash % cap;
     while( s++ < lim ) {
-        if( tvIsUdf( keys[i] ) || tvEqual( keys[i], key ) ) {
+        if( tvIsUdf( keys[i] ) || keyEqual( state, keys[i], key ) ) {
             if( *steps == 0 )
                 *steps = s;
             return i;
@@ -0,0 +1,1075 @@
+#include "ten_json.h"
+#include "ten_sym.h"
+#include "ten_str.h"
+#include "ten_fmt.h"
+#include "ten_idx.h"
+#include "ten_rec.h"
+#include "ten_ptr.h"
+#include "ten_fib.h"
+#include "ten_state.h"
+#include "ten_assert.h"
+#include "ten_macros.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include <math.h>
+
+#define BUF_TYPE char
+#define BUF_NAME CharBuf
+    #include "inc/buf.inc"
+#undef BUF_TYPE
+#undef BUF_NAME
+
+#define BUF_TYPE TVal
+#define BUF_NAME ValBuf
+    #include "inc/buf.inc"
+#undef BUF_TYPE
+#undef BUF_NAME
+
+typedef struct {
+    TVal key;
+    TVal val;
+    uint loc;
+} Entry;
+
+#define BUF_TYPE Entry
+#define BUF_NAME EntBuf
+    #include "inc/buf.inc"
+#undef BUF_TYPE
+#undef BUF_NAME
+
+// Nesting limit for both directions, this keeps the recursion
+// of the decoder and encoder from overflowing the C stack and
+// also catches cyclic records when encoding.
+#define JSON_DEPTH_MAX (512)
+
+
+// Decoders keep a small direct mapped cache of the key sets
+// they've seen, each with the Index built for them.  Every
+// object with a cached key set is created with the same Index,
+// and its values are put directly at the locators recorded
+// for each key.  Arrays are cached by length the same way,
+// with keys `0` through `n - 1` at locators of the same number.
+#define SHAPE_SLOTS (256)
+
+// Larger records can't be created directly on an Index of
+// their full size, so are defined one field at a time.
+#define SHAPE_MAX (USHRT_MAX - 1)
+
+typedef struct {
+    SymT key;
+    uint loc;
+} ShapeKey;
+
+typedef struct {
+    Index*    idx;
+    ShapeKey* keys;
+    uint      cap;
+    uint      hash;
+    uint      len;
+    bool      seq;
+} Shape;
+
+struct JsonShapes {
+    Scanner scan;
+    Shape   slots[SHAPE_SLOTS];
+};
+
+static void
+shapesScan( State* state, Scanner* scan ) {
+    JsonShapes* shapes = structFromScan( JsonShapes, scan );
+    for( uint i = 0 ; i < SHAPE_SLOTS ; i++ )
+        if( shapes->slots[i].idx )
+            stateMark( state, shapes->slots[i].idx );
+}
+
+JsonShapes*
+jsonShapesNew( State* state ) {
+    Part shapesP;
+    JsonShapes* shapes = stateAllocRaw( state, &shapesP, sizeof(JsonShapes) );
+    for( uint i = 0 ; i < SHAPE_SLOTS ; i++ )
+        shapes->slots[i] = (Shape){ .idx = NULL, .keys = NULL, .cap = 0 };
+    
+    shapes->scan.cb = shapesScan;
+    stateInstallScanner( state, &shapes->scan );
+    stateCommitRaw( state, &shapesP );
+    return shapes;
+}
+
+void
+jsonShapesFree( State* state, JsonShapes* shapes ) {
+    stateRemoveScanner( state, &shapes->scan );
+    for( uint i = 0 ; i < SHAPE_SLOTS ; i++ )
+        if( shapes->slots[i].keys )
+            stateFreeRaw( state, shapes->slots[i].keys, sizeof(ShapeKey)*shapes->slots[i].cap );
+    stateFreeRaw( state, shapes, sizeof(JsonShapes) );
+}
+
+// Clears the slot for a new shape, the Index it had (if any)
+// is still kept alive by the records made with it.
+static void
+shapeReset( State* state, Shape* sh, uint hash, uint n, bool seq ) {
+    if( sh->keys && sh->cap < n ) {
+        stateFreeRaw( state, sh->keys, sizeof(ShapeKey)*sh->cap );
+        sh->keys = NULL;
+        sh->cap  = 0;
+    }
+    sh->idx  = NULL;
+    sh->hash = hash;
+    sh->len  = UINT_MAX;
+    sh->seq  = seq;
+    
+    if( !seq && !sh->keys && n > 0 ) {
+        Part keysP;
+        sh->keys = stateAllocRaw( state, &keysP, sizeof(ShapeKey)*n );
+        sh->cap  = n;
+        stateCommitRaw( state, &keysP );
+    }
+    sh->idx = idxNew( state );
+}
+
+typedef struct {
+    Defer   base;
+    Scanner scan;
+    
+    char const* buf;
+    char const* cur;
+    char const* end;
+    uint        depth;
+    
+    ValBuf      vals;
+    CharBuf     text;
+    JsonShapes* shapes;
+    bool        owner;
+} Decoder;
+
+static void
+decScan( State* state, Scanner* scan ) {
+    Decoder* d = structFromScan( Decoder, scan );
+    
+    for( uint i = 0 ; i < d->vals.top ; i++ )
+        tvMark( d->vals.buf[i] );
+}
+
+static void
+decDefer( State* state, Defer* defer ) {
+    Decoder* d = (Decoder*)defer;
+    stateRemoveScanner( state, &d->scan );
+    finlValBuf( state, &d->vals );
+    finlCharBuf( state, &d->text );
+    if( d->owner && d->shapes )
+        jsonShapesFree( state, d->shapes );
+}
+
+#define decFail( D, MSG ) \
+    panic( MSG " at byte %u of JSON input", (uint)((D)->cur - (D)->buf) )
+
+static void
+decValue( State* state, Decoder* d );
+
+static void
+skipWs( Decoder* d ) {
+    char const* cur = d->cur;
+    char const* end = d->end;
+    while( cur < end && ( *cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t' ) )
+        cur++;
+    d->cur = cur;
+}
+
+static void
+putBytes( State* state, CharBuf* b, char const* src, size_t len ) {
+    ensureCharBuf( state, b, len );
+    memcpy( b->buf + b->top, src, len );
+    b->top += len;
+}
+
+static uint
+decHex( State* state, Decoder* d ) {
+    if( d->end - d->cur < 4 )
+        decFail( d, "Truncated unicode escape" );
+    
+    uint code = 0;
+    for( uint i = 0 ; i < 4 ; i++ ) {
+        char c = *d->cur++;
+        code <<= 4;
+        if( c >= '0' && c <= '9' )
+            code |= c - '0';
+        else
+        if( c >= 'a' && c <= 'f' )
+            code |= c - 'a' + 10;
+        else
+        if( c >= 'A' && c <= 'F' )
+            code |= c - 'A' + 10;
+        else
+            decFail( d, "Invalid unicode escape" );
+    }
+    return code;
+}
+
+static void
+putCode( State* state, CharBuf* b, uint code ) {
+    char  u[4];
+    uint  n;
+    if( code < 0x80 ) {
+        u[0] = code;
+        n = 1;
+    }
+    else
+    if( code < 0x800 ) {
+        u[0] = 0xC0 | code >> 6;
+        u[1] = 0x80 | ( code & 0x3F );
+        n = 2;
+    }
+    else
+    if( code < 0x10000 ) {
+        u[0] = 0xE0 | code >> 12;
+        u[1] = 0x80 | ( code >> 6 & 0x3F );
+        u[2] = 0x80 | ( code & 0x3F );
+        n = 3;
+    }
+    else {
+        u[0] = 0xF0 | code >> 18;
+        u[1] = 0x80 | ( code >> 12 & 0x3F );
+        u[2] = 0x80 | ( code >> 6 & 0x3F );
+        u[3] = 0x80 | ( code & 0x3F );
+        n = 4;
+    }
+    putBytes( state, b, u, n );
+}
+
+// Decodes the string at the cursor, returning a pointer to its
+// contents.  Strings without escapes are returned in place, the
+// others are unescaped into the decoder's text buffer.
+static char const*
+decStr( State* state, Decoder* d, size_t* len ) {
+    char const* end   = d->end;
+    char const* start = ++d->cur;
+    char const* cur   = start;
+    while( cur < end && *cur != '"' && *cur != '\\' && (uchar)*cur >= 0x20 )
+        cur++;
+    
+    d->cur = cur;
+    if( cur == end )
+        decFail( d, "Unterminated string" );
+    if( *cur == '"' ) {
+        d->cur++;
+        *len = cur - start;
+        return start;
+    }
+    
+    CharBuf* text = &d->text;
+    text->top = 0;
+    putBytes( state, text, start, cur - start );
+    
+    while( d->cur < end && *d->cur != '"' ) {
+        char c = *d->cur;
+        if( (uchar)c < 0x20 )
+            decFail( d, "Control character in string" );
+        if( c != '\\' ) {
+            start = d->cur;
+            while( d->cur < end && *d->cur != '"' && *d->cur != '\\' && (uchar)*d->cur >= 0x20 )
+                d->cur++;
+            putBytes( state, text, start, d->cur - start );
+            continue;
+        }
+        
+        d->cur++;
+        if( d->cur == end )
+            break;
+        
+        char e = *d->cur++;
+        switch( e ) {
+            case '"':  putBytes( state, text, "\"", 1 ); break;
+            case '\\': putBytes( state, text, "\\", 1 ); break;
+            case '/':  putBytes( state, text, "/", 1 );  break;
+            case 'b':  putBytes( state, text, "\b", 1 ); break;
+            case 'f':  putBytes( state, text, "\f", 1 ); break;
+            case 'n':  putBytes( state, text, "\n", 1 ); break;
+            case 'r':  putBytes( state, text, "\r", 1 ); break;
+            case 't':  putBytes( state, text, "\t", 1 ); break;
+            case 'u': {
+                uint code = decHex( state, d );
+                if( code >= 0xDC00 && code <= 0xDFFF )
+                    decFail( d, "Unpaired surrogate in unicode escape" );
+                if( code >= 0xD800 && code <= 0xDBFF ) {
+                    if( end - d->cur < 2 || d->cur[0] != '\\' || d->cur[1] != 'u' )
+                        decFail( d, "Unpaired surrogate in unicode escape" );
+                    d->cur += 2;
+                    
+                    uint low = decHex( state, d );
+                    if( low < 0xDC00 || low > 0xDFFF )
+                        decFail( d, "Unpaired surrogate in unicode escape" );
+                    code = 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+                }
+                putCode( state, text, code );
+            } break;
+            default:
+                d->cur--;
+                decFail( d, "Invalid escape in string" );
+            break;
+        }
+    }
+    if( d->cur == end )
+        decFail( d, "Unterminated string" );
+    
+    d->cur++;
+    *len = text->top;
+    return text->buf;
+}
+
+static bool
+isDigit( char c ) {
+    return c >= '0' && c <= '9';
+}
+
+static TVal
+decNum( State* state, Decoder* d ) {
+    char const* start = d->cur;
+    char const* cur   = d->cur;
+    char const* end   = d->end;
+    bool        isInt = true;
+    
+    if( *cur == '-' )
+        cur++;
+    if( cur == end || !isDigit( *cur ) ) {
+        d->cur = cur;
+        decFail( d, "Invalid number" );
+    }
+    if( *cur == '0' )
+        cur++;
+    else
+        while( cur < end && isDigit( *cur ) )
+            cur++;
+    
+    if( cur < end && *cur == '.' ) {
+        isInt = false;
+        cur++;
+        if( cur == end || !isDigit( *cur ) ) {
+            d->cur = cur;
+            decFail( d, "Invalid number" );
+        }
+        while( cur < end && isDigit( *cur ) )
+            cur++;
+    }
+    if( cur < end && ( *cur == 'e' || *cur == 'E' ) ) {
+        isInt = false;
+        cur++;
+        if( cur < end && ( *cur == '+' || *cur == '-' ) )
+            cur++;
+        if( cur == end || !isDigit( *cur ) ) {
+            d->cur = cur;
+            decFail( d, "Invalid number" );
+        }
+        while( cur < end && isDigit( *cur ) )
+            cur++;
+    }
+    d->cur = cur;
+    
+    // Integers that fit are converted directly, anything else
+    // goes through `strtod()` on a terminated copy.
+    size_t len = cur - start;
+    if( isInt && len <= 11 ) {
+        char const* c = start;
+        bool neg = *c == '-';
+        if( neg )
+            c++;
+        
+        llong v = 0;
+        while( c < cur )
+            v = v*10 + ( *c++ - '0' );
+        if( neg )
+            v = -v;
+        if( (IntT)v == v )
+            return tvInt( v );
+    }
+    
+    char  tmp[64];
+    char* num = tmp;
+    if( len >= sizeof(tmp) ) {
+        d->text.top = 0;
+        ensureCharBuf( state, &d->text, len + 1 );
+        num = d->text.buf;
+    }
+    memcpy( num, start, len );
+    num[len] = '\0';
+    
+    // Numbers too big for a Dec would come out as infinities,
+    // which can't be encoded again; so they're rejected here.
+    double v = strtod( num, NULL );
+    if( isinf( v ) ) {
+        d->cur = start;
+        decFail( d, "Number out of range" );
+    }
+    return tvDec( v );
+}
+
+static void
+decLit( State* state, Decoder* d, char const* lit, size_t len ) {
+    if( (size_t)(d->end - d->cur) < len || memcmp( d->cur, lit, len ) )
+        decFail( d, "Invalid literal" );
+    d->cur += len;
+}
+
+static uint
+hashKeys( TVal* kv, uint n ) {
+    uint hash = n * 0x9E3779B9u;
+    for( uint i = 0 ; i < n ; i++ ) {
+        SymT sym = tvGetSym( kv[i*2] );
+        hash = ( hash ^ (uint)( sym ^ sym >> 32 ) ) * 0x01000193u;
+    }
+    return hash;
+}
+
+// Finds or creates the shape for the key/value pairs on top
+// of the value stack.  Returns NULL if the keys can't share
+// an Index, which is only the case with duplicate keys.
+static Shape*
+objShape( State* state, Decoder* d, uint base, uint n ) {
+    TVal* kv   = d->vals.buf + base;
+    uint  hash = hashKeys( kv, n );
+    
+    Shape* sh = &d->shapes->slots[hash % SHAPE_SLOTS];
+    if( sh->idx && !sh->seq && sh->len == n && sh->hash == hash ) {
+        uint i = 0;
+        while( i < n && sh->keys[i].key == tvGetSym( kv[i*2] ) )
+            i++;
+        if( i == n )
+            return sh;
+    }
+    
+    // The ref taken by each `idxAddByKey()` is kept for as
+    // long as the Index lives, so the locators recorded for
+    // the keys can't be recycled.
+    shapeReset( state, sh, hash, n, false );
+    for( uint i = 0 ; i < n ; i++ ) {
+        TVal key = d->vals.buf[base + i*2];
+        if( idxGetByKey( state, sh->idx, key ) != UINT_MAX )
+            return NULL;
+        
+        uint loc = idxAddByKey( state, sh->idx, key );
+        sh->keys[i] = (ShapeKey){ .key = tvGetSym( key ), .loc = loc };
+    }
+    sh->len = n;
+    return sh;
+}
+
+static Shape*
+seqShape( State* state, Decoder* d, uint n ) {
+    uint   hash = n * 0x85EBCA6Bu;
+    Shape* sh   = &d->shapes->slots[hash % SHAPE_SLOTS];
+    if( sh->idx && sh->seq && sh->len == n )
+        return sh;
+    
+    // A new Index gives out locators in order, so each key
+    // is at the locator of the same number.
+    shapeReset( state, sh, hash, n, true );
+    for( uint i = 0 ; i < n ; i++ )
+        idxAddByKey( state, sh->idx, tvInt( i ) );
+    sh->len = n;
+    return sh;
+}
+
+// Replaces the `n` values (or key/value pairs) at `base` on the
+// value stack with the record made from them.
+static void
+decRecord( State* state, Decoder* d, uint base, uint n, bool seq ) {
+    ensureValBuf( state, &d->vals, 1 );
+    
+    Shape* sh = NULL;
+    if( n <= SHAPE_MAX )
+        sh = seq ? seqShape( state, d, n ) : objShape( state, d, base, n );
+    
+    // Records without a shape get an Index of their own,
+    // which is kept on the stack until the Record has it.
+    uint   top = d->vals.top;
+    Index* idx = sh ? sh->idx : idxNew( state );
+    d->vals.buf[top] = tvObj( idx );
+    d->vals.top++;
+    
+    Record* rec = recNew( state, idx );
+    d->vals.buf[top] = tvObj( rec );
+    
+    TVal* vals = d->vals.buf + base;
+    if( sh && seq ) {
+        TVal* rv = recVals( rec );
+        for( uint i = 0 ; i < n ; i++ ) {
+            rv[i] = vals[i];
+            idxAddByLoc( state, idx, i );
+        }
+    }
+    else
+    if( sh ) {
+        TVal*     rv   = recVals( rec );
+        ShapeKey* keys = sh->keys;
+        for( uint i = 0 ; i < n ; i++ ) {
+            rv[keys[i].loc] = vals[i*2 + 1];
+            idxAddByLoc( state, idx, keys[i].loc );
+        }
+    }
+    else {
+        for( uint i = 0 ; i < n ; i++ ) {
+            vals = d->vals.buf + base;
+            if( seq )
+                recDef( state, rec, tvInt( i ), vals[i] );
+            else
+                recDef( state, rec, vals[i*2], vals[i*2 + 1] );
+        }
+    }
+    
+    d->vals.buf[base] = tvObj( rec );
+    d->vals.top = base + 1;
+}
+
+static void
+decObject( State* state, Decoder* d ) {
+    uint base = d->vals.top;
+    
+    d->cur++;
+    skipWs( d );
+    if( d->cur < d->end && *d->cur == '}' ) {
+        d->cur++;
+        decRecord( state, d, base, 0, false );
+        return;
+    }
+    
+    for( ;; ) {
+        if( d->cur == d->end || *d->cur != '"' )
+            decFail( d, "Expected string key" );
+        
+        // Make room for the pair first, so the new symbol
+        // can't be collected before it's on the stack.
+        ensureValBuf( state, &d->vals, 2 );
+        
+        size_t      len;
+        char const* str = decStr( state, d, &len );
+        d->vals.buf[d->vals.top++] = tvSym( symGet( state, str, len ) );
+        
+        skipWs( d );
+        if( d->cur == d->end || *d->cur != ':' )
+            decFail( d, "Expected ':'" );
+        d->cur++;
+        
+        decValue( state, d );
+        
+        skipWs( d );
+        if( d->cur < d->end && *d->cur == ',' ) {
+            d->cur++;
+            skipWs( d );
+            continue;
+        }
+        if( d->cur < d->end && *d->cur == '}' ) {
+            d->cur++;
+            break;
+        }
+        decFail( d, "Expected ',' or '}'" );
+    }
+    
+    decRecord( state, d, base, ( d->vals.top - base )/2, false );
+}
+
+static void
+decArray( State* state, Decoder* d ) {
+    uint base = d->vals.top;
+    
+    d->cur++;
+    skipWs( d );
+    if( d->cur < d->end && *d->cur == ']' ) {
+        d->cur++;
+        decRecord( state, d, base, 0, true );
+        return;
+    }
+    
+    for( ;; ) {
+        decValue( state, d );
+        
+        skipWs( d );
+        if( d->cur < d->end && *d->cur == ',' ) {
+            d->cur++;
+            continue;
+        }
+        if( d->cur < d->end && *d->cur == ']' ) {
+            d->cur++;
+            break;
+        }
+        decFail( d, "Expected ',' or ']'" );
+    }
+    
+    decRecord( state, d, base, d->vals.top - base, true );
+}
+
+static void
+decValue( State* state, Decoder* d ) {
+    skipWs( d );
+    if( d->cur == d->end )
+        decFail( d, "Unexpected end" );
+    
+    ensureValBuf( state, &d->vals, 1 );
+    
+    TVal val;
+    switch( *d->cur ) {
+        case '{':
+        case '[':
+            if( d->depth >= JSON_DEPTH_MAX )
+                decFail( d, "Nesting too deep" );
+            d->depth++;
+            if( *d->cur == '{' )
+                decObject( state, d );
+            else
+                decArray( state, d );
+            d->depth--;
+        return;
+        case '"': {
+            size_t      len;
+            char const* str = decStr( state, d, &len );
+            val = tvObj( strNew( state, str, len ) );
+        } break;
+        case 't':
+            decLit( state, d, "true", 4 );
+            val = tvLog( true );
+        break;
+        case 'f':
+            decLit( state, d, "false", 5 );
+            val = tvLog( false );
+        break;
+        case 'n':
+            decLit( state, d, "null", 4 );
+            val = tvNil();
+        break;
+        default:
+            if( *d->cur != '-' && !isDigit( *d->cur ) )
+                decFail( d, "Unexpected character" );
+            val = decNum( state, d );
+        break;
+    }
+    d->vals.buf[d->vals.top++] = val;
+}
+
+TVal
+jsonDecode( State* state, JsonShapes* shapes, char const* buf, size_t len ) {
+    Decoder d = {
+        .base   = { .cb = decDefer },
+        .scan   = { .cb = decScan },
+        .buf    = buf,
+        .cur    = buf,
+        .end    = buf + len,
+        .depth  = 0,
+        .vals   = { .buf = NULL, .cap = 0, .top = 0 },
+        .text   = { .buf = NULL, .cap = 0, .top = 0 },
+        .shapes = shapes,
+        .owner  = shapes == NULL
+    };
+    
+    // Everything is zeroed before the Defer is installed, so
+    // the cleanup is safe wherever an allocation fails.
+    stateInstallScanner( state, &d.scan );
+    stateInstallDefer( state, (Defer*)&d );
+    initValBuf( state, &d.vals );
+    initCharBuf( state, &d.text );
+    if( d.owner )
+        d.shapes = jsonShapesNew( state );
+    
+    decValue( state, &d );
+    skipWs( &d );
+    if( d.cur != d.end )
+        decFail( &d, "Unexpected trailing characters" );
+    
+    TVal val = d.vals.buf[0];
+    stateCommitDefer( state, (Defer*)&d );
+    return val;
+}
+
+
+typedef struct {
+    Defer    base;
+    CharBuf  out;
+    EntBuf   ents;
+    IdxIter* iter;
+    uint     depth;
+} Encoder;
+
+static void
+encDefer( State* state, Defer* defer ) {
+    Encoder* e = (Encoder*)defer;
+    if( e->iter )
+        idxIterFree( state, e->iter );
+    finlCharBuf( state, &e->out );
+    finlEntBuf( state, &e->ents );
+}
+
+static void
+encBytes( State* state, Encoder* e, char const* src, size_t len ) {
+    putBytes( state, &e->out, src, len );
+}
+
+static void
+encStr( State* state, Encoder* e, char const* str, size_t len ) {
+    static char const hex[] = "0123456789abcdef";
+    
+    ensureCharBuf( state, &e->out, len*6 + 2 );
+    char* out = e->out.buf + e->out.top;
+    *out++ = '"';
+    for( size_t i = 0 ; i < len ; i++ ) {
+        uchar c = str[i];
+        if( c >= 0x20 && c != '"' && c != '\\' ) {
+            *out++ = c;
+            continue;
+        }
+        
+        *out++ = '\\';
+        switch( c ) {
+            case '"':  *out++ = '"';  break;
+            case '\\': *out++ = '\\'; break;
+            case '\b': *out++ = 'b';  break;
+            case '\f': *out++ = 'f';  break;
+            case '\n': *out++ = 'n';  break;
+            case '\r': *out++ = 'r';  break;
+            case '\t': *out++ = 't';  break;
+            default:
+                *out++ = 'u';
+                *out++ = '0';
+                *out++ = '0';
+                *out++ = hex[c >> 4];
+                *out++ = hex[c & 0xF];
+            break;
+        }
+    }
+    *out++ = '"';
+    e->out.top = out - e->out.buf;
+}
+
+static void
+encSym( State* state, Encoder* e, SymT sym ) {
+    encStr( state, e, symBuf( state, sym ), symLen( state, sym ) );
+}
+
+// Writes the value in plain notation if the decimal point falls
+// within 21 places, or in exponent notation otherwise; always
+// with a fraction or exponent, so it decodes as a `Dec` again.
+static void
+encDec( State* state, Encoder* e, DecT dec ) {
+    if( isnan( dec ) || isinf( dec ) )
+        panic( "Can't encode non-finite Dec '%v'", tvDec( dec ) );
+    
+    char  out[40];
+    char* cur = out;
+    if( signbit( dec ) ) {
+        *cur++ = '-';
+        dec = -dec;
+    }
+    if( dec == 0.0 ) {
+        memcpy( cur, "0.0", 3 );
+        encBytes( state, e, out, cur + 3 - out );
+        return;
+    }
+    
+    char digits[20];
+    int  k;
+    int  len = fmtDigits( dec, digits, &k );
+    int  pt  = len + k;
+    
+    if( k >= 0 && pt <= 21 ) {
+        memcpy( cur, digits, len );
+        cur += len;
+        for( int i = 0 ; i < k ; i++ )
+            *cur++ = '0';
+        *cur++ = '.';
+        *cur++ = '0';
+    }
+    else
+    if( pt > 0 && pt <= 21 ) {
+        memcpy( cur, digits, pt );
+        cur += pt;
+        *cur++ = '.';
+        memcpy( cur, digits + pt, len - pt );
+        cur += len - pt;
+    }
+    else
+    if( pt > -6 && pt <= 0 ) {
+        *cur++ = '0';
+        *cur++ = '.';
+        for( int i = pt ; i < 0 ; i++ )
+            *cur++ = '0';
+        memcpy( cur, digits, len );
+        cur += len;
+    }
+    else {
+        *cur++ = digits[0];
+        if( len > 1 ) {
+            *cur++ = '.';
+            memcpy( cur, digits + 1, len - 1 );
+            cur += len - 1;
+        }
+        cur += snprintf( cur, out + sizeof(out) - cur, "e%d", pt - 1 );
+    }
+    encBytes( state, e, out, cur - out );
+}
+
+static int
+entLocCmp( void const* a, void const* b ) {
+    uint la = ((Entry const*)a)->loc;
+    uint lb = ((Entry const*)b)->loc;
+    return ( la > lb ) - ( la < lb );
+}
+
+static int
+entKeyCmp( void const* a, void const* b ) {
+    IntT ka = tvGetInt( ((Entry const*)a)->key );
+    IntT kb = tvGetInt( ((Entry const*)b)->key );
+    return ( ka > kb ) - ( ka < kb );
+}
+
+static void
+encValue( State* state, Encoder* e, TVal val );
+
+static void
+encRecord( State* state, Encoder* e, Record* rec ) {
+    if( e->depth >= JSON_DEPTH_MAX )
+        panic( "Can't encode records nested this deep, or cyclic" );
+    e->depth++;
+    
+    // Gather the record's fields on the entry stack first,
+    // ordered by locator; which for decoded records, and
+    // those built by constructors, is the order in which
+    // the fields were defined.
+    Index* idx  = recIdx( rec );
+    TVal*  vals = recVals( rec );
+    uint   cap  = recCap( rec );
+    uint   base = e->ents.top;
+    
+    bool seq = true;
+    
+    e->iter = idxIterMake( state, idx );
+    
+    TVal key;
+    uint loc;
+    while( idxIterNext( state, e->iter, &key, &loc ) ) {
+        if( loc >= cap || tvIsUdf( vals[loc] ) )
+            continue;
+        
+        Entry* ent = putEntBuf( state, &e->ents );
+        ent->key = key;
+        ent->val = vals[loc];
+        ent->loc = loc;
+        if( !tvIsInt( key ) || tvGetInt( key ) < 0 )
+            seq = false;
+    }
+    idxIterFree( state, e->iter );
+    e->iter = NULL;
+    
+    // Integer keys that are all distinct and less than
+    // the count must be exactly `0` through `n - 1`.
+    uint n = e->ents.top - base;
+    if( seq && n > 0 ) {
+        for( uint i = base ; i < base + n && seq ; i++ )
+            if( (uint)tvGetInt( e->ents.buf[i].key ) >= n )
+                seq = false;
+    }
+    else {
+        seq = false;
+    }
+    
+    qsort( e->ents.buf + base, n, sizeof(Entry), seq ? entKeyCmp : entLocCmp );
+    
+    encBytes( state, e, seq ? "[" : "{", 1 );
+    for( uint i = 0 ; i < n ; i++ ) {
+        if( i > 0 )
+            encBytes( state, e, ",", 1 );
+        
+        Entry ent = e->ents.buf[base + i];
+        if( !seq ) {
+            if( tvIsSym( ent.key ) ) {
+                encSym( state, e, tvGetSym( ent.key ) );
+            }
+            else
+            if( tvIsObjType( ent.key, OBJ_STR ) ) {
+                String* str = tvGetObj( ent.key );
+                encStr( state, e, str->buf, str->len );
+            }
+            else
+            if( tvIsInt( ent.key ) ) {
+                char buf[16];
+                int  len = snprintf( buf, sizeof(buf), "\"%d\"", (int)tvGetInt( ent.key ) );
+                encBytes( state, e, buf, len );
+            }
+            else {
+                panic( "Can't encode record key of type %t", ent.key );
+            }
+            encBytes( state, e, ":", 1 );
+        }
+        encValue( state, e, ent.val );
+    }
+    encBytes( state, e, seq ? "]" : "}", 1 );
+    
+    e->ents.top = base;
+    e->depth--;
+}
+
+static void
+encValue( State* state, Encoder* e, TVal val ) {
+    if( tvIsNil( val ) ) {
+        encBytes( state, e, "null", 4 );
+    }
+    else
+    if( tvIsLog( val ) ) {
+        if( tvGetLog( val ) )
+            encBytes( state, e, "true", 4 );
+        else
+            encBytes( state, e, "false", 5 );
+    }
+    else
+    if( tvIsInt( val ) ) {
+        char buf[16];
+        int  len = snprintf( buf, sizeof(buf), "%d", (int)tvGetInt( val ) );
+        encBytes( state, e, buf, len );
+    }
+    else
+    if( tvIsDec( val ) ) {
+        encDec( state, e, tvGetDec( val ) );
+    }
+    else
+    if( tvIsSym( val ) ) {
+        encSym( state, e, tvGetSym( val ) );
+    }
+    else
+    if( tvIsObjType( val, OBJ_STR ) ) {
+        String* str = tvGetObj( val );
+        encStr( state, e, str->buf, str->len );
+    }
+    else
+    if( tvIsObjType( val, OBJ_REC ) ) {
+        encRecord( state, e, tvGetObj( val ) );
+    }
+    else {
+        panic( "Can't encode value of type %t", val );
+    }
+}
+
+String*
+jsonEncode( State* state, TVal val ) {
+    Encoder e = {
+        .base  = { .cb = encDefer },
+        .out   = { .buf = NULL, .cap = 0, .top = 0 },
+        .ents  = { .buf = NULL, .cap = 0, .top = 0 },
+        .iter  = NULL,
+        .depth = 0
+    };
+    stateInstallDefer( state, (Defer*)&e );
+    initCharBuf( state, &e.out );
+    initEntBuf( state, &e.ents );
+    
+    encValue( state, &e, val );
+    
+    String* str = strNew( state, e.out.buf, e.out.top );
+    stateCommitDefer( state, (Defer*)&e );
+    return str;
+}
+
+
+void
+jsonScanInit( JsonScan* scan ) {
+    scan->start   = 0;
+    scan->pos     = 0;
+    scan->depth   = 0;
+    scan->started = false;
+    scan->inStr   = false;
+    scan->inEsc   = false;
+}
+
+void
+jsonScanShift( JsonScan* scan, size_t n ) {
+    tenAssert( n <= scan->pos && ( !scan->started || n <= scan->start ) );
+    scan->pos -= n;
+    scan->start = scan->started ? scan->start - n : scan->pos;
+}
+
+static bool
+isScalarEnd( char c ) {
+    switch( c ) {
+        case ' ': case '\n': case '\r': case '\t':
+        case '{': case '}': case '[': case ']':
+        case ',': case ':': case '"':
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool
+jsonScan( JsonScan* scan, char const* buf, size_t len, size_t* end ) {
+    size_t i = scan->pos;
+    
+    if( !scan->started ) {
+        while( i < len && ( buf[i] == ' ' || buf[i] == '\n' || buf[i] == '\r' || buf[i] == '\t' ) )
+            i++;
+        if( i == len ) {
+            scan->pos = i;
+            return false;
+        }
+        
+        scan->started = true;
+        scan->start   = i;
+        scan->depth   = 0;
+        if( buf[i] == '{' || buf[i] == '[' ) {
+            scan->depth = 1;
+            i++;
+        }
+        else
+        if( buf[i] == '"' ) {
+            scan->inStr = true;
+            i++;
+        }
+    }
+    
+    bool done = false;
+    while( i < len && !done ) {
+        char c = buf[i];
+        if( scan->inStr ) {
+            if( scan->inEsc )
+                scan->inEsc = false;
+            else
+            if( c == '\\' )
+                scan->inEsc = true;
+            else
+            if( c == '"' ) {
+                scan->inStr = false;
+                done = scan->depth == 0;
+            }
+            i++;
+        }
+        else
+        if( scan->depth > 0 ) {
+            if( c == '"' )
+                scan->inStr = true;
+            else
+            if( c == '{' || c == '[' )
+                scan->depth++;
+            else
+            if( c == '}' || c == ']' )
+                done = --scan->depth == 0;
+            i++;
+        }
+        else {
+            // Top level scalars end at the first character
+            // that can't be part of them, a stray structural
+            // character is taken as a value of its own so it
+            // fails to decode.
+            if( isScalarEnd( c ) ) {
+                if( i == scan->start )
+                    i++;
+                done = true;
+            }
+            else {
+                i++;
+            }
+        }
+    }
+    
+    scan->pos = i;
+    if( !done )
+        return false;
+    
+    scan->started = false;
+    *end = i;
+    return true;
+}
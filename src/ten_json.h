@@ -0,0 +1,77 @@
+/***********************************************************************
+This component implements JSON decoding and encoding, for the prelude's
+`std:json` module.  JSON objects are decoded into records with symbol
+keys, and arrays into sequence records with keys `0` through `n - 1`;
+`null` becomes `nil`, integers that fit become `Int`s and any other
+numbers `Dec`s.  Records with the same set of keys, in the same order,
+usually share a single Index within each decoded document; and arrays of the
+same length do as well, so their values can be put in place without
+hashing each key.  A streaming decoder shares them across all the
+values it decodes.
+
+Encoding reverses this, records whose keys are exactly `0` through
+`n - 1` become arrays and any others become objects.  The output is
+built in a single growing buffer, and copied to a string once done.
+
+For streaming input `jsonScan()` finds where each top level value ends,
+picking up where it left off when given more of the input, so a large
+document fed in pieces is only scanned once before being decoded.
+***********************************************************************/
+
+#ifndef ten_json_h
+#define ten_json_h
+#include "ten_types.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct JsonShapes JsonShapes;
+
+// Shapes are the key sets (or array lengths) seen by a decoder,
+// with the Index shared by records of each.  A streaming decoder
+// keeps its own across values, so they share Indices as well.
+JsonShapes*
+jsonShapesNew( State* state );
+
+void
+jsonShapesFree( State* state, JsonShapes* shapes );
+
+// Decodes a single JSON value, surrounded by optional whitespace;
+// with the given `shapes` or, if NULL, a set of its own.  Panics
+// if the input isn't valid JSON, or nests too deeply.
+TVal
+jsonDecode( State* state, JsonShapes* shapes, char const* buf, size_t len );
+
+// Panics if the value, or something within it, has no JSON
+// equivalent.
+String*
+jsonEncode( State* state, TVal val );
+
+typedef struct {
+    size_t start;
+    size_t pos;
+    uint   depth;
+    bool   started;
+    bool   inStr;
+    bool   inEsc;
+} JsonScan;
+
+void
+jsonScanInit( JsonScan* scan );
+
+// Scans `buf` for the end of the next top level value.  If the
+// value is complete its start and end offsets are put in
+// `scan->start` and `*end` and `true` returned; otherwise returns
+// `false` and should be called again with the same buffer once
+// more input has been appended to it.  Numbers and literals at
+// the top level are only complete once followed by whitespace
+// or another value.
+bool
+jsonScan( JsonScan* scan, char const* buf, size_t len, size_t* end );
+
+// Adjusts the scan for `n` bytes having been dropped from the
+// front of the buffer, these can't include any of the value
+// being scanned.
+void
+jsonScanShift( JsonScan* scan, size_t n );
+
+#endif
@@ -1,3 +1,8 @@
+// For clock_gettime(), which wclock() uses where available.
+#ifndef _POSIX_C_SOURCE
+    #define _POSIX_C_SOURCE 199309L
+#endif
+
 #include "ten_lib.h"
 #include "ten.h"
 #include "ten_com.h"
@@ -6,6 +11,9 @@
 #include "ten_fmt.h"
 #include "ten_sym.h"
 #include "ten_str.h"
+#include "ten_utf.h"
+#include "ten_vec.h"
+#include "ten_json.h"
 #include "ten_idx.h"
 #include "ten_rec.h"
 #include "ten_fun.h"
@@ -14,9 +22,12 @@
 #include "ten_upv.h"
 #include "ten_dat.h"
 #include "ten_ptr.h"
+#include "ten_msg.h"
+#include "ten_pool.h"
 #include "ten_state.h"
 #include "ten_assert.h"
 #include "ten_macros.h"
+#include "ten_math.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -30,7 +41,6 @@
 #define isDoubleChr( c ) ( (unsigned char)(c) >> 5 == 6  )
 #define isTripleChr( c ) ( (unsigned char)(c) >> 4 == 14 )
 #define isQuadChr( c )   ( (unsigned char)(c) >> 3 == 30 )
-#define isAfterChr( c )  ( (unsigned char)(c) >> 6 == 2  )
 
 // UTF-8 character ranges.
 #define SINGLE_END 0x80L
@@ -48,6 +58,7 @@ typedef enum {
     IDENT_collect,
     IDENT_loader,
     IDENT_clock,
+    IDENT_wclock,
     IDENT_rand,
     
     IDENT_log,
@@ -68,6 +79,7 @@ typedef enum {
     IDENT_bytes,
     IDENT_chars,
     IDENT_split,
+    IDENT_splits,
     IDENT_items,
     IDENT_drange,
     IDENT_irange,
@@ -88,8 +100,48 @@ typedef enum {
     IDENT_blen,
     IDENT_clen,
     
+    IDENT_builder,
+    IDENT_append,
+    IDENT_build,
+    
+    IDENT_buffer,
+    IDENT_bufadd,
+    IDENT_buflen,
+    IDENT_bufget,
+    IDENT_bufset,
+    IDENT_bufcut,
+    IDENT_bufsub,
+    IDENT_bufstr,
+    IDENT_bufpack,
+    IDENT_bufunpack,
+    
+    IDENT_vec,
+    IDENT_vecpush,
+    IDENT_veclen,
+    IDENT_vecget,
+    IDENT_vecset,
+    IDENT_vecsum,
+    IDENT_vecmin,
+    IDENT_vecmax,
+    IDENT_vecdot,
+    IDENT_vecscale,
+    IDENT_vecadd,
+    IDENT_vecmask,
+    IDENT_vecsort,
+    IDENT_vecscan,
+    
     IDENT_each,
     IDENT_fold,
+    IDENT_sort,
+    IDENT_map,
+    IDENT_filter,
+    IDENT_reduce,
+    
+    IDENT_decode,
+    IDENT_encode,
+    IDENT_decoder,
+    IDENT_feed,
+    IDENT_next,
     
     IDENT_sep,
     
@@ -129,6 +181,11 @@ typedef enum {
     IDENT_limit,
     IDENT_skip,
     
+    IDENT_submit,
+    IDENT_await,
+    IDENT_ready,
+    IDENT_workers,
+    
     IDENT__break,
     
     IDENT_LAST
@@ -144,6 +201,22 @@ typedef enum {
     OPER_LAST
 } Oper;
 
+typedef enum {
+    NEXT_keys,
+    NEXT_vals,
+    NEXT_pairs,
+    NEXT_seq,
+    NEXT_bytes,
+    NEXT_chars,
+    NEXT_split,
+    NEXT_items,
+    NEXT_drange,
+    NEXT_irange,
+    NEXT_pump,
+    NEXT_limit,
+    NEXT_LAST
+} Next;
+
 struct LibState {
     Finalizer finl;
     Scanner   scan;
@@ -152,7 +225,10 @@ struct LibState {
     TVal val2;
     
     Index* cellIdx;
+    uint   carLoc;
+    uint   cdrLoc;
     Index* traceIdx;
+    Index* splitIdx;
     
     Record* loaders;
     Record* translators;
@@ -162,6 +238,11 @@ struct LibState {
     SymT opers[OPER_LAST];
     SymT types[OBJ_LAST];
     
+    // Native functions shared by every instance of each
+    // kind of iterator, each instance only needs its own
+    // Data and Closure.
+    Function* nexts[NEXT_LAST];
+    
     ten_DatInfo* recIterInfo;
     ten_DatInfo* strIterInfo;
     ten_DatInfo* splitIterInfo;
@@ -171,6 +252,11 @@ struct LibState {
     ten_DatInfo* iRangeInfo;
     ten_DatInfo* pumpInfo;
     ten_DatInfo* limiterInfo;
+    ten_DatInfo* futureInfo;
+    ten_DatInfo* builderInfo;
+    ten_DatInfo* bufInfo;
+    ten_DatInfo* vecInfo;
+    ten_DatInfo* jsonDecInfo;
 };
 
 static void
@@ -184,12 +270,18 @@ libScan( State* state, Scanner* scan ) {
         stateMark (state, lib->cellIdx );
     if( lib->traceIdx )
         stateMark (state, lib->traceIdx );
+    if( lib->splitIdx )
+        stateMark (state, lib->splitIdx );
     if( lib->loaders )
         stateMark( state, lib->loaders );
     if( lib->translators )
         stateMark( state, lib->translators );
     if( lib->modules )
         stateMark( state, lib->modules );
+    for( uint i = 0 ; i < NEXT_LAST ; i++ ) {
+        if( lib->nexts[i] )
+            stateMark( state, lib->nexts[i] );
+    }
     
     
     if( !state->gcFull )
@@ -484,6 +576,16 @@ libClock( State* state ) {
     return (double)clock()/CLOCKS_PER_SEC;
 }
 
+DecT
+libWclock( State* state ) {
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    if( clock_gettime( CLOCK_MONOTONIC, &ts ) == 0 )
+        return (double)ts.tv_sec + (double)ts.tv_nsec/1e9;
+#endif
+    return (double)time( NULL );
+}
+
 
 DecT
 libRand( State* state ) {
@@ -595,7 +697,7 @@ libSym( State* state, TVal val ) {
         return val;
     if( tvIsObjType( val, OBJ_STR ) ) {
         String* str = tvGetObj( val );
-        SymT    sym = symGet( state, strBuf( state, str ), strLen( state, str ) );
+        SymT    sym = symGet( state, str->buf, str->len );
         
         return tvSym( sym );
     }
@@ -822,12 +924,7 @@ libKeys( State* state, Record* rec ) {
     varSet( recVar, tvObj( rec ) );
     ten_setMember( ten, &datVar, RecIter_REC, &recVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "keys%llu", (ullong)(uintptr_t)iter ),
-        .params = NULL,
-        .cb     = ten_fun(keyIterNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_keys] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -888,12 +985,7 @@ libVals( State* state, Record* rec ) {
     varSet( recVar, tvObj( rec ) );
     ten_setMember( ten, &datVar, RecIter_REC, &recVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "vals%llu", (ullong)(uintptr_t)iter ),
-        .params = NULL,
-        .cb     = ten_fun(valIterNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_vals] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -956,12 +1048,7 @@ libPairs( State* state, Record* rec ) {
     varSet( recVar, tvObj( rec ) );
     ten_setMember( ten, &datVar, RecIter_REC, &recVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "pairs%llu", (ullong)(uintptr_t)iter ),
-        .params = NULL,
-        .cb     = ten_fun(pairIterNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_pairs] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -1017,12 +1104,7 @@ libSeq( State* state, Record* vals ) {
     varSet( valsVar, tvObj( vals ) );
     ten_setMember( ten, &datVar, Seq_VALS, &valsVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "seq%llu", (ullong)(uintptr_t)seq ),
-        .params = NULL,
-        .cb     = ten_fun(seqNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_seq] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -1076,12 +1158,7 @@ libBytes( State* state, String* str ) {
     varSet( strVar, tvObj( str ) );
     ten_setMember( ten, &datVar, StrIter_STR, &strVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "bytes%llu", (ullong)(uintptr_t)iter ),
-        .params = NULL,
-        .cb     = ten_fun(byteIterNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_bytes] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -1116,6 +1193,10 @@ cnext( State* state, char const** str, size_t* len, SymT* next ) {
             goto fail;
         n = 4;
     }
+    else
+    if( n == 0 ) {
+        goto fail;
+    }
     
     *next = symGet( state, *str, n );
     *str += n;
@@ -1167,12 +1248,7 @@ libChars( State* state, String* str ) {
     varSet( strVar, tvObj( str ) );
     ten_setMember( ten, &datVar, StrIter_STR, &strVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "chars%llu", (ullong)(uintptr_t)iter ),
-        .params = NULL,
-        .cb     = ten_fun(charIterNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_chars] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -1181,8 +1257,36 @@ libChars( State* state, String* str ) {
     return cls;
 }
 
+// Find the first occurrence of `sep` in `buf`, or NULL if
+// there isn't one.  Candidates are found with `memchr()` on
+// the separator's first byte, which libc vectorizes, and its
+// last byte is checked before comparing the rest.
+static char const*
+findSep( char const* buf, size_t len, String* sep ) {
+    if( len < sep->len )
+        return NULL;
+    
+    char const* end   = buf + len - sep->len + 1;
+    char        first = sep->buf[0];
+    char        last  = sep->buf[sep->len - 1];
+    
+    char const* it = buf;
+    while( it < end ) {
+        it = memchr( it, first, end - it );
+        if( !it )
+            return NULL;
+        if( it[sep->len - 1] == last && !memcmp( it + 1, sep->buf + 1, sep->len - 1 ) )
+            return it;
+        it++;
+    }
+    return NULL;
+}
+
+// The location is kept as an offset rather than a pointer,
+// since `strBuf()` can move a slice to a new buffer.
 typedef struct {
-    char const* loc;
+    size_t loc;
+    bool   done;
 } SplitIter;
 
 typedef enum {
@@ -1197,26 +1301,23 @@ ten_define(splitIterNext) {
     
     ten_Tup retTup = ten_pushA( call->ten, "N" );
     ten_Var retVar = ten_var( retTup, 0 );
-    if( iter->loc == NULL )
+    if( iter->done )
         return retTup;
     
     String* str = tvGetObj( varGet( ten_mem( SplitIter_STR ) ) );
     String* sep = tvGetObj( varGet( ten_mem( SplitIter_SEP ) ) );
     
-    char const* loc = iter->loc;
-    char const* nxt = loc;
-    char const* end = str->buf + str->len;
-    while( nxt + sep->len <= end ) {
-        if( !memcmp( nxt, sep->buf, sep->len ) ) {
-            iter->loc = nxt + sep->len;
-            varSet( retVar, tvObj( strNew( state, loc, nxt - loc ) ) );
-            return retTup;
-        }
-        nxt++;
+    size_t      loc = iter->loc;
+    char const* nxt = findSep( str->buf + loc, str->len - loc, sep );
+    if( nxt ) {
+        size_t len = nxt - ( str->buf + loc );
+        iter->loc = loc + len + sep->len;
+        varSet( retVar, tvObj( strSlice( state, str, loc, len ) ) );
+        return retTup;
     }
     
-    iter->loc = NULL;
-    varSet( retVar, tvObj( strNew( state, loc, end - loc ) ) );
+    iter->done = true;
+    varSet( retVar, tvObj( strSlice( state, str, loc, str->len - loc ) ) );
     return retTup;
 }
 
@@ -1225,6 +1326,9 @@ libSplit( State* state, String* str, String* sep ) {
     LibState*  lib = state->libState;
     ten_State* ten = (ten_State*)state;
     
+    if( sep->len == 0 )
+        panic( "Separator is empty" );
+    
     ten_Tup varTup = ten_pushA( ten, "UUUUU" );
     ten_Var strVar = ten_var( varTup, 0 );
     ten_Var sepVar = ten_var( varTup, 1 );
@@ -1233,19 +1337,15 @@ libSplit( State* state, String* str, String* sep ) {
     ten_Var clsVar = ten_var( varTup, 4 );
     
     SplitIter* iter = ten_newDat( ten, lib->splitIterInfo, &datVar );
-    iter->loc = str->buf;
+    iter->loc  = 0;
+    iter->done = false;
     
     varSet( strVar, tvObj( str ) );
     varSet( sepVar, tvObj( sep ) );
     ten_setMember( ten, &datVar, SplitIter_STR, &strVar );
     ten_setMember( ten, &datVar, SplitIter_SEP, &sepVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "split%llu", (ullong)(uintptr_t)iter ),
-        .params = NULL,
-        .cb     = ten_fun(splitIterNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_split] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -1254,6 +1354,41 @@ libSplit( State* state, String* str, String* sep ) {
     return cls;
 }
 
+// The records returned by `splits()` all share an Index,
+// so after the first few splits the keys are already there
+// and don't have to be added again.
+Record*
+libSplits( State* state, String* str, String* sep ) {
+    ten_State* ten = (ten_State*)state;
+    LibState*  lib = state->libState;
+    
+    if( sep->len == 0 )
+        panic( "Separator is empty" );
+    
+    ten_Tup varTup = ten_pushA( ten, "U" );
+    ten_Var recVar = ten_var( varTup, 0 );
+    
+    Record* rec = recNew( state, lib->splitIdx );
+    varSet( recVar, tvObj( rec ) );
+    
+    IntT   n   = 0;
+    size_t loc = 0;
+    for( ;; ) {
+        char const* nxt = findSep( str->buf + loc, str->len - loc, sep );
+        size_t      len = nxt ? nxt - ( str->buf + loc ) : str->len - loc;
+        
+        String* sub = strSlice( state, str, loc, len );
+        recDef( state, rec, tvInt( n++ ), tvObj( sub ) );
+        if( !nxt )
+            break;
+        
+        loc += len + sep->len;
+    }
+    
+    ten_pop( ten );
+    return rec;
+}
+
 typedef struct {
     bool finished;
 } ListIter;
@@ -1276,8 +1411,16 @@ ten_define(listIterNext) {
     
     Record* cell = tvGetObj( varGet( ten_mem( ListIter_CELL ) ) );
     
-    TVal car = recGet( state, cell, tvSym( lib->idents[IDENT_car] ) );
-    TVal cdr = recGet( state, cell, tvSym( lib->idents[IDENT_cdr] ) );
+    TVal car, cdr;
+    if( recIdx( cell ) == lib->cellIdx ) {
+        TVal* vals = recVals( cell );
+        car = vals[lib->carLoc];
+        cdr = vals[lib->cdrLoc];
+    }
+    else {
+        car = recGet( state, cell, tvSym( lib->idents[IDENT_car] ) );
+        cdr = recGet( state, cell, tvSym( lib->idents[IDENT_cdr] ) );
+    }
     if( tvIsNil( cdr ) ) {
         iter->finished = true;
     }
@@ -1308,12 +1451,7 @@ libItems( State* state, Record* list ) {
     varSet( listVar, tvObj( list ) );
     ten_setMember( ten, &datVar, ListIter_CELL, &listVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "items%llu", (ullong)(uintptr_t)iter ),
-        .params = NULL,
-        .cb     = ten_fun(listIterNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_items] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -1339,13 +1477,13 @@ ten_define(dRangeNext) {
     ten_Tup retTup = ten_pushA( call->ten, "N" );
     ten_Var retVar = ten_var( retTup, 0 );
     
-    DecT start = range->start;
     DecT end   = range->end;
     DecT next  = range->next;
-    if( (end < start && next <= end) || ( end > start && next >= end ) )
+    DecT step  = range->step;
+    if( step > 0.0 ? next >= end : next <= end )
         return retTup;
     
-    range->next += range->step;
+    range->next += step;
     varSet( retVar, tvDec( next ) );
     
     return retTup;
@@ -1370,12 +1508,7 @@ libDrange( State* state, DecT start, DecT end, DecT step ) {
     range->step  = step;
     range->next  = start;
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "drange%llu", (ullong)(uintptr_t)range ),
-        .params = NULL,
-        .cb     = ten_fun(dRangeNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_drange] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -1401,13 +1534,13 @@ ten_define(iRangeNext) {
     ten_Tup retTup = ten_pushA( call->ten, "N" );
     ten_Var retVar = ten_var( retTup, 0 );
     
-    IntT start = range->start;
     IntT end   = range->end;
     IntT next  = range->next;
-    if( (end < start && next <= end) || ( end > start && next >= end ) )
+    IntT step  = range->step;
+    if( step > 0 ? next >= end : next <= end )
         return retTup;
     
-    range->next += range->step;
+    range->next += step;
     varSet( retVar, tvInt( next ) );
     
     return retTup;
@@ -1432,12 +1565,7 @@ libIrange( State* state, IntT start, IntT end, IntT step ) {
     range->step  = step;
     range->next  = start;
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "irange%llu", (ullong)(uintptr_t)range ),
-        .params = NULL,
-        .cb     = ten_fun(iRangeNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_irange] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -1524,6 +1652,10 @@ unext( State* state, char const** str, size_t* len, uint32_t* next ) {
         n = 4;
         *next = (*str)[0] & 0x7;
     }
+    else
+    if( n == 0 ) {
+        goto fail;
+    }
     
     for( uint i = 1 ; i < n ; i++ ) {
         *next <<= 6;
@@ -1591,6 +1723,38 @@ libUchar( State* state, IntT code ) {
     return tvSym( symGet( state, buf, len ) );
 }
 
+// Get the bytes that `val` contributes to a concatenation.  Strings
+// and symbols are used in place, everything else is formatted into
+// the fmt buffer, so the result is only valid until the next fmt
+// call.  Allocating doesn't invalidate it since objects don't move.
+static char const*
+catBytes( State* state, TVal val, size_t* len ) {
+    if( tvIsObjType( val, OBJ_STR ) ) {
+        String* str = tvGetObj( val );
+        *len = str->len;
+        return str->buf;
+    }
+    if( tvIsSym( val ) ) {
+        SymT sym = tvGetSym( val );
+        *len = symLen( state, sym );
+        return symBuf( state, sym );
+    }
+    
+    char const* str = fmtA( state, false, "%v", val );
+    *len = fmtLen( state );
+    return str;
+}
+
+static void
+putBytes( State* state, CharBuf* buf, char const* str, size_t len ) {
+    if( len == 0 )
+        return;
+    
+    ensureCharBuf( state, buf, len );
+    memcpy( buf->buf + buf->top, str, len );
+    buf->top += len;
+}
+
 String*
 libCat( State* state, Record* vals ) {
     CharBuf buf; initCharBuf( state, &buf );
@@ -1598,10 +1762,9 @@ libCat( State* state, Record* vals ) {
     uint  i = 0;
     TVal  v = recGet( state, vals, tvInt( i++ ) );
     while( !tvIsUdf( v ) ) {
-        char const* str = fmtA( state, false, "%v", v );
-        size_t      len = fmtLen( state );
-        for( uint i = 0 ; i < len ; i++ )
-            *putCharBuf( state, &buf ) = str[i];
+        size_t      len;
+        char const* str = catBytes( state, v, &len );
+        putBytes( state, &buf, str, len );
         
         v = recGet( state, vals, tvInt( i++ ) );
     }
@@ -1623,21 +1786,18 @@ libJoin( State* state, Closure* iter, String* sep ) {
     if( ten_size( ten, &retTup ) != 1 )
         panic( "Iterator returned tuple" );
     
+    bool first = true;
     while( !tvIsNil( varGet( retVar ) ) ) {
-        fmtA( state, false, "%v", varGet( retVar ) );
+        if( !first )
+            putBytes( state, &buf, sep->buf, sep->len );
+        first = false;
+        
+        size_t      len;
+        char const* str = catBytes( state, varGet( retVar ), &len );
+        putBytes( state, &buf, str, len );
         
         ten_pop( ten );
         retTup = ten_call( ten, stateTmp( state, tvObj( iter ) ), &argTup );
-        
-        char const* str = fmtBuf( state );
-        size_t      len = fmtLen( state );
-        if( !tvIsNil( varGet( retVar ) ) ) {
-            str = fmtA( state, true, "%v", tvObj( sep ) );
-            len = fmtLen( state );
-        }
-        
-        for( uint i = 0 ; i < len ; i++ )
-            *putCharBuf( state, &buf ) = str[i];
     }
     
     ten_pop( ten );
@@ -1648,248 +1808,1435 @@ libJoin( State* state, Closure* iter, String* sep ) {
     return str;
 }
 
-TVal
-libBcmp( State* state, String* str1, SymT opr, String* str2 ) {
-    LibState* lib = state->libState;
-    
-    size_t len = str2->len < str1->len ? str2->len : str1->len;
-    int r = memcmp( str1->buf, str2->buf, len + 1 );
-    
-    if( opr == lib->opers[OPER_ILT] )
-        return  tvLog( r < 0 );
-    if( opr == lib->opers[OPER_IMT] )
-        return tvLog( r > 0 );
-    if( opr == lib->opers[OPER_IET] )
-        return tvLog( r == 0 );
-    if( opr == lib->opers[OPER_ILE] )
-        return tvLog( r <= 0 );
-    if( opr == lib->opers[OPER_IME] )
-        return tvLog( r >= 0 );
-    if( opr == lib->opers[OPER_NET] )
-        return tvLog( r != 0 );
-    
-    return tvUdf();
-}
+typedef enum {
+    Builder_BUF,
+    Builder_LAST
+} BuilderMem;
 
-static int
-ucmp( State* state, char const* str1, size_t len1, char const* str2, size_t len2 ) {
-    char const* end1  = str1 + len1;
-    char const* end2  = str2 + len1;
-    
-    while( str1 < end1 && str2 < end2 ) {
-        uint32_t char1 = 0;
-        unext( state, &str1, &len1, &char1 );
-        
-        uint32_t char2 = 0;
-        unext( state, &str2, &len2, &char2 );
+typedef struct {
+    size_t len;
+} Builder;
+
+// A builder's bytes are kept in a String that's never exposed to
+// Ten code, so the GC manages the buffer without the builder
+// needing a destructor.  The String's length is the buffer's
+// capacity, the builder's `len` the number of bytes in use; when
+// an append doesn't fit the buffer is replaced by one with at
+// least twice the capacity, so appends take amortized constant
+// time.
+static char*
+bldReserve( State* state, Data* bld, size_t n ) {
+    Builder* b    = (Builder*)bld->data;
+    TVal     bufV = bld->mems[Builder_BUF];
+    String*  buf  = tvIsObj( bufV ) ? tvGetObj( bufV ) : NULL;
+    size_t   cap  = buf ? buf->len : 0;
+    
+    if( b->len + n > cap ) {
+        size_t need = b->len + n;
+        cap = cap < 32 ? 32 : cap * 2;
+        if( cap < need )
+            cap = need;
         
-        if( char1 < char2 )
-            return -1;
-        if( char1 > char2 )
-            return 1;
+        String* nbuf = strAlloc( state, cap );
+        if( b->len > 0 )
+            memcpy( nbuf->buf, buf->buf, b->len );
+        bld->mems[Builder_BUF] = tvObj( nbuf );
+        buf = nbuf;
     }
     
-    if( str1 == end1  && str2 != end2 )
-        return -1;
-    if( str2 == end2 && str1 != end1 )
-        return 1;
-    
-    return 0;
+    char* dst = buf->buf + b->len;
+    b->len += n;
+    return dst;
 }
 
-TVal
-libCcmp( State* state, String* str1, SymT opr, String* str2 ) {
-    LibState* lib = state->libState;
+Data*
+libBuilder( State* state ) {
+    LibState*  lib = state->libState;
+    ten_State* ten = (ten_State*)state;
     
-    size_t len = str2->len < str1->len ? str2->len : str1->len;
-    int r = ucmp( state, str1->buf, str1->len, str2->buf, str2->len );
+    ten_Tup varTup = ten_pushA( ten, "U" );
+    ten_Var datVar = ten_var( varTup, 0 );
     
-    if( opr == lib->opers[OPER_ILT] )
-        return  tvLog( r < 0 );
-    if( opr == lib->opers[OPER_IMT] )
-        return tvLog( r > 0 );
-    if( opr == lib->opers[OPER_IET] )
-        return tvLog( r == 0 );
-    if( opr == lib->opers[OPER_ILE] )
-        return tvLog( r <= 0 );
-    if( opr == lib->opers[OPER_IME] )
-        return tvLog( r >= 0 );
-    if( opr == lib->opers[OPER_NET] )
-        return tvLog( r != 0 );
+    Builder* b = ten_newDat( ten, lib->builderInfo, &datVar );
+    b->len = 0;
     
-    return tvUdf();
+    Data* bld = tvGetObj( varGet( datVar ) );
+    ten_pop( ten );
+    
+    return bld;
 }
 
-String*
-libBsub( State* state, String* str, IntT n ) {
-    char const* buf = str->buf;
-    size_t      len = str->len;
+bool
+libIsBuilder( State* state, TVal val ) {
+    if( !tvIsObjType( val, OBJ_DAT ) )
+        return false;
     
-    if( n >= 0 ) {
-        if( n > len )
-            panic( "Given 'n' is larger than string length" );
-        return strNew( state, buf, n );
-    }
-    else {
-        if( -n > len )
-            panic( "Given 'n' is larger than string length" );
-        return strNew( state, buf + len + n, -n );
-    }
+    Data* dat = tvGetObj( val );
+    return dat->info == (DatInfo*)state->libState->builderInfo;
 }
 
-String*
-libCsub( State* state, String* str, IntT n ) {
-    char const* buf = str->buf;
-    size_t      len = str->len;
-    
-    if( n >= 0 ) {
-        char const* end  = buf;
-        size_t      left = len;
-        uint32_t    chr  = 0;
-        while( n > 0 && left > 0 ) {
-            n--;
-            unext( state, &end, &left, &chr );
-        }
-        if( n > 0 )
-            panic( "Given 'n' is larger than string length" );
-        
-        return strNew( state, buf, end - buf );
-    }
-    else {
-        char const* start  = buf + len;
-        while( start > buf && n < 0 ) {
-            start--;
-            
-            uint len = 1;
-            while( start > buf && isAfterChr( *start ) ) {
-                start--;
-                len++;
-            }
-            if( len == 1 && !isSingleChr( *start ) )
-                goto fail;
-            if( len == 2 && !isDoubleChr( *start ) )
-                goto fail;
-            if( len == 3 && !isTripleChr( *start ) )
-                goto fail;
-            if( len == 4 && !isQuadChr( *start ) )
-                goto fail;
-            if( len < 1 || len > 4 )
-                goto fail;
-            
-            n++;
-        }
-        
-        if( n < 0 )
-            panic( "Given 'n' is larger than string length" );
-        return strNew( state, start, (buf + len) - start );
-    }
+void
+libAppendBuf( State* state, Data* bld, char const* buf, size_t len ) {
+    if( len == 0 )
+        return;
     
-    fail: panic( "Format is not UTF-8" );
-    return NULL;
+    char* dst = bldReserve( state, bld, len );
+    memcpy( dst, buf, len );
 }
 
-size_t
-libBlen( State* state, String* str ) {
-    return str->len;
+void
+libAppend( State* state, Data* bld, TVal val ) {
+    size_t      len;
+    char const* str = catBytes( state, val, &len );
+    if( len == 0 )
+        return;
+    
+    char* dst = bldReserve( state, bld, len );
+    memcpy( dst, str, len );
 }
 
-size_t
-libClen( State* state, String* str ) {
-    size_t count = 0;
-    
-    char const* end  = str->buf;
-    size_t      left = str->len;
-    uint32_t    chr  = 0;
-    while( left > 0 ) {
-        unext( state, &end, &left, &chr );
-        count++;
-    }
+String*
+libBuild( State* state, Data* bld ) {
+    Builder* b = (Builder*)bld->data;
+    if( b->len == 0 )
+        return strNew( state, "", 0 );
     
-    return count;
+    String* buf = tvGetObj( bld->mems[Builder_BUF] );
+    return strNew( state, buf->buf, b->len );
 }
 
+typedef enum {
+    ByteBuf_STORE,
+    ByteBuf_LAST
+} ByteBufMem;
 
-void
-libEach( State* state, Closure* iter, Closure* what ) {
-    ten_State* ten = (ten_State*)state;
-    
-    
-    ten_Tup sArgTup = ten_pushA( ten, "" );
-    ten_Tup sRetTup = ten_call( ten, stateTmp( state, tvObj( iter ) ), &sArgTup );
-    while( !ten_areNil( ten, &sRetTup ) ) {
-        ten_call( ten, stateTmp( state, tvObj( what ) ), &sRetTup );
-        ten_pop( ten );
-        ten_pop( ten );
-        sRetTup = ten_call( ten, stateTmp( state, tvObj( iter ) ), &sArgTup );
+typedef struct {
+    size_t len;
+    bool   shared;
+} ByteBuf;
+
+// Byte buffers keep their bytes in a String the same way builders
+// do, with the String's length as the buffer's capacity.  Views
+// taken with `libBufSub()` are slices of that String, so don't copy
+// any bytes; but since Strings are immutable the buffer is marked
+// as `shared` when a view is taken, and the next write moves it to
+// a private copy first.
+static String*
+bufStore( State* state, Data* buf, size_t need ) {
+    ByteBuf* b      = (ByteBuf*)buf->data;
+    TVal     storeV = buf->mems[ByteBuf_STORE];
+    String*  store  = tvIsObj( storeV ) ? tvGetObj( storeV ) : NULL;
+    size_t   cap    = store ? store->len : 0;
+    
+    if( store && need <= cap && !b->shared )
+        return store;
+    
+    if( need > cap ) {
+        cap = cap < 32 ? 32 : cap * 2;
+        if( cap < need )
+            cap = need;
     }
-    ten_pop( ten );
-    ten_pop( ten );
+    
+    String* nstore = strAlloc( state, cap );
+    if( b->len > 0 )
+        memcpy( nstore->buf, store->buf, b->len );
+    buf->mems[ByteBuf_STORE] = tvObj( nstore );
+    b->shared = false;
+    return nstore;
 }
 
-TVal
-libFold( State* state, Closure* iter, TVal agr, Closure* how ) {
+Data*
+libBuf( State* state ) {
+    LibState*  lib = state->libState;
     ten_State* ten = (ten_State*)state;
     
-    ten_Tup hArgTup = ten_pushA( ten, "UU" );
-    ten_Var hAgrArg = ten_var( hArgTup, 0 );
-    ten_Var hValArg = ten_var( hArgTup, 1 );
-    
-    varSet( hAgrArg, agr );
+    ten_Tup varTup = ten_pushA( ten, "U" );
+    ten_Var datVar = ten_var( varTup, 0 );
     
-    ten_Tup sArgTup = ten_pushA( ten, "" );
-    ten_Tup sRetTup = ten_call( ten, stateTmp( state, tvObj( iter ) ), &sArgTup );
-    ten_Var sRetVar = { .tup = &sRetTup, .loc = 0 };
-    while( !ten_areNil( ten, &sRetTup ) ) {
-        if( ten_size( ten, &sRetTup ) != 1 )
-            panic( "Iterator returned tuple" );
-        
-        varSet(hValArg, varGet( sRetVar ) );
-        
-        ten_Tup hRetTup = ten_call( ten, stateTmp( state, tvObj( how ) ), &hArgTup );
-        ten_Var hRetVar = { .tup = &hRetTup, .loc = 0 };
-        if( ten_size( ten, &hRetTup ) != 1 )
-            panic( "Aggregator returned tuple" );
-        
-        varSet( hAgrArg, varGet( hRetVar ));
-        
-        ten_pop( ten );
-        ten_pop( ten );
-        sRetTup = ten_call( ten, stateTmp( state, tvObj( iter ) ), &sArgTup );
-    }
-    ten_pop( ten );
-    ten_pop( ten );
+    ByteBuf* b = ten_newDat( ten, lib->bufInfo, &datVar );
+    b->len    = 0;
+    b->shared = false;
     
-    agr = varGet( hAgrArg );
+    Data* buf = tvGetObj( varGet( datVar ) );
     ten_pop( ten );
     
-    return agr;
+    return buf;
 }
 
+bool
+libIsBuf( State* state, TVal val ) {
+    if( !tvIsObjType( val, OBJ_DAT ) )
+        return false;
+    
+    Data* dat = tvGetObj( val );
+    return dat->info == (DatInfo*)state->libState->bufInfo;
+}
 
-Record*
-libSep( State* state, Record* rec ) {
-    recSep( state, rec );
-    return rec;
+size_t
+libBufLen( State* state, Data* buf ) {
+    return ((ByteBuf*)buf->data)->len;
 }
 
-Record*
-libCons( State* state, TVal car, TVal cdr ) {
-    ten_State* ten = (ten_State*)state;
-    LibState*  lib = state->libState;
-    
-    ten_Tup varTup = ten_pushA( ten, "U" );
-    ten_Var recVar = ten_var( varTup, 0 );
-    
-    Record* rec = recNew( state, lib->cellIdx );
-    varSet( recVar, tvObj( rec ) );
+char*
+libBufBytes( State* state, Data* buf ) {
+    ByteBuf* b = (ByteBuf*)buf->data;
+    if( b->len == 0 )
+        return NULL;
     
-    recDef( state, rec, tvSym( lib->idents[IDENT_car] ), car );
-    recDef( state, rec, tvSym( lib->idents[IDENT_cdr] ), cdr );
+    return bufStore( state, buf, b->len )->buf;
+}
+
+void
+libBufAddBytes( State* state, Data* buf, char const* bytes, size_t len ) {
+    if( len == 0 )
+        return;
     
-    recSep( state, rec );
+    ByteBuf* b     = (ByteBuf*)buf->data;
+    String*  store = bufStore( state, buf, b->len + len );
+    memmove( store->buf + b->len, bytes, len );
+    b->len += len;
+}
+
+void
+libBufAdd( State* state, Data* buf, TVal val ) {
+    if( libIsBuf( state, val ) ) {
+        Data* src = tvGetObj( val );
+        libBufAddBytes( state, buf, libBufBytes( state, src ), libBufLen( state, src ) );
+        return;
+    }
     
-    ten_pop( ten );
-    return rec;
+    size_t      len;
+    char const* str = catBytes( state, val, &len );
+    libBufAddBytes( state, buf, str, len );
+}
+
+TVal
+libBufGet( State* state, Data* buf, IntT at ) {
+    ByteBuf* b = (ByteBuf*)buf->data;
+    if( at < 0 || at >= b->len )
+        panic( "Given 'at' is out of range" );
+    
+    String* store = tvGetObj( buf->mems[ByteBuf_STORE] );
+    return tvInt( (uchar)store->buf[at] );
+}
+
+void
+libBufSet( State* state, Data* buf, IntT at, IntT byte ) {
+    ByteBuf* b = (ByteBuf*)buf->data;
+    if( at < 0 || at >= b->len )
+        panic( "Given 'at' is out of range" );
+    if( byte < 0 || byte > 255 )
+        panic( "Given 'byte' is out of range" );
+    
+    String* store = bufStore( state, buf, b->len );
+    store->buf[at] = byte;
+}
+
+void
+libBufCut( State* state, Data* buf, IntT n ) {
+    ByteBuf* b = (ByteBuf*)buf->data;
+    if( n < 0 || n > b->len )
+        panic( "Given 'n' is out of range" );
+    
+    b->len = n;
+}
+
+String*
+libBufSub( State* state, Data* buf, IntT at, IntT n ) {
+    ByteBuf* b = (ByteBuf*)buf->data;
+    if( at < 0 || n < 0 || at > b->len || n > b->len - at )
+        panic( "Given range is out of range" );
+    if( n == 0 )
+        return strNew( state, "", 0 );
+    
+    String* store = tvGetObj( buf->mems[ByteBuf_STORE] );
+    String* sub   = strSlice( state, store, at, n );
+    if( strIsSlice( sub ) )
+        b->shared = true;
+    
+    return sub;
+}
+
+// Binary encodings for `libBufPack()` and `libBufUnpack()` are
+// given as symbols like 'u8', 'i16le', or 'f64be'; a kind, a size
+// in bits, and a byte order, which can only be left out for single
+// bytes.  Ints are 32 bits, so there are no 64 bit integer kinds.
+typedef struct {
+    char kind;
+    uint size;
+    bool big;
+} BufEnc;
+
+static BufEnc
+bufEnc( State* state, SymT type ) {
+    char const* str = symBuf( state, type );
+    size_t      len = symLen( state, type );
+    
+    BufEnc enc = { .kind = str[0], .size = 0, .big = false };
+    
+    size_t i = 1;
+    while( i < len && str[i] >= '0' && str[i] <= '9' )
+        enc.size = enc.size*10 + ( str[i++] - '0' );
+    
+    bool ordered = false;
+    if( len - i == 2 && !memcmp( str + i, "le", 2 ) )
+        ordered = true;
+    else
+    if( len - i == 2 && !memcmp( str + i, "be", 2 ) )
+        ordered = enc.big = true;
+    else
+    if( i != len )
+        goto fail;
+    
+    switch( enc.kind ) {
+        case 'u': case 'i':
+            if( enc.size == 8 && !ordered )
+                return enc;
+            if( ( enc.size == 16 || enc.size == 32 ) && ordered )
+                return enc;
+        break;
+        case 'f':
+            if( ( enc.size == 32 || enc.size == 64 ) && ordered )
+                return enc;
+        break;
+    }
+    
+    fail: panic( "Unknown binary type %v", tvSym( type ) );
+    return enc;
+}
+
+void
+libBufPack( State* state, Data* buf, IntT at, SymT type, TVal val ) {
+    ByteBuf* b   = (ByteBuf*)buf->data;
+    BufEnc   enc = bufEnc( state, type );
+    uint     n   = enc.size/8;
+    
+    if( at < 0 || at > b->len )
+        panic( "Given 'at' is out of range" );
+    if( !tvIsInt( val ) && !tvIsDec( val ) )
+        panic( "Wrong type %t for 'val', need Int or Dec", val );
+    
+    uint64_t bits;
+    if( enc.kind == 'f' ) {
+        double d = tvIsInt( val ) ? tvGetInt( val ) : tvGetDec( val );
+        if( n == 4 ) {
+            float    f = d;
+            uint32_t u;
+            memcpy( &u, &f, sizeof(u) );
+            bits = u;
+        }
+        else {
+            memcpy( &bits, &d, sizeof(bits) );
+        }
+    }
+    else {
+        // Values too large for an Int are passed as Decs, so
+        // integer types accept integral Decs too.
+        double  d  = tvIsInt( val ) ? tvGetInt( val ) : tvGetDec( val );
+        int64_t hi = enc.kind == 'u' ? (int64_t)1 << enc.size : (int64_t)1 << ( enc.size - 1 );
+        int64_t lo = enc.kind == 'u' ? 0 : -hi;
+        if( !( d >= lo && d < hi ) || d != (double)(int64_t)d )
+            panic( "Value %v out of range for %v", val, tvSym( type ) );
+        bits = (uint64_t)(int64_t)d;
+    }
+    
+    size_t end = (size_t)at + n;
+    String* store = bufStore( state, buf, end > b->len ? end : b->len );
+    uchar*  dst   = (uchar*)store->buf + at;
+    for( uint i = 0 ; i < n ; i++ ) {
+        uint shift = enc.big ? ( n - 1 - i )*8 : i*8;
+        dst[i] = (uchar)( bits >> shift );
+    }
+    if( end > b->len )
+        b->len = end;
+}
+
+TVal
+libBufUnpack( State* state, Data* buf, IntT at, SymT type ) {
+    ByteBuf* b   = (ByteBuf*)buf->data;
+    BufEnc   enc = bufEnc( state, type );
+    uint     n   = enc.size/8;
+    
+    if( at < 0 || at > b->len || n > b->len - at )
+        panic( "Given 'at' is out of range" );
+    
+    String*      store = tvGetObj( buf->mems[ByteBuf_STORE] );
+    uchar const* src   = (uchar const*)store->buf + at;
+    
+    uint64_t bits = 0;
+    for( uint i = 0 ; i < n ; i++ ) {
+        uint shift = enc.big ? ( n - 1 - i )*8 : i*8;
+        bits |= (uint64_t)src[i] << shift;
+    }
+    
+    switch( enc.kind ) {
+        case 'f':
+            if( n == 4 ) {
+                uint32_t u = bits;
+                float    f;
+                memcpy( &f, &u, sizeof(f) );
+                if( isnan( f ) )
+                    panic( "Unpacked Dec is NaN" );
+                return tvDec( f );
+            }
+            else {
+                double d;
+                memcpy( &d, &bits, sizeof(d) );
+                if( isnan( d ) )
+                    panic( "Unpacked Dec is NaN" );
+                return tvDec( d );
+            }
+        case 'i': {
+            // Sign extend from the type's size.
+            int64_t v = (int64_t)( bits << ( 64 - enc.size ) ) >> ( 64 - enc.size );
+            return tvInt( v );
+        }
+        default: {
+            // A `u32` can be too large for an Int.
+            if( bits > INT32_MAX )
+                return tvDec( (double)bits );
+            return tvInt( bits );
+        }
+    }
+}
+
+typedef enum {
+    NumVec_STORE,
+    NumVec_LAST
+} NumVecMem;
+
+typedef struct {
+    size_t len;
+    bool   dec;
+} NumVec;
+
+// Packed vectors also keep their values in a hidden String, with
+// a few bytes of slack so the values can start at an aligned
+// address within it.  The values are never shared, so unlike
+// byte buffers there's no need to copy on write.
+#define VEC_ALIGN (8)
+
+#define vecElem( V ) ( (V)->dec ? sizeof(DecT) : sizeof(IntT) )
+
+static void*
+vecValues( Data* vec ) {
+    TVal storeV = vec->mems[NumVec_STORE];
+    if( !tvIsObj( storeV ) )
+        return NULL;
+    
+    uintptr_t addr = (uintptr_t)((String*)tvGetObj( storeV ))->buf;
+    return (void*)( ( addr + VEC_ALIGN - 1 ) & ~(uintptr_t)( VEC_ALIGN - 1 ) );
+}
+
+static void*
+vecReserve( State* state, Data* vec, size_t n ) {
+    NumVec* v      = (NumVec*)vec->data;
+    TVal    storeV = vec->mems[NumVec_STORE];
+    size_t  cap    = 0;
+    if( tvIsObj( storeV ) )
+        cap = ( ((String*)tvGetObj( storeV ))->len - ( VEC_ALIGN - 1 ) )/vecElem( v );
+    
+    if( n <= cap )
+        return vecValues( vec );
+    
+    cap = cap < 8 ? 8 : cap * 2;
+    if( cap < n )
+        cap = n;
+    
+    String* nstore = strAlloc( state, cap*vecElem( v ) + VEC_ALIGN - 1 );
+    void*   old    = vecValues( vec );
+    vec->mems[NumVec_STORE] = tvObj( nstore );
+    
+    void* values = vecValues( vec );
+    if( v->len > 0 )
+        memcpy( values, old, v->len*vecElem( v ) );
+    return values;
+}
+
+Data*
+libVec( State* state, bool dec, size_t len ) {
+    LibState*  lib = state->libState;
+    ten_State* ten = (ten_State*)state;
+    
+    ten_Tup varTup = ten_pushA( ten, "U" );
+    ten_Var datVar = ten_var( varTup, 0 );
+    
+    NumVec* v = ten_newDat( ten, lib->vecInfo, &datVar );
+    v->len = 0;
+    v->dec = dec;
+    
+    Data* vec = tvGetObj( varGet( datVar ) );
+    libVecResize( state, vec, len );
+    ten_pop( ten );
+    
+    return vec;
+}
+
+bool
+libIsVec( State* state, TVal val ) {
+    if( !tvIsObjType( val, OBJ_DAT ) )
+        return false;
+    
+    Data* dat = tvGetObj( val );
+    return dat->info == (DatInfo*)state->libState->vecInfo;
+}
+
+bool
+libVecIsDec( State* state, Data* vec ) {
+    return ((NumVec*)vec->data)->dec;
+}
+
+size_t
+libVecLen( State* state, Data* vec ) {
+    return ((NumVec*)vec->data)->len;
+}
+
+void*
+libVecValues( State* state, Data* vec ) {
+    return vecValues( vec );
+}
+
+void
+libVecResize( State* state, Data* vec, size_t len ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( len > v->len ) {
+        char* values = vecReserve( state, vec, len );
+        memset( values + v->len*vecElem( v ), 0, ( len - v->len )*vecElem( v ) );
+    }
+    v->len = len;
+}
+
+// Int vectors only take Ints, Dec vectors take either.
+static IntT
+vecInt( State* state, TVal val ) {
+    if( !tvIsInt( val ) )
+        panic( "Wrong type %t for 'val', need Int", val );
+    return tvGetInt( val );
+}
+
+static DecT
+vecDec( State* state, TVal val ) {
+    if( tvIsInt( val ) )
+        return tvGetInt( val );
+    if( !tvIsDec( val ) )
+        panic( "Wrong type %t for 'val', need Dec or Int", val );
+    return tvGetDec( val );
+}
+
+// Integer sums and products that don't fit in an Int are
+// returned as Decs.
+static TVal
+vecIntResult( State* state, int64_t r ) {
+    if( r < INT32_MIN || r > INT32_MAX )
+        return tvDec( (DecT)r );
+    return tvInt( r );
+}
+
+// A NaN can't be boxed, so Dec results and values are checked
+// on the way out of a vector.
+static TVal
+vecDecResult( State* state, DecT d ) {
+    if( isnan( d ) )
+        panic( "Vector value is NaN" );
+    return tvDec( d );
+}
+
+TVal
+libVecGet( State* state, Data* vec, IntT at ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( at < 0 || at >= v->len )
+        panic( "Given 'at' is out of range" );
+    
+    if( v->dec )
+        return vecDecResult( state, ((DecT*)vecValues( vec ))[at] );
+    else
+        return tvInt( ((IntT*)vecValues( vec ))[at] );
+}
+
+void
+libVecSet( State* state, Data* vec, IntT at, TVal val ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( at < 0 || at >= v->len )
+        panic( "Given 'at' is out of range" );
+    
+    if( v->dec )
+        ((DecT*)vecValues( vec ))[at] = vecDec( state, val );
+    else
+        ((IntT*)vecValues( vec ))[at] = vecInt( state, val );
+}
+
+void
+libVecPush( State* state, Data* vec, TVal val ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( v->dec ) {
+        DecT  d      = vecDec( state, val );
+        DecT* values = vecReserve( state, vec, v->len + 1 );
+        values[v->len++] = d;
+    }
+    else {
+        IntT  i      = vecInt( state, val );
+        IntT* values = vecReserve( state, vec, v->len + 1 );
+        values[v->len++] = i;
+    }
+}
+
+TVal
+libVecSum( State* state, Data* vec ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( v->dec )
+        return vecDecResult( state, vecSumD( vecValues( vec ), v->len ) );
+    else
+        return vecIntResult( state, vecSumI( vecValues( vec ), v->len ) );
+}
+
+TVal
+libVecMin( State* state, Data* vec ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( v->len == 0 )
+        panic( "Vector is empty" );
+    
+    if( v->dec )
+        return vecDecResult( state, vecMinD( vecValues( vec ), v->len ) );
+    else
+        return tvInt( vecMinI( vecValues( vec ), v->len ) );
+}
+
+TVal
+libVecMax( State* state, Data* vec ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( v->len == 0 )
+        panic( "Vector is empty" );
+    
+    if( v->dec )
+        return vecDecResult( state, vecMaxD( vecValues( vec ), v->len ) );
+    else
+        return tvInt( vecMaxI( vecValues( vec ), v->len ) );
+}
+
+static void
+vecExpectSame( State* state, NumVec* a, NumVec* b ) {
+    if( a->dec != b->dec )
+        panic( "Vectors have different types" );
+    if( a->len != b->len )
+        panic( "Vectors have different lengths" );
+}
+
+TVal
+libVecDot( State* state, Data* vec1, Data* vec2 ) {
+    NumVec* a = (NumVec*)vec1->data;
+    NumVec* b = (NumVec*)vec2->data;
+    vecExpectSame( state, a, b );
+    
+    if( a->dec )
+        return vecDecResult( state, vecDotD( vecValues( vec1 ), vecValues( vec2 ), a->len ) );
+    else
+        return vecIntResult( state, vecDotI( vecValues( vec1 ), vecValues( vec2 ), a->len ) );
+}
+
+void
+libVecScale( State* state, Data* vec, TVal k ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( v->dec ) {
+        vecScaleD( vecValues( vec ), v->len, vecDec( state, k ) );
+        if( vecHasNaND( vecValues( vec ), v->len ) )
+            panic( "Scaling produced NaN" );
+    }
+    else
+        vecScaleI( vecValues( vec ), v->len, vecInt( state, k ) );
+}
+
+void
+libVecAdd( State* state, Data* vec1, Data* vec2 ) {
+    NumVec* a = (NumVec*)vec1->data;
+    NumVec* b = (NumVec*)vec2->data;
+    vecExpectSame( state, a, b );
+    
+    if( a->dec ) {
+        vecAddD( vecValues( vec1 ), vecValues( vec2 ), a->len );
+        if( vecHasNaND( vecValues( vec1 ), a->len ) )
+            panic( "Addition produced NaN" );
+    }
+    else
+        vecAddI( vecValues( vec1 ), vecValues( vec2 ), a->len );
+}
+
+Data*
+libVecMask( State* state, Data* vec, SymT opr, TVal x ) {
+    LibState* lib = state->libState;
+    NumVec*   v   = (NumVec*)vec->data;
+    
+    VecCmp cmp = VEC_LT;
+    if( opr == lib->opers[OPER_ILT] )
+        cmp = VEC_LT;
+    else
+    if( opr == lib->opers[OPER_IMT] )
+        cmp = VEC_MT;
+    else
+    if( opr == lib->opers[OPER_IET] )
+        cmp = VEC_EQ;
+    else
+    if( opr == lib->opers[OPER_ILE] )
+        cmp = VEC_LE;
+    else
+    if( opr == lib->opers[OPER_IME] )
+        cmp = VEC_ME;
+    else
+    if( opr == lib->opers[OPER_NET] )
+        cmp = VEC_NE;
+    else
+        panic( "Unknown comparison operator %v", tvSym( opr ) );
+    
+    // Check the operand before allocating the mask.
+    IntT xi = 0;
+    DecT xd = 0.0;
+    if( v->dec )
+        xd = vecDec( state, x );
+    else
+        xi = vecInt( state, x );
+    
+    Data* mask = libVec( state, false, v->len );
+    if( v->dec )
+        vecMaskD( vecValues( mask ), vecValues( vec ), v->len, cmp, xd );
+    else
+        vecMaskI( vecValues( mask ), vecValues( vec ), v->len, cmp, xi );
+    
+    return mask;
+}
+
+void
+libVecSort( State* state, Data* vec ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( v->dec )
+        vecSortD( vecValues( vec ), v->len );
+    else
+        vecSortI( vecValues( vec ), v->len );
+}
+
+void
+libVecScan( State* state, Data* vec ) {
+    NumVec* v = (NumVec*)vec->data;
+    if( v->dec ) {
+        vecScanD( vecValues( vec ), v->len );
+        if( vecHasNaND( vecValues( vec ), v->len ) )
+            panic( "Scan produced NaN" );
+    }
+    else
+        vecScanI( vecValues( vec ), v->len );
+}
+
+typedef enum {
+    JsonDec_BUF,
+    JsonDec_LAST
+} JsonDecMem;
+
+typedef struct {
+    State*      state;
+    JsonShapes* shapes;
+    JsonScan    scan;
+} JsonDec;
+
+static void
+jsonDecDestr( void* dat ) {
+    JsonDec* j = dat;
+    if( j->shapes )
+        jsonShapesFree( j->state, j->shapes );
+}
+
+// Streaming decoders keep the input fed to them in a byte buffer,
+// scanning it for the end of each top level value before decoding
+// the whole value at once.  The input before the value currently
+// being scanned is dropped when it's at least half the buffer, so
+// the buffer only grows with the size of the values themselves.
+// Records decoded by the same decoder share Indices throughout.
+Data*
+libJsonDecoder( State* state ) {
+    LibState*  lib = state->libState;
+    ten_State* ten = (ten_State*)state;
+    
+    ten_Tup varTup = ten_pushA( ten, "UU" );
+    ten_Var datVar = ten_var( varTup, 0 );
+    ten_Var bufVar = ten_var( varTup, 1 );
+    
+    varSet( bufVar, tvObj( libBuf( state ) ) );
+    
+    JsonDec* j = ten_newDat( ten, lib->jsonDecInfo, &datVar );
+    j->state  = state;
+    j->shapes = NULL;
+    jsonScanInit( &j->scan );
+    j->shapes = jsonShapesNew( state );
+    
+    Data* dec = tvGetObj( varGet( datVar ) );
+    dec->mems[JsonDec_BUF] = varGet( bufVar );
+    ten_pop( ten );
+    
+    return dec;
+}
+
+void
+libJsonFeed( State* state, Data* dec, String* str ) {
+    Data* buf = tvGetObj( dec->mems[JsonDec_BUF] );
+    libBufAddBytes( state, buf, str->buf, str->len );
+}
+
+TVal
+libJsonNext( State* state, Data* dec ) {
+    JsonDec* j     = (JsonDec*)dec->data;
+    Data*    buf   = tvGetObj( dec->mems[JsonDec_BUF] );
+    size_t   len   = libBufLen( state, buf );
+    char*    bytes = libBufBytes( state, buf );
+    
+    size_t drop = j->scan.started ? j->scan.start : j->scan.pos;
+    if( drop > 0 && drop >= len/2 ) {
+        memmove( bytes, bytes + drop, len - drop );
+        libBufCut( state, buf, len - drop );
+        jsonScanShift( &j->scan, drop );
+        len -= drop;
+    }
+    
+    size_t end;
+    if( !jsonScan( &j->scan, bytes, len, &end ) )
+        return tvUdf();
+    
+    return jsonDecode( state, j->shapes, bytes + j->scan.start, end - j->scan.start );
+}
+
+TVal
+libBcmp( State* state, String* str1, SymT opr, String* str2 ) {
+    LibState* lib = state->libState;
+    
+    size_t len = str2->len < str1->len ? str2->len : str1->len;
+    int r = memcmp( str1->buf, str2->buf, len );
+    if( r == 0 )
+        r = (str1->len > str2->len) - (str1->len < str2->len);
+    
+    if( opr == lib->opers[OPER_ILT] )
+        return  tvLog( r < 0 );
+    if( opr == lib->opers[OPER_IMT] )
+        return tvLog( r > 0 );
+    if( opr == lib->opers[OPER_IET] )
+        return tvLog( r == 0 );
+    if( opr == lib->opers[OPER_ILE] )
+        return tvLog( r <= 0 );
+    if( opr == lib->opers[OPER_IME] )
+        return tvLog( r >= 0 );
+    if( opr == lib->opers[OPER_NET] )
+        return tvLog( r != 0 );
+    
+    return tvUdf();
+}
+
+static int
+ucmp( State* state, char const* str1, size_t len1, char const* str2, size_t len2 ) {
+    char const* end1  = str1 + len1;
+    char const* end2  = str2 + len1;
+    
+    while( str1 < end1 && str2 < end2 ) {
+        uint32_t char1 = 0;
+        unext( state, &str1, &len1, &char1 );
+        
+        uint32_t char2 = 0;
+        unext( state, &str2, &len2, &char2 );
+        
+        if( char1 < char2 )
+            return -1;
+        if( char1 > char2 )
+            return 1;
+    }
+    
+    if( str1 == end1  && str2 != end2 )
+        return -1;
+    if( str2 == end2 && str1 != end1 )
+        return 1;
+    
+    return 0;
+}
+
+TVal
+libCcmp( State* state, String* str1, SymT opr, String* str2 ) {
+    LibState* lib = state->libState;
+    
+    size_t len = str2->len < str1->len ? str2->len : str1->len;
+    int r = ucmp( state, str1->buf, str1->len, str2->buf, str2->len );
+    
+    if( opr == lib->opers[OPER_ILT] )
+        return  tvLog( r < 0 );
+    if( opr == lib->opers[OPER_IMT] )
+        return tvLog( r > 0 );
+    if( opr == lib->opers[OPER_IET] )
+        return tvLog( r == 0 );
+    if( opr == lib->opers[OPER_ILE] )
+        return tvLog( r <= 0 );
+    if( opr == lib->opers[OPER_IME] )
+        return tvLog( r >= 0 );
+    if( opr == lib->opers[OPER_NET] )
+        return tvLog( r != 0 );
+    
+    return tvUdf();
+}
+
+String*
+libBsub( State* state, String* str, IntT n ) {
+    size_t len = str->len;
+    
+    if( n >= 0 ) {
+        if( n > len )
+            panic( "Given 'n' is larger than string length" );
+        return strSlice( state, str, 0, n );
+    }
+    else {
+        if( -n > len )
+            panic( "Given 'n' is larger than string length" );
+        return strSlice( state, str, len + n, -n );
+    }
+}
+
+String*
+libCsub( State* state, String* str, IntT n ) {
+    char const* buf = str->buf;
+    size_t      len = str->len;
+    
+    // ASCII strings have a byte per character, otherwise the
+    // characters need to be counted.
+    StrEnc enc = strEnc( state, str );
+    if( enc == STR_BINARY )
+        panic( "Format is not UTF-8" );
+    
+    String* sub;
+    if( n >= 0 ) {
+        size_t end;
+        if( enc == STR_ASCII )
+            end = (size_t)n <= len ? (size_t)n : SIZE_MAX;
+        else
+            end = utfSkip( buf, len, n );
+        if( end == SIZE_MAX )
+            panic( "Given 'n' is larger than string length" );
+        
+        sub = strSlice( state, str, 0, end );
+    }
+    else {
+        size_t count = enc == STR_ASCII ? len : utfCount( buf, len );
+        if( (size_t)-n > count )
+            panic( "Given 'n' is larger than string length" );
+        
+        size_t start;
+        if( enc == STR_ASCII )
+            start = len + n;
+        else
+            start = utfSkip( buf, len, count + n );
+        
+        sub = strSlice( state, str, start, len - start );
+    }
+    
+    // The substring ends on character boundaries, so it's
+    // well formed too.
+    sub->enc = enc;
+    return sub;
+}
+
+size_t
+libBlen( State* state, String* str ) {
+    return str->len;
+}
+
+size_t
+libClen( State* state, String* str ) {
+    StrEnc enc = strEnc( state, str );
+    if( enc == STR_ASCII )
+        return str->len;
+    if( enc == STR_BINARY )
+        panic( "Format is not UTF-8" );
+    
+    return utfCount( str->buf, str->len );
+}
+
+
+// Prelude iterators all share the native functions in
+// `lib->nexts`, so the stages consuming an iterator can
+// recognize them and invoke their callbacks directly; which
+// skips the call machinery for each value produced.  Other
+// iterators are called normally.  Either way the results
+// are pushed to the stack, and `args` should be an empty
+// tuple.  For this to work the callbacks must leave only
+// their results on the stack.
+static Tup
+libNext( State* state, Closure* iter, Tup* args ) {
+    LibState* lib = state->libState;
+    Function* fun = iter->fun;
+    
+    bool prelude = false;
+    if( fun->type == FUN_NAT && iter->dat.dat ) {
+        for( uint i = 0 ; i < NEXT_LAST && !prelude ; i++ )
+            prelude = fun == lib->nexts[i];
+    }
+    if( !prelude )
+        return fibCall( state, iter, args );
+    
+    Data* dat = iter->dat.dat;
+    
+    ten_Call call = { .ten = (ten_State*)state, .data = dat->data };
+    *(Tup*)&call.args = *args;
+    *(Tup*)&call.mems = (Tup){
+        .base   = &dat->mems,
+        .offset = 0,
+        .size   = dat->info->nMems
+    };
+    
+    ten_Tup t    = fun->u.nat.cb( &call );
+    Tup     rets = *(Tup*)&t;
+    tenAssert( rets.offset == stateTop( state ).offset );
+    return rets;
+}
+
+static bool
+tupAreNil( State* state, Tup* tup ) {
+    for( uint i = 0 ; i < tup->size ; i++ ) {
+        if( !tvIsNil( tupGet( *tup, i ) ) )
+            return false;
+    }
+    return true;
+}
+
+void
+libEach( State* state, Closure* iter, Closure* what ) {
+    Tup args = statePush( state, 0 );
+    Tup rets = libNext( state, iter, &args );
+    while( !tupAreNil( state, &rets ) ) {
+        fibCall( state, what, &rets );
+        statePop( state );
+        statePop( state );
+        rets = libNext( state, iter, &args );
+    }
+    statePop( state );
+    statePop( state );
+}
+
+TVal
+libFold( State* state, Closure* iter, TVal agr, Closure* how ) {
+    ten_State* ten = (ten_State*)state;
+    
+    ten_Tup hArgTup = ten_pushA( ten, "UU" );
+    ten_Var hAgrArg = ten_var( hArgTup, 0 );
+    ten_Var hValArg = ten_var( hArgTup, 1 );
+    
+    varSet( hAgrArg, agr );
+    
+    Tup sArgTup = statePush( state, 0 );
+    Tup sRetTup = libNext( state, iter, &sArgTup );
+    while( !tupAreNil( state, &sRetTup ) ) {
+        if( sRetTup.size != 1 )
+            panic( "Iterator returned tuple" );
+        
+        varSet( hValArg, tupGet( sRetTup, 0 ) );
+        
+        ten_Tup hRetTup = ten_call( ten, stateTmp( state, tvObj( how ) ), &hArgTup );
+        ten_Var hRetVar = { .tup = &hRetTup, .loc = 0 };
+        if( ten_size( ten, &hRetTup ) != 1 )
+            panic( "Aggregator returned tuple" );
+        
+        varSet( hAgrArg, varGet( hRetVar ));
+        
+        ten_pop( ten );
+        ten_pop( ten );
+        sRetTup = libNext( state, iter, &sArgTup );
+    }
+    ten_pop( ten );
+    ten_pop( ten );
+    
+    agr = varGet( hAgrArg );
+    ten_pop( ten );
+    
+    return agr;
+}
+
+// The bulk transforms work on sequence records, which keep
+// their values under the keys `0` through `n - 1` and end at
+// the first key without a value; or on packed vectors.  The
+// functions they call are invoked through `fibCallPushed()`,
+// which passes the arguments in place instead of copying them
+// into a new tuple or collecting them in a variadic record.
+static void
+seqExpectArity( State* state, Closure* fun, uint argc ) {
+    uint parc = fun->fun->nParams;
+    if( argc < parc || ( argc > parc && !fun->fun->vargIdx ) )
+        panic( "Passed function takes %u parameters, need %u", parc, argc );
+}
+
+// The result isn't rooted, so should be stored before the
+// next allocation.
+static TVal
+seqCall( State* state, Closure* fun, uint argc, TVal arg1, TVal arg2 ) {
+    Tup args = fibPushCall( state, fun, argc );
+    tupSet( args, 0, arg1 );
+    if( argc > 1 )
+        tupSet( args, 1, arg2 );
+    
+    Tup rets = fibCallPushed( state, argc );
+    if( rets.size != 1 )
+        panic( "Passed function returned tuple" );
+    
+    TVal ret = tupGet( rets, 0 );
+    statePop( state );
+    return ret;
+}
+
+static TVal
+seqGet( State* state, TVal seq, size_t i ) {
+    if( tvIsObjType( seq, OBJ_REC ) )
+        return recGet( state, tvGetObj( seq ), tvInt( i ) );
+    
+    Data* vec = tvGetObj( seq );
+    if( i >= libVecLen( state, vec ) )
+        return tvUdf();
+    return libVecGet( state, vec, i );
+}
+
+// Sequence results are new records, each with its own Index,
+// or new vectors of the same type as the input.
+static void
+seqNew( State* state, TVal seq, ten_Var* dst ) {
+    if( tvIsObjType( seq, OBJ_REC ) ) {
+        varSet( *dst, tvObj( idxNew( state ) ) );
+        varSet( *dst, tvObj( recNew( state, tvGetObj( varGet( *dst ) ) ) ) );
+    }
+    else {
+        Data* vec = tvGetObj( seq );
+        varSet( *dst, tvObj( libVec( state, libVecIsDec( state, vec ), 0 ) ) );
+    }
+}
+
+static void
+seqAdd( State* state, TVal seq, size_t i, TVal val ) {
+    if( tvIsObjType( seq, OBJ_REC ) )
+        recDef( state, tvGetObj( seq ), tvInt( i ), val );
+    else
+        libVecPush( state, tvGetObj( seq ), val );
+}
+
+typedef enum {
+    SORT_NUM,
+    SORT_STR,
+    SORT_SYM,
+    SORT_FUN
+} SortKind;
+
+typedef struct {
+    Defer    base;
+    SortKind kind;
+    Closure* less;
+    TVal*    buf;
+    size_t   len;
+} SortState;
+
+static void
+freeSortDefer( State* state, Defer* d ) {
+    SortState* s = (SortState*)d;
+    stateFreeRaw( state, s->buf, sizeof(TVal)*s->len*2 );
+}
+
+static int
+bytesCmp( char const* buf1, size_t len1, char const* buf2, size_t len2 ) {
+    size_t len = len1 < len2 ? len1 : len2;
+    int    cmp = memcmp( buf1, buf2, len );
+    if( cmp == 0 )
+        return len1 < len2 ? -1 : len1 > len2;
+    return cmp;
+}
+
+static bool
+sortLess( State* state, SortState* s, TVal a, TVal b ) {
+    switch( s->kind ) {
+        case SORT_NUM: {
+            if( tvIsInt( a ) && tvIsInt( b ) )
+                return tvGetInt( a ) < tvGetInt( b );
+            DecT ad = tvIsInt( a ) ? tvGetInt( a ) : tvGetDec( a );
+            DecT bd = tvIsInt( b ) ? tvGetInt( b ) : tvGetDec( b );
+            return ad < bd;
+        }
+        case SORT_STR: {
+            String* as = tvGetObj( a );
+            String* bs = tvGetObj( b );
+            return bytesCmp( as->buf, as->len, bs->buf, bs->len ) < 0;
+        }
+        case SORT_SYM: {
+            // Short symbols are packed into the SymT itself, and
+            // `symBuf()` unpacks them to a shared buffer; so the
+            // first has to be copied out before the second.
+            SymT   as   = tvGetSym( a );
+            SymT   bs   = tvGetSym( b );
+            size_t alen = symLen( state, as );
+            
+            char        abuf[sizeof(SymT)];
+            char const* astr = symBuf( state, as );
+            if( alen < sizeof(SymT) )
+                astr = memcpy( abuf, astr, alen );
+            
+            return bytesCmp( astr, alen, symBuf( state, bs ), symLen( state, bs ) ) < 0;
+        }
+        default: {
+            TVal r = seqCall( state, s->less, 2, a, b );
+            if( !tvIsLog( r ) )
+                panic( "Comparator returned non-Log type %t", r );
+            return tvGetLog( r );
+        }
+    }
+    tenAssertNeverReached();
+    return false;
+}
+
+// Picks the native comparison for the values, if they're all
+// numbers, all strings, or all symbols.
+static SortKind
+sortKind( State* state, TVal* vals, size_t len ) {
+    if( len == 0 )
+        return SORT_NUM;
+    
+    SortKind kind = SORT_NUM;
+    if( tvIsInt( vals[0] ) || tvIsDec( vals[0] ) )
+        kind = SORT_NUM;
+    else
+    if( tvIsObjType( vals[0], OBJ_STR ) )
+        kind = SORT_STR;
+    else
+    if( tvIsSym( vals[0] ) )
+        kind = SORT_SYM;
+    else
+        panic( "Values of type %t can't be sorted without a comparator", vals[0] );
+    
+    for( size_t i = 1 ; i < len ; i++ ) {
+        TVal v  = vals[i];
+        bool ok = false;
+        switch( kind ) {
+            case SORT_NUM: ok = tvIsInt( v ) || tvIsDec( v ); break;
+            case SORT_STR: ok = tvIsObjType( v, OBJ_STR );    break;
+            default:       ok = tvIsSym( v );                 break;
+        }
+        if( !ok )
+            panic( "Values of types %t and %t can't be sorted without a comparator", vals[0], v );
+    }
+    return kind;
+}
+
+#define SORT_RUN (8)
+
+// A bottom up merge sort, stable since a value is only
+// placed before those preceding it when strictly less.
+// Runs of SORT_RUN values are insertion sorted first.
+// Returns the array holding the result, either `vals`
+// or `tmp`.
+static TVal*
+mergeSort( State* state, SortState* s, TVal* vals, TVal* tmp, size_t len ) {
+    for( size_t lo = 0 ; lo < len ; lo += SORT_RUN ) {
+        size_t hi = lo + SORT_RUN < len ? lo + SORT_RUN : len;
+        for( size_t i = lo + 1 ; i < hi ; i++ ) {
+            TVal   v = vals[i];
+            size_t j = i;
+            while( j > lo && sortLess( state, s, v, vals[j-1] ) ) {
+                vals[j] = vals[j-1];
+                j--;
+            }
+            vals[j] = v;
+        }
+    }
+    
+    TVal* src = vals;
+    TVal* dst = tmp;
+    for( size_t w = SORT_RUN ; w < len ; w *= 2 ) {
+        for( size_t lo = 0 ; lo < len ; lo += 2*w ) {
+            size_t mid = lo + w < len ? lo + w : len;
+            size_t hi  = lo + 2*w < len ? lo + 2*w : len;
+            
+            size_t i = lo, j = mid, k = lo;
+            while( i < mid && j < hi ) {
+                if( sortLess( state, s, src[j], src[i] ) )
+                    dst[k++] = src[j++];
+                else
+                    dst[k++] = src[i++];
+            }
+            while( i < mid )
+                dst[k++] = src[i++];
+            while( j < hi )
+                dst[k++] = src[j++];
+        }
+        TVal* t = src;
+        src = dst;
+        dst = t;
+    }
+    return src;
+}
+
+TVal
+libSort( State* state, TVal seq, Closure* less ) {
+    ten_State* ten = (ten_State*)state;
+    
+    if( less )
+        seqExpectArity( state, less, 2 );
+    
+    ten_Tup varTup = ten_pushA( ten, "U" );
+    ten_Var outVar = ten_var( varTup, 0 );
+    seqNew( state, seq, &outVar );
+    
+    // Numbers in a vector can go straight to the kernel.
+    if( !tvIsObjType( seq, OBJ_REC ) && !less ) {
+        Data*  vec = tvGetObj( seq );
+        Data*  out = tvGetObj( varGet( outVar ) );
+        size_t len = libVecLen( state, vec );
+        libVecResize( state, out, len );
+        
+        size_t sz = len*( libVecIsDec( state, vec ) ? sizeof(DecT) : sizeof(IntT) );
+        if( len > 0 )
+            memcpy( libVecValues( state, out ), libVecValues( state, vec ), sz );
+        libVecSort( state, out );
+        
+        ten_pop( ten );
+        return tvObj( out );
+    }
+    
+    // The values are first copied to the result in their
+    // original order, this keeps them alive while they're
+    // sorted in the raw arrays; which don't get traversed
+    // by the collector.
+    size_t len = 0;
+    TVal   val = seqGet( state, seq, len );
+    while( !tvIsUdf( val ) ) {
+        seqAdd( state, varGet( outVar ), len++, val );
+        val = seqGet( state, seq, len );
+    }
+    
+    TVal out = varGet( outVar );
+    if( len < 2 ) {
+        ten_pop( ten );
+        return out;
+    }
+    
+    Part bufP;
+    TVal* buf = stateAllocRaw( state, &bufP, sizeof(TVal)*len*2 );
+    for( size_t i = 0 ; i < len ; i++ )
+        buf[i] = seqGet( state, out, i );
+    stateCommitRaw( state, &bufP );
+    
+    SortState s = { .base = { .cb = freeSortDefer }, .less = less, .buf = buf, .len = len };
+    stateInstallDefer( state, (Defer*)&s );
+    
+    s.kind = less ? SORT_FUN : sortKind( state, buf, len );
+    TVal* sorted = mergeSort( state, &s, buf, buf + len, len );
+    
+    if( tvIsObjType( out, OBJ_REC ) ) {
+        for( size_t i = 0 ; i < len ; i++ )
+            recSet( state, tvGetObj( out ), tvInt( i ), sorted[i] );
+    }
+    else {
+        for( size_t i = 0 ; i < len ; i++ )
+            libVecSet( state, tvGetObj( out ), i, sorted[i] );
+    }
+    
+    stateCommitDefer( state, (Defer*)&s );
+    
+    ten_pop( ten );
+    return out;
+}
+
+TVal
+libMap( State* state, TVal seq, Closure* fun ) {
+    ten_State* ten = (ten_State*)state;
+    seqExpectArity( state, fun, 1 );
+    
+    ten_Tup varTup = ten_pushA( ten, "UU" );
+    ten_Var outVar = ten_var( varTup, 0 );
+    ten_Var valVar = ten_var( varTup, 1 );
+    seqNew( state, seq, &outVar );
+    
+    size_t i   = 0;
+    TVal   val = seqGet( state, seq, i );
+    while( !tvIsUdf( val ) ) {
+        varSet( valVar, seqCall( state, fun, 1, val, tvUdf() ) );
+        if( tvIsUdf( varGet( valVar ) ) )
+            panic( "Passed function returned `udf`" );
+        
+        seqAdd( state, varGet( outVar ), i++, varGet( valVar ) );
+        val = seqGet( state, seq, i );
+    }
+    
+    TVal out = varGet( outVar );
+    ten_pop( ten );
+    return out;
+}
+
+TVal
+libFilter( State* state, TVal seq, Closure* pred ) {
+    ten_State* ten = (ten_State*)state;
+    seqExpectArity( state, pred, 1 );
+    
+    ten_Tup varTup = ten_pushA( ten, "UU" );
+    ten_Var outVar = ten_var( varTup, 0 );
+    ten_Var valVar = ten_var( varTup, 1 );
+    seqNew( state, seq, &outVar );
+    
+    size_t i = 0;
+    size_t n = 0;
+    varSet( valVar, seqGet( state, seq, i ) );
+    while( !tvIsUdf( varGet( valVar ) ) ) {
+        TVal keep = seqCall( state, pred, 1, varGet( valVar ), tvUdf() );
+        if( !tvIsLog( keep ) )
+            panic( "Predicate returned non-Log type %t", keep );
+        
+        if( tvGetLog( keep ) )
+            seqAdd( state, varGet( outVar ), n++, varGet( valVar ) );
+        varSet( valVar, seqGet( state, seq, ++i ) );
+    }
+    
+    TVal out = varGet( outVar );
+    ten_pop( ten );
+    return out;
+}
+
+TVal
+libReduce( State* state, TVal seq, TVal agr, Closure* how ) {
+    ten_State* ten = (ten_State*)state;
+    seqExpectArity( state, how, 2 );
+    
+    ten_Tup varTup = ten_pushA( ten, "U" );
+    ten_Var agrVar = ten_var( varTup, 0 );
+    varSet( agrVar, agr );
+    
+    size_t i   = 0;
+    TVal   val = seqGet( state, seq, i );
+    while( !tvIsUdf( val ) ) {
+        varSet( agrVar, seqCall( state, how, 2, varGet( agrVar ), val ) );
+        val = seqGet( state, seq, ++i );
+    }
+    
+    agr = varGet( agrVar );
+    ten_pop( ten );
+    return agr;
+}
+
+
+Record*
+libSep( State* state, Record* rec ) {
+    recSep( state, rec );
+    return rec;
+}
+
+// List cells are fixed size records sharing `lib->cellIdx`,
+// which holds its own reference to the `car` and `cdr` keys;
+// so the values can be put directly in their slots without
+// a lookup.  While a cell still uses this Index its values
+// can be read the same way, any `def` to the cell will give
+// it an Index of its own, since cells are separated.
+Record*
+libCons( State* state, TVal car, TVal cdr ) {
+    LibState* lib = state->libState;
+    
+    Record* rec  = recNewFixed( state, lib->cellIdx );
+    TVal*   vals = recVals( rec );
+    
+    vals[lib->carLoc] = car;
+    vals[lib->cdrLoc] = cdr;
+    idxAddByLoc( state, lib->cellIdx, lib->carLoc );
+    idxAddByLoc( state, lib->cellIdx, lib->cdrLoc );
+    
+    recSep( state, rec );
+    return rec;
 }
 
 Record*
@@ -1912,7 +3259,7 @@ libList( State* state, Record* vals ) {
     v = recGet( state, vals, tvInt( i++ ) );
     while( !tvIsUdf( v ) ) {
         Record* cell = libCons( state, v, tvNil() );
-        recDef( state, tail, tvSym( lib->idents[IDENT_cdr] ), tvObj( cell ) );
+        ((TVal*)recVals( tail ))[lib->cdrLoc] = tvObj( cell );
         
         tail = cell;
         v = recGet( state, vals, tvInt( i++ ) );
@@ -1948,7 +3295,7 @@ libExplode( State* state, Closure* iter ) {
             ten_panic( ten, ten_str( ten, "Iterator returned tuple" ) );
         
         Record* cell = libCons( state, varGet(retVar), tvNil() );
-        recDef( state, tail, tvSym( lib->idents[IDENT_cdr] ), tvObj( cell ) );
+        ((TVal*)recVals( tail ))[lib->cdrLoc] = tvObj( cell );
         
         tail = cell;
         ten_pop( ten );
@@ -2155,7 +3502,7 @@ libScript( State* state, Record* upvals, String* script ) {
     ten_Tup varTup = ten_pushA( ten, "U" );
     ten_Var clsVar = ten_var( varTup, 0 );
     
-    ten_Source* src = ten_stringSource( ten, script->buf, "<unknown>" );
+    ten_Source* src = ten_stringSource( ten, strBuf( state, script ), "<unknown>" );
     ten_compileScript( ten, (char const**)names, src, ten_SCOPE_LOCAL, ten_COM_CLS, &clsVar );
     
     stateCommitDefer( state, (Defer*)&defer );
@@ -2191,7 +3538,7 @@ libExpr( State* state, Record* upvals, String* script ) {
     ten_Tup varTup = ten_pushA( ten, "U" );
     ten_Var clsVar = ten_var( varTup, 0 );
     
-    ten_Source* src = ten_stringSource( ten, script->buf, "<unknown>" );
+    ten_Source* src = ten_stringSource( ten, strBuf( state, script ), "<unknown>" );
     ten_compileExpr( ten, (char const**)names, src, ten_SCOPE_LOCAL, ten_COM_CLS, &clsVar );
     
     stateCommitDefer( state, (Defer*)&defer );
@@ -2265,7 +3612,7 @@ ten_define(pumpNext) {
     Tup  args = statePush( state, 0 );
     TVal val  = tvUdf();
     while( tvIsUdf( val ) ) {
-        Tup rets = fibCall( state, iter, &args );
+        Tup rets = libNext( state, iter, &args );
         if( rets.size != 1 )
             panic( "Iterator returned tuple" );
         
@@ -2278,6 +3625,8 @@ ten_define(pumpNext) {
         
         val = libPipe( state, val, pipeline );
     }
+    statePop( state ); // args
+    
     if( tvIsNil( val ) )
         pump->done = true;
     
@@ -2304,12 +3653,7 @@ libPump( State* state, Closure* iter, Record* pipeline ) {
     varSet( tmpVar, tvObj( pipeline ) );
     ten_setMember( ten, &datVar, Pump_PIPELINE, &tmpVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "pump%llu", (ullong)(uintptr_t)pump ),
-        .params = NULL,
-        .cb     = ten_fun(pumpNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_pump] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -2337,8 +3681,10 @@ ten_define(limiterNext) {
     
     Closure* iter = tvGetObj( varGet( ten_mem( Limiter_ITER ) ) );
     
-    Tup args = statePush( state, 0 );
-    return impToApiTup( fibCall( state, iter, &args ) );
+    // The call's own arguments are an empty tuple, so
+    // they can be reused for the inner iterator.
+    Tup args = *(Tup*)&call->args;
+    return impToApiTup( libNext( state, iter, &args ) );
 }
 
 static Closure*
@@ -2358,12 +3704,7 @@ libLimit( State* state, Closure* iter, uint lim ) {
     varSet( tmpVar, tvObj( iter ) );
     ten_setMember( ten, &datVar, Limiter_ITER, &tmpVar );
     
-    ten_FunParams p = {
-        .name   = fmtA( state, false, "limit%llu", (ullong)(uintptr_t)limit ),
-        .params = NULL,
-        .cb     = ten_fun(limiterNext)
-    };
-    ten_newFun( ten, &p, &funVar );
+    varSet( funVar, tvObj( lib->nexts[NEXT_limit] ) );
     ten_newCls( ten, &funVar, &datVar, &clsVar );
     
     Closure* cls = tvGetObj( varGet( clsVar ) );
@@ -2379,7 +3720,7 @@ libSkip( State* state, Closure* iter, uint num ) {
     
     Tup args = statePush( state, 0 );
     for( uint i = 0 ; i < num ; i++ ) {
-        fibCall( state, iter, &args );
+        libNext( state, iter, &args );
         statePop( state );
     }
     statePop( state );
@@ -2387,9 +3728,113 @@ libSkip( State* state, Closure* iter, uint num ) {
     return iter;
 }
 
+typedef struct {
+    Job* job;
+    Msg* res;
+    bool failed;
+} Future;
+
+static void
+futureDestr( void* dat ) {
+    Future* fut = dat;
+    if( fut->job )
+        jobRelease( fut->job );
+    if( fut->res )
+        msgFree( fut->res );
+}
+
+static void
+libSubmit( State* state, TVal fun, Record* args, ten_Var* dst ) {
+    LibState*  lib  = state->libState;
+    ten_State* ten  = (ten_State*)state;
+    Pool*      pool = (Pool*)state->config.pool;
+    if( !pool )
+        panic( "No worker pool" );
+    
+    // Create the future first so that, once submitted, the
+    // job is always owned by something.
+    Future* fut = ten_newDat( ten, lib->futureInfo, dst );
+    fut->job    = NULL;
+    fut->res    = NULL;
+    fut->failed = false;
+    
+    uint count = 0;
+    TVal val   = recGet( state, args, tvInt( count ) );
+    while( !tvIsUdf( val ) ) {
+        val = recGet( state, args, tvInt( ++count ) );
+    }
+    
+    Tup reqTup = statePush( state, count + 1 );
+    tupSet( reqTup, 0, fun );
+    for( uint i = 0 ; i < count ; i++ )
+        tupSet( reqTup, i + 1, recGet( state, args, tvInt( i ) ) );
+    
+    Msg* req = msgPack( state, &reqTup );
+    statePop( state ); // reqTup
+    
+    fut->job = poolSubmit( pool, req );
+    if( !fut->job ) {
+        msgFree( req );
+        stateErrVal( state, ten_ERR_FATAL, state->errOutOfMem );
+    }
+}
+
+static Tup
+libAwait( State* state, Future* fut ) {
+    if( fut->job ) {
+        fut->res = jobWait( fut->job, &fut->failed );
+        jobRelease( fut->job );
+        fut->job = NULL;
+    }
+    
+    if( !fut->res )
+        panic( "Submitted job failed" );
+    
+    // Each await unpacks a fresh copy of the results, so
+    // the future can be awaited any number of times.
+    Tup rets = msgUnpack( state, fut->res );
+    if( fut->failed )
+        libPanic( state, tupGet( rets, 0 ) );
+    
+    return rets;
+}
+
+static bool
+libReady( State* state, Future* fut ) {
+    return !fut->job || jobDone( fut->job );
+}
+
+static uint
+libWorkers( State* state ) {
+    return ten_workers( state->config.pool );
+}
+
 #define expectArg( ARG, TYPE ) \
     libExpect( state, #ARG, state->libState->types[TYPE], varGet( ARG ## Arg ) ) 
 
+#define expectVal( ARG, TYPE ) \
+    libExpect( state, #ARG, state->libState->types[TYPE], ARG ## Val )
+
+// Prelude functions with a fixed number of parameters and a
+// single result are defined as fast natives, see `FastCb`.  The
+// interpreter calls the `lf_` callback directly, the `ten_Call`
+// wrapper is used for calls made through the API, and to tell
+// the function apart in messages.
+#define fast_define( NAME )                                                 \
+    static TVal lf_ ## NAME( State* state, TVal* args );                    \
+    ten_define( NAME ) {                                                    \
+        State* state = (State*)call->ten;                                   \
+                                                                            \
+        ten_Tup retTup = ten_pushA( call->ten, "U" );                       \
+        ten_Var retVar = ten_var( retTup, 0 );                              \
+                                                                            \
+        Tup  args = *(Tup*)&call->args;                                     \
+        TVal ret  = lf_ ## NAME( state, *args.base + args.offset );         \
+        varSet( retVar, ret );                                              \
+        return retTup;                                                      \
+    }                                                                       \
+    static TVal lf_ ## NAME( State* state, TVal* args )
+
 ten_define(require) {
     State* state = (State*)call->ten;
     
@@ -2415,16 +3860,10 @@ ten_define(import) {
     return retTup;
 }
 
-ten_define(type) {
-    State* state = (State*)call->ten;
-    
-    ten_Var valArg = ten_arg( 0 );
-    
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+fast_define( type ) {
+    TVal valVal = args[0];
     
-    varSet( retVar, tvSym( libType( state, varGet( valArg ) ) ) );
-    return retTup;
+    return tvSym( libType( state, valVal ) );
 }
 
 ten_define(panic) {
@@ -2462,7 +3901,7 @@ ten_define(expect) {
     expectArg( type, VAL_SYM );
     SymT type = tvGetSym( varGet( typeArg ) );
     
-    libExpect( state, what->buf, type, varGet( valArg ) );
+    libExpect( state, strBuf( state, what ), type, varGet( valArg ) );
     
     return ten_pushA( call->ten, "" );
 }
@@ -2502,562 +3941,906 @@ ten_define(loader) {
     
     libLoader( state, type, loadr, trans );
     
-    return ten_pushA( call->ten, "" );
+    return ten_pushA( call->ten, "" );
+}
+
+fast_define( clock ) {
+    return tvDec( libClock( state ) );
+}
+
+fast_define( wclock ) {
+    return tvDec( libWclock( state ) );
+}
+
+fast_define( rand ) {
+    return tvDec( libRand( state ) );
+}
+
+fast_define( log ) {
+    TVal valVal = args[0];
+    
+    return libLog( state, valVal );
+}
+
+fast_define( int ) {
+    TVal valVal = args[0];
+    
+    return libInt( state, valVal );
+}
+
+fast_define( dec ) {
+    TVal valVal = args[0];
+    
+    return libDec( state, valVal );
+}
+
+fast_define( sym ) {
+    TVal valVal = args[0];
+    
+    return libSym( state, valVal );
+}
+
+fast_define( str ) {
+    TVal valVal = args[0];
+    
+    return libStr( state, valVal );
+}
+
+fast_define( hex ) {
+    TVal strVal = args[0];
+    expectVal( str, OBJ_STR );
+    
+    return libHex( state, tvGetObj( strVal ) );
+}
+
+fast_define( oct ) {
+    TVal strVal = args[0];
+    expectVal( str, OBJ_STR );
+    
+    return libOct( state, tvGetObj( strVal ) );
+}
+
+fast_define( bin ) {
+    TVal strVal = args[0];
+    expectVal( str, OBJ_STR );
+    
+    return libBin( state, tvGetObj( strVal ) );
+}
+
+fast_define( keys ) {
+    TVal recVal = args[0];
+    expectVal( rec, OBJ_REC );
+    
+    return tvObj( libKeys( state, tvGetObj( recVal ) ) );
+}
+
+fast_define( vals ) {
+    TVal recVal = args[0];
+    expectVal( rec, OBJ_REC );
+    
+    return tvObj( libVals( state, tvGetObj( recVal ) ) );
+}
+
+fast_define( pairs ) {
+    TVal recVal = args[0];
+    expectVal( rec, OBJ_REC );
+    
+    return tvObj( libPairs( state, tvGetObj( recVal ) ) );
+}
+
+ten_define(seq) {
+    State* state = (State*)call->ten;
+    
+    ten_Var valsArg = ten_arg( 0 );
+    tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
+    
+    ten_Tup retTup = ten_pushA( call->ten, "U" );
+    ten_Var retVar = ten_var( retTup, 0 );
+    
+    Closure* cls = libSeq( state, tvGetObj( varGet( valsArg ) ) );
+    varSet( retVar, tvObj( cls ) );
+    
+    return retTup;
+}
+
+fast_define( rseq ) {
+    TVal valsVal = args[0];
+    expectVal( vals, OBJ_REC );
+    
+    return tvObj( libSeq( state, tvGetObj( valsVal ) ) );
+}
+
+fast_define( bytes ) {
+    TVal strVal = args[0];
+    expectVal( str, OBJ_STR );
+    
+    return tvObj( libBytes( state, tvGetObj( strVal ) ) );
+}
+
+fast_define( chars ) {
+    TVal strVal = args[0];
+    expectVal( str, OBJ_STR );
+    
+    return tvObj( libChars( state, tvGetObj( strVal ) ) );
+}
+
+fast_define( split ) {
+    TVal strVal = args[0];
+    TVal sepVal = args[1];
+    expectVal( str, OBJ_STR );
+    expectVal( sep, OBJ_STR );
+    
+    return tvObj( libSplit( state, tvGetObj( strVal ), tvGetObj( sepVal ) ) );
 }
 
-ten_define(clock) {
-    State* state = (State*)call->ten;
+fast_define( splits ) {
+    TVal strVal = args[0];
+    TVal sepVal = args[1];
+    expectVal( str, OBJ_STR );
+    expectVal( sep, OBJ_STR );
     
-    return ten_pushA( call->ten, "D", libClock( state ) );
+    return tvObj( libSplits( state, tvGetObj( strVal ), tvGetObj( sepVal ) ) );
 }
 
-ten_define(rand) {
-    State* state = (State*)call->ten;
+
+fast_define( items ) {
+    TVal listVal = args[0];
+    expectVal( list, OBJ_REC );
     
-    return ten_pushA( call->ten, "D", libRand( state ) );
+    return tvObj( libItems( state, tvGetObj( listVal ) ) );
 }
 
-ten_define(log) {
+ten_define(drange) {
     State* state = (State*)call->ten;
     
-    ten_Var valArg = ten_arg( 0 );
+    ten_Var startArg = ten_arg( 0 );
+    ten_Var endArg   = ten_arg( 1 );
+    ten_Var optArg   = ten_arg( 2 );
     
-    ten_Tup retTup = ten_pushA( (ten_State*)state, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    expectArg( start, VAL_DEC );
+    expectArg( end, VAL_DEC );
+    tenAssert( tvIsObjType( varGet( optArg ), OBJ_REC ) );
     
-    varSet( retVar, libLog( state, varGet( valArg ) ) );
-    return retTup;
-}
-
-ten_define(int) {
-    State* state = (State*)call->ten;
+    DecT start = tvGetDec( varGet( startArg ) );
+    DecT end   = tvGetDec( varGet( endArg ) );
+    DecT step  = end >= start ? 1.0 : -1.0;
     
-    ten_Var valArg = ten_arg( 0 );
+    Record*  opt = tvGetObj( varGet( optArg ) );
+    TVal opt0 = recGet( state, opt, tvInt( 0 ) );
+    if( !tvIsUdf( opt0 ) ) {
+        if( !tvIsDec( opt0 ) )
+            panic( "DRange step has non-Dec type" );
+        step = tvGetDec( opt0 );
+    }
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
-    
-    varSet( retVar, libInt( state, varGet( valArg ) ) );
+    varSet( retVar, tvObj( libDrange( state, start, end, step ) ) );
+
     return retTup;
 }
 
-ten_define(dec) {
+ten_define(irange) {
     State* state = (State*)call->ten;
     
-    ten_Var valArg = ten_arg( 0 );
+    ten_Var startArg = ten_arg( 0 );
+    ten_Var endArg   = ten_arg( 1 );
+    ten_Var optArg   = ten_arg( 2 );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    expectArg( start, VAL_INT );
+    expectArg( end, VAL_INT );
+    tenAssert( tvIsObjType( varGet( optArg ), OBJ_REC ) );
     
-    varSet( retVar, libDec( state, varGet( valArg ) ) );
-    return retTup;
-}
-
-ten_define(sym) {
-    State* state = (State*)call->ten;
+    IntT start = tvGetInt( varGet( startArg ) );
+    IntT end   = tvGetInt( varGet( endArg ) );
+    IntT step  = end >= start ? 1 : -1;
     
-    ten_Var valArg = ten_arg( 0 );
+    Record*  opt = tvGetObj( varGet( optArg ) );
+    TVal opt0 = recGet( state, opt, tvInt( 0 ) );
+    if( !tvIsUdf( opt0 ) ) {
+        if( !tvIsInt( opt0 ) )
+            panic( "IRange step has non-Int type" );
+        step = tvGetInt( opt0 );
+    }
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
-    
-    varSet( retVar, libSym( state, varGet( valArg ) ) );
+    varSet( retVar, tvObj( libIrange( state, start, end, step ) ) );
+
     return retTup;
 }
 
-ten_define(str) {
+ten_define(show) {
     State* state = (State*)call->ten;
+    ten_Var valsArg = ten_arg( 0 );
     
-    ten_Var valArg = ten_arg( 0 );
+    tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    libShow( state, tvGetObj( varGet( valsArg ) ) );
     
-    varSet( retVar, libStr( state, varGet( valArg ) ) );
-    return retTup;
+    return ten_pushA( call->ten, "" );
 }
 
-ten_define(hex) {
+ten_define(warn){
     State* state = (State*)call->ten;
+    ten_Var valsArg = ten_arg( 0 );
     
-    ten_Var strArg = ten_arg( 0 );
-    expectArg( str, OBJ_STR );
+    tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    libWarn( state, tvGetObj( varGet( valsArg ) ) );
     
-    varSet( retVar, libHex( state, tvGetObj( varGet( strArg ) ) ) );
-    return retTup;
+    return ten_pushA( call->ten, "" );
 }
 
-ten_define(oct) {
+ten_define(input) {
     State* state = (State*)call->ten;
     
-    ten_Var strArg = ten_arg( 0 );
-    expectArg( str, OBJ_STR );
-    
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
     
-    varSet( retVar, libOct( state, tvGetObj( varGet( strArg ) ) ) );
+    String* str = libInput( state );
+    varSet( retVar, tvObj( str ) );
+    
     return retTup;
 }
 
-ten_define(bin) {
-    State* state = (State*)call->ten;
-    
-    ten_Var strArg = ten_arg( 0 );
-    expectArg( str, OBJ_STR );
+fast_define( ucode ) {
+    TVal chrVal = args[0];
+    expectVal( chr, VAL_SYM );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    return libUcode( state, tvGetSym( chrVal ) );
+}
+
+fast_define( uchar ) {
+    TVal codeVal = args[0];
+    expectVal( code, VAL_INT );
     
-    varSet( retVar, libBin( state, tvGetObj( varGet( strArg ) ) ) );
-    return retTup;
+    return libUchar( state, tvGetInt( codeVal ) );
 }
 
-ten_define(keys) {
+ten_define(cat) {
     State* state = (State*)call->ten;
     
-    ten_Var recArg = ten_arg( 0 );
-    expectArg( rec, OBJ_REC );
+    ten_Var valsArg = ten_arg( 0 );
+    tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
     
-    Closure* cls = libKeys( state, tvGetObj( varGet( recArg ) ) );
-    varSet( retVar, tvObj( cls ) );
+    String* str = libCat( state, tvGetObj( varGet( valsArg ) ) );
+    varSet( retVar, tvObj( str ) );
+    
     return retTup;
 }
 
-ten_define(vals) {
+ten_define(join) {
     State* state = (State*)call->ten;
     
-    ten_Var recArg = ten_arg( 0 );
-    expectArg( rec, OBJ_REC );
+    ten_Var iterArg = ten_arg( 0 );
+    ten_Var sepArg  = ten_arg( 1 );
+    
+    expectArg( iter, OBJ_CLS );
+    expectArg( sep, OBJ_STR );
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
     
-    Closure* cls = libVals( state, tvGetObj( varGet( recArg ) ) );
-    varSet( retVar, tvObj( cls ) );
+    String* str = libJoin( state, tvGetObj( varGet( iterArg ) ), tvGetObj( varGet( sepArg ) ) );
+    varSet( retVar, tvObj( str ) );
     
     return retTup;
 }
 
-ten_define(pairs) {
+#define expectBld( ARG ) \
+    libExpect( state, #ARG, tvGetSym( ((DatInfo*)state->libState->builderInfo)->typeVal ), varGet( ARG ## Arg ) )
+#define expectBldVal( ARG ) \
+    libExpect( state, #ARG, tvGetSym( ((DatInfo*)state->libState->builderInfo)->typeVal ), ARG ## Val )
+
+fast_define( builder ) {
+    return tvObj( libBuilder( state ) );
+}
+
+ten_define(append) {
     State* state = (State*)call->ten;
     
-    ten_Var recArg = ten_arg( 0 );
-    expectArg( rec, OBJ_REC );
+    ten_Var bldArg  = ten_arg( 0 );
+    ten_Var valsArg = ten_arg( 1 );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    expectBld( bld );
+    tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
     
-    Closure* cls = libPairs( state, tvGetObj( varGet( recArg ) ) );
-    varSet( retVar, tvObj( cls ) );
+    Data*   bld  = tvGetObj( varGet( bldArg ) );
+    Record* vals = tvGetObj( varGet( valsArg ) );
     
-    return retTup;
+    uint i = 0;
+    TVal v = recGet( state, vals, tvInt( i++ ) );
+    while( !tvIsUdf( v ) ) {
+        libAppend( state, bld, v );
+        v = recGet( state, vals, tvInt( i++ ) );
+    }
+    
+    return ten_pushA( call->ten, "" );
 }
 
-ten_define(seq) {
+fast_define( build ) {
+    TVal bldVal = args[0];
+    expectBldVal( bld );
+    
+    return tvObj( libBuild( state, tvGetObj( bldVal ) ) );
+}
+
+#define expectBufVal( ARG ) \
+    libExpect( state, #ARG, tvGetSym( ((DatInfo*)state->libState->bufInfo)->typeVal ), ARG ## Val )
+
+fast_define( buffer ) {
+    return tvObj( libBuf( state ) );
+}
+
+ten_define(bufadd) {
     State* state = (State*)call->ten;
     
-    ten_Var valsArg = ten_arg( 0 );
+    ten_Var bufArg  = ten_arg( 0 );
+    ten_Var valsArg = ten_arg( 1 );
+    
+    TVal bufVal = varGet( bufArg );
+    expectBufVal( buf );
     tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    Data*   buf  = tvGetObj( bufVal );
+    Record* vals = tvGetObj( varGet( valsArg ) );
     
-    Closure* cls = libSeq( state, tvGetObj( varGet( valsArg ) ) );
-    varSet( retVar, tvObj( cls ) );
+    uint i = 0;
+    TVal v = recGet( state, vals, tvInt( i++ ) );
+    while( !tvIsUdf( v ) ) {
+        libBufAdd( state, buf, v );
+        v = recGet( state, vals, tvInt( i++ ) );
+    }
     
-    return retTup;
+    return ten_pushA( call->ten, "" );
 }
 
-ten_define(rseq) {
-    State* state = (State*)call->ten;
+fast_define( buflen ) {
+    TVal bufVal = args[0];
+    expectBufVal( buf );
     
-    ten_Var valsArg = ten_arg( 0 );
-    expectArg( vals, OBJ_REC );
-    
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
-    
-    Closure* cls = libSeq( state, tvGetObj( varGet( valsArg ) ) );
-    varSet( retVar, tvObj( cls ) );
+    return tvInt( libBufLen( state, tvGetObj( bufVal ) ) );
+}
+
+fast_define( bufget ) {
+    TVal bufVal = args[0];
+    TVal atVal  = args[1];
+    expectBufVal( buf );
+    expectVal( at, VAL_INT );
     
-    return retTup;
+    return libBufGet( state, tvGetObj( bufVal ), tvGetInt( atVal ) );
 }
 
-ten_define(bytes) {
+ten_define(bufset) {
     State* state = (State*)call->ten;
     
-    ten_Var strArg = ten_arg( 0 );
-    expectArg( str, OBJ_STR );
-    
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    ten_Var bufArg  = ten_arg( 0 );
+    ten_Var atArg   = ten_arg( 1 );
+    ten_Var byteArg = ten_arg( 2 );
     
-    Closure* cls = libBytes( state, tvGetObj( varGet( strArg ) ) );
-    varSet( retVar, tvObj( cls ) );
+    TVal bufVal  = varGet( bufArg );
+    TVal atVal   = varGet( atArg );
+    TVal byteVal = varGet( byteArg );
+    expectBufVal( buf );
+    expectVal( at, VAL_INT );
+    expectVal( byte, VAL_INT );
     
-    return retTup;
+    libBufSet( state, tvGetObj( bufVal ), tvGetInt( atVal ), tvGetInt( byteVal ) );
+    return ten_pushA( call->ten, "" );
 }
 
-ten_define(chars) {
+ten_define(bufcut) {
     State* state = (State*)call->ten;
     
-    ten_Var strArg = ten_arg( 0 );
-    expectArg( str, OBJ_STR );
+    ten_Var bufArg = ten_arg( 0 );
+    ten_Var nArg   = ten_arg( 1 );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    TVal bufVal = varGet( bufArg );
+    TVal nVal   = varGet( nArg );
+    expectBufVal( buf );
+    expectVal( n, VAL_INT );
     
-    Closure* cls = libChars( state, tvGetObj( varGet( strArg ) ) );
-    varSet( retVar, tvObj( cls ) );
-    return retTup;
+    libBufCut( state, tvGetObj( bufVal ), tvGetInt( nVal ) );
+    return ten_pushA( call->ten, "" );
+}
+
+fast_define( bufsub ) {
+    TVal bufVal = args[0];
+    TVal atVal  = args[1];
+    TVal nVal   = args[2];
+    expectBufVal( buf );
+    expectVal( at, VAL_INT );
+    expectVal( n, VAL_INT );
+    
+    return tvObj( libBufSub( state, tvGetObj( bufVal ), tvGetInt( atVal ), tvGetInt( nVal ) ) );
+}
+
+fast_define( bufstr ) {
+    TVal bufVal = args[0];
+    expectBufVal( buf );
+    
+    Data* buf = tvGetObj( bufVal );
+    return tvObj( libBufSub( state, buf, 0, libBufLen( state, buf ) ) );
 }
 
-ten_define(split) {
+ten_define(bufpack) {
     State* state = (State*)call->ten;
     
-    ten_Var strArg = ten_arg( 0 );
-    ten_Var sepArg = ten_arg( 1 );
-    expectArg( str, OBJ_STR );
-    expectArg( sep, OBJ_STR );
+    ten_Var bufArg  = ten_arg( 0 );
+    ten_Var atArg   = ten_arg( 1 );
+    ten_Var typeArg = ten_arg( 2 );
+    ten_Var valArg  = ten_arg( 3 );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    TVal bufVal  = varGet( bufArg );
+    TVal atVal   = varGet( atArg );
+    TVal typeVal = varGet( typeArg );
+    TVal valVal  = varGet( valArg );
+    expectBufVal( buf );
+    expectVal( at, VAL_INT );
+    expectVal( type, VAL_SYM );
     
-    Closure* cls = libSplit( state, tvGetObj( varGet( strArg ) ), tvGetObj( varGet( sepArg ) ) );
-    varSet( retVar, tvObj( cls ) );
-    return retTup;
+    libBufPack( state, tvGetObj( bufVal ), tvGetInt( atVal ), tvGetSym( typeVal ), valVal );
+    return ten_pushA( call->ten, "" );
 }
 
-
-ten_define(items) {
-    State* state = (State*)call->ten;
+fast_define( bufunpack ) {
+    TVal bufVal  = args[0];
+    TVal atVal   = args[1];
+    TVal typeVal = args[2];
+    expectBufVal( buf );
+    expectVal( at, VAL_INT );
+    expectVal( type, VAL_SYM );
     
-    ten_Var listArg = ten_arg( 0 );
-    expectArg( list, OBJ_REC );
+    return libBufUnpack( state, tvGetObj( bufVal ), tvGetInt( atVal ), tvGetSym( typeVal ) );
+}
+
+#define expectVecVal( ARG ) \
+    libExpect( state, #ARG, tvGetSym( ((DatInfo*)state->libState->vecInfo)->typeVal ), ARG ## Val )
+
+fast_define( vec ) {
+    LibState* lib = state->libState;
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    TVal typeVal = args[0];
+    TVal lenVal  = args[1];
+    expectVal( type, VAL_SYM );
+    expectVal( len, VAL_INT );
     
-    Closure* cls = libItems( state, tvGetObj( varGet( listArg ) ) );
-    varSet( retVar, tvObj( cls ) );
+    SymT type = tvGetSym( typeVal );
+    if( type != lib->types[VAL_INT] && type != lib->types[VAL_DEC] )
+        panic( "Given 'type' is not 'Int' or 'Dec'" );
+    if( tvGetInt( lenVal ) < 0 )
+        panic( "Given 'len' is negative" );
     
-    return retTup;
+    return tvObj( libVec( state, type == lib->types[VAL_DEC], tvGetInt( lenVal ) ) );
 }
 
-ten_define(drange) {
+ten_define(vecpush) {
     State* state = (State*)call->ten;
     
-    ten_Var startArg = ten_arg( 0 );
-    ten_Var endArg   = ten_arg( 1 );
-    ten_Var optArg   = ten_arg( 2 );
+    ten_Var vecArg  = ten_arg( 0 );
+    ten_Var valsArg = ten_arg( 1 );
     
-    expectArg( start, VAL_DEC );
-    expectArg( end, VAL_DEC );
-    tenAssert( tvIsObjType( varGet( optArg ), OBJ_REC ) );
+    TVal vecVal = varGet( vecArg );
+    expectVecVal( vec );
+    tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
     
-    DecT start = tvGetDec( varGet( startArg ) );
-    DecT end   = tvGetDec( varGet( endArg ) );
-    DecT step  = end >= start ? 1.0 : -1.0;
+    Data*   vec  = tvGetObj( vecVal );
+    Record* vals = tvGetObj( varGet( valsArg ) );
     
-    Record*  opt = tvGetObj( varGet( optArg ) );
-    TVal opt0 = recGet( state, opt, tvInt( 0 ) );
-    if( !tvIsUdf( opt0 ) ) {
-        if( !tvIsDec( opt0 ) )
-            panic( "DRange step has non-Dec type" );
-        step = tvGetDec( opt0 );
+    uint i = 0;
+    TVal v = recGet( state, vals, tvInt( i++ ) );
+    while( !tvIsUdf( v ) ) {
+        libVecPush( state, vec, v );
+        v = recGet( state, vals, tvInt( i++ ) );
     }
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
-    varSet( retVar, tvObj( libDrange( state, start, end, step ) ) );
+    return ten_pushA( call->ten, "" );
+}
 
-    return retTup;
+fast_define( veclen ) {
+    TVal vecVal = args[0];
+    expectVecVal( vec );
+    
+    return tvInt( libVecLen( state, tvGetObj( vecVal ) ) );
 }
 
-ten_define(irange) {
+fast_define( vecget ) {
+    TVal vecVal = args[0];
+    TVal atVal  = args[1];
+    expectVecVal( vec );
+    expectVal( at, VAL_INT );
+    
+    return libVecGet( state, tvGetObj( vecVal ), tvGetInt( atVal ) );
+}
+
+ten_define(vecset) {
     State* state = (State*)call->ten;
     
-    ten_Var startArg = ten_arg( 0 );
-    ten_Var endArg   = ten_arg( 1 );
-    ten_Var optArg   = ten_arg( 2 );
+    ten_Var vecArg = ten_arg( 0 );
+    ten_Var atArg  = ten_arg( 1 );
+    ten_Var valArg = ten_arg( 2 );
     
-    expectArg( start, VAL_INT );
-    expectArg( end, VAL_INT );
-    tenAssert( tvIsObjType( varGet( optArg ), OBJ_REC ) );
+    TVal vecVal = varGet( vecArg );
+    TVal atVal  = varGet( atArg );
+    expectVecVal( vec );
+    expectVal( at, VAL_INT );
     
-    IntT start = tvGetInt( varGet( startArg ) );
-    IntT end   = tvGetInt( varGet( endArg ) );
-    IntT step  = end >= start ? 1 : -1;
+    libVecSet( state, tvGetObj( vecVal ), tvGetInt( atVal ), varGet( valArg ) );
+    return ten_pushA( call->ten, "" );
+}
+
+fast_define( vecsum ) {
+    TVal vecVal = args[0];
+    expectVecVal( vec );
     
-    Record*  opt = tvGetObj( varGet( optArg ) );
-    TVal opt0 = recGet( state, opt, tvInt( 0 ) );
-    if( !tvIsUdf( opt0 ) ) {
-        if( !tvIsInt( opt0 ) )
-            panic( "IRange step has non-Int type" );
-        step = tvGetInt( opt0 );
-    }
+    return libVecSum( state, tvGetObj( vecVal ) );
+}
+
+fast_define( vecmin ) {
+    TVal vecVal = args[0];
+    expectVecVal( vec );
+    
+    return libVecMin( state, tvGetObj( vecVal ) );
+}
+
+fast_define( vecmax ) {
+    TVal vecVal = args[0];
+    expectVecVal( vec );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
-    varSet( retVar, tvObj( libIrange( state, start, end, step ) ) );
+    return libVecMax( state, tvGetObj( vecVal ) );
+}
 
-    return retTup;
+fast_define( vecdot ) {
+    TVal vec1Val = args[0];
+    TVal vec2Val = args[1];
+    expectVecVal( vec1 );
+    expectVecVal( vec2 );
+    
+    return libVecDot( state, tvGetObj( vec1Val ), tvGetObj( vec2Val ) );
 }
 
-ten_define(show) {
+ten_define(vecscale) {
     State* state = (State*)call->ten;
-    ten_Var valsArg = ten_arg( 0 );
     
-    tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
+    ten_Var vecArg = ten_arg( 0 );
+    ten_Var kArg   = ten_arg( 1 );
     
-    libShow( state, tvGetObj( varGet( valsArg ) ) );
+    TVal vecVal = varGet( vecArg );
+    expectVecVal( vec );
     
+    libVecScale( state, tvGetObj( vecVal ), varGet( kArg ) );
     return ten_pushA( call->ten, "" );
 }
 
-ten_define(warn){
+ten_define(vecadd) {
     State* state = (State*)call->ten;
-    ten_Var valsArg = ten_arg( 0 );
     
-    tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
+    ten_Var vec1Arg = ten_arg( 0 );
+    ten_Var vec2Arg = ten_arg( 1 );
     
-    libWarn( state, tvGetObj( varGet( valsArg ) ) );
+    TVal vec1Val = varGet( vec1Arg );
+    TVal vec2Val = varGet( vec2Arg );
+    expectVecVal( vec1 );
+    expectVecVal( vec2 );
     
+    libVecAdd( state, tvGetObj( vec1Val ), tvGetObj( vec2Val ) );
     return ten_pushA( call->ten, "" );
 }
 
-ten_define(input) {
+fast_define( vecmask ) {
+    TVal vecVal = args[0];
+    TVal oprVal = args[1];
+    TVal xVal   = args[2];
+    expectVecVal( vec );
+    expectVal( opr, VAL_SYM );
+    
+    return tvObj( libVecMask( state, tvGetObj( vecVal ), tvGetSym( oprVal ), xVal ) );
+}
+
+ten_define(vecsort) {
     State* state = (State*)call->ten;
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    ten_Var vecArg = ten_arg( 0 );
     
-    String* str = libInput( state );
-    varSet( retVar, tvObj( str ) );
+    TVal vecVal = varGet( vecArg );
+    expectVecVal( vec );
     
-    return retTup;
+    libVecSort( state, tvGetObj( vecVal ) );
+    return ten_pushA( call->ten, "" );
 }
 
-ten_define(ucode) {
+ten_define(vecscan) {
     State* state = (State*)call->ten;
     
-    ten_Var chrArg = ten_arg( 0 );
-    expectArg( chr, VAL_SYM );
+    ten_Var vecArg = ten_arg( 0 );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
-    varSet( retVar, libUcode( state, tvGetSym( varGet( chrArg ) ) ) );
-    return retTup;
+    TVal vecVal = varGet( vecArg );
+    expectVecVal( vec );
+    
+    libVecScan( state, tvGetObj( vecVal ) );
+    return ten_pushA( call->ten, "" );
 }
 
-ten_define(uchar) {
+ten_define(decode) {
     State* state = (State*)call->ten;
     
-    ten_Var codeArg = ten_arg( 0 );
-    expectArg( code, VAL_INT );
+    ten_Var strArg = ten_arg( 0 );
+    expectArg( str, OBJ_STR );
+    
+    String* str = tvGetObj( varGet( strArg ) );
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
-    varSet( retVar, libUchar( state, tvGetInt( varGet( codeArg ) ) ) );
+    varSet( retVar, jsonDecode( state, NULL, str->buf, str->len ) );
+    
     return retTup;
 }
 
-ten_define(cat) {
+ten_define(encode) {
     State* state = (State*)call->ten;
     
-    ten_Var valsArg = ten_arg( 0 );
-    tenAssert( tvIsObjType( varGet( valsArg ), OBJ_REC ) );
+    ten_Var valArg = ten_arg( 0 );
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
-    
-    String* str = libCat( state, tvGetObj( varGet( valsArg ) ) );
-    varSet( retVar, tvObj( str ) );
+    varSet( retVar, tvObj( jsonEncode( state, varGet( valArg ) ) ) );
     
     return retTup;
 }
 
-ten_define(join) {
+#define expectJsonDecVal( ARG ) \
+    libExpect( state, #ARG, tvGetSym( ((DatInfo*)state->libState->jsonDecInfo)->typeVal ), ARG ## Val )
+
+ten_define(decoder) {
     State* state = (State*)call->ten;
     
-    ten_Var iterArg = ten_arg( 0 );
-    ten_Var sepArg  = ten_arg( 1 );
-    
-    expectArg( iter, OBJ_CLS );
-    expectArg( sep, OBJ_STR );
-    
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
-    
-    String* str = libJoin( state, tvGetObj( varGet( iterArg ) ), tvGetObj( varGet( sepArg ) ) );
-    varSet( retVar, tvObj( str ) );
+    varSet( retVar, tvObj( libJsonDecoder( state ) ) );
     
     return retTup;
 }
 
-ten_define(bcmp) {
+ten_define(feed) {
     State* state = (State*)call->ten;
     
-    ten_Var str1Arg = ten_arg( 0 );
-    ten_Var oprArg  = ten_arg( 1 );
-    ten_Var str2Arg = ten_arg( 2 );
-    
-    expectArg( str1, OBJ_STR );
-    expectArg( opr, VAL_SYM );
-    expectArg( str2, OBJ_STR );
+    ten_Var decArg = ten_arg( 0 );
+    ten_Var strArg = ten_arg( 1 );
     
-    String* str1 = tvGetObj( varGet( str1Arg ) );
-    SymT    opr  = tvGetSym( varGet( oprArg ) );
-    String* str2 = tvGetObj( varGet( str2Arg ) );
+    TVal decVal = varGet( decArg );
+    expectJsonDecVal( dec );
+    expectArg( str, OBJ_STR );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = { .tup = &retTup, .loc = 0 };
-    varSet( retVar, libBcmp( state, str1, opr, str2 ) );
-    return retTup;
+    libJsonFeed( state, tvGetObj( decVal ), tvGetObj( varGet( strArg ) ) );
+    return ten_pushA( call->ten, "" );
 }
 
-ten_define(ccmp) {
+ten_define(next) {
     State* state = (State*)call->ten;
     
-    ten_Var str1Arg = ten_arg( 0 );
-    ten_Var oprArg  = ten_arg( 1 );
-    ten_Var str2Arg = ten_arg( 2 );
-    
-    expectArg( str1, OBJ_STR );
-    expectArg( opr, VAL_SYM );
-    expectArg( str2, OBJ_STR );
+    ten_Var decArg = ten_arg( 0 );
     
-    String* str1 = tvGetObj( varGet( str1Arg ) );
-    SymT    opr  = tvGetSym( varGet( oprArg ) );
-    String* str2 = tvGetObj( varGet( str2Arg ) );
+    TVal decVal = varGet( decArg );
+    expectJsonDecVal( dec );
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
-    varSet( retVar, libCcmp( state, str1, opr, str2 ) );
+    varSet( retVar, libJsonNext( state, tvGetObj( decVal ) ) );
+    
     return retTup;
 }
 
-ten_define(bsub) {
-    State* state = (State*)call->ten;
+fast_define( bcmp ) {
+    TVal str1Val = args[0];
+    TVal oprVal  = args[1];
+    TVal str2Val = args[2];
+    expectVal( str1, OBJ_STR );
+    expectVal( opr, VAL_SYM );
+    expectVal( str2, OBJ_STR );
     
-    ten_Var strArg = ten_arg( 0 );
-    ten_Var nArg   = ten_arg( 1 );
+    return libBcmp( state, tvGetObj( str1Val ), tvGetSym( oprVal ), tvGetObj( str2Val ) );
+}
+
+fast_define( ccmp ) {
+    TVal str1Val = args[0];
+    TVal oprVal  = args[1];
+    TVal str2Val = args[2];
+    expectVal( str1, OBJ_STR );
+    expectVal( opr, VAL_SYM );
+    expectVal( str2, OBJ_STR );
     
-    expectArg( str, OBJ_STR );
-    expectArg( n, VAL_INT );
+    return libCcmp( state, tvGetObj( str1Val ), tvGetSym( oprVal ), tvGetObj( str2Val ) );
+}
+
+fast_define( bsub ) {
+    TVal strVal = args[0];
+    TVal nVal   = args[1];
+    expectVal( str, OBJ_STR );
+    expectVal( n, VAL_INT );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    return tvObj( libBsub( state, tvGetObj( strVal ), tvGetInt( nVal ) ) );
+}
+
+fast_define( csub ) {
+    TVal strVal = args[0];
+    TVal nVal   = args[1];
+    expectVal( str, OBJ_STR );
+    expectVal( n, VAL_INT );
+    
+    return tvObj( libCsub( state, tvGetObj( strVal ), tvGetInt( nVal ) ) );
+}
+
+
+fast_define( blen ) {
+    TVal strVal = args[0];
+    expectVal( str, OBJ_STR );
     
-    String* sub = libBsub( state, tvGetObj( varGet( strArg ) ), tvGetInt( varGet( nArg ) ) );
-    varSet( retVar, tvObj( sub ) );
+    return tvInt( libBlen( state, tvGetObj( strVal ) ) );
+}
+
+fast_define( clen ) {
+    TVal strVal = args[0];
+    expectVal( str, OBJ_STR );
     
-    return retTup;
+    return tvInt( libClen( state, tvGetObj( strVal ) ) );
 }
 
-ten_define(csub) {
+
+ten_define(each) {
     State* state = (State*)call->ten;
     
-    ten_Var strArg = ten_arg( 0 );
-    ten_Var nArg   = ten_arg( 1 );
+    ten_Var iterArg = ten_arg( 0 );
+    ten_Var whatArg = ten_arg( 1 );
     
-    expectArg( str, OBJ_STR );
-    expectArg( n, VAL_INT );
+    expectArg( iter, OBJ_CLS );
+    expectArg( what, OBJ_CLS );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
+    libEach( state, tvGetObj( varGet( iterArg ) ), tvGetObj( varGet( whatArg ) ) );
     
-    String* sub = libCsub( state, tvGetObj( varGet( strArg ) ), tvGetInt( varGet( nArg ) ) );
-    varSet( retVar, tvObj( sub ) );
+    return ten_pushA( call->ten, "" );
+}
+
+static bool
+isNatFun( TVal val, ten_FunCb cb ) {
+    if( !tvIsObjType( val, OBJ_CLS ) )
+        return false;
     
-    return retTup;
+    Closure* cls = tvGetObj( val );
+    return cls->fun->type == FUN_NAT && cls->fun->u.nat.cb == cb;
 }
 
+TVal
+libLoopStep( State* state, TVal each, TVal range, TVal start, TVal end ) {
+    if( !isNatFun( each, ten_fun( each ) ) )
+        return tvUdf();
+    
+    if( isNatFun( range, ten_fun( irange ) ) ) {
+        if( !tvIsInt( start ) || !tvIsInt( end ) )
+            return tvUdf();
+        
+        IntT step = tvGetInt( end ) >= tvGetInt( start ) ? 1 : -1;
+        return tvInt( step );
+    }
+    if( isNatFun( range, ten_fun( drange ) ) ) {
+        if( !tvIsDec( start ) || !tvIsDec( end ) )
+            return tvUdf();
+        
+        DecT step = tvGetDec( end ) >= tvGetDec( start ) ? 1.0 : -1.0;
+        return tvDec( step );
+    }
+    return tvUdf();
+}
 
-ten_define(blen) {
+ten_define(fold) {
     State* state = (State*)call->ten;
     
-    ten_Var strArg = ten_arg( 0 );
-    expectArg( str, OBJ_STR );
+    ten_Var iterArg = ten_arg( 0 );
+    ten_Var agrArg  = ten_arg( 1 );
+    ten_Var howArg  = ten_arg( 2 );
+    
+    expectArg( iter, OBJ_CLS );
+    expectArg( how, OBJ_CLS );
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
     
-    size_t len = libBlen( state, tvGetObj( varGet( strArg ) ) );
-    varSet( retVar, tvInt( len ) );
+    varSet( retVar, libFold( state, tvGetObj( varGet( iterArg ) ), varGet( agrArg ), tvGetObj( varGet( howArg ) ) ) );
     
     return retTup;
 }
 
-ten_define(clen) {
+ten_define(sort) {
     State* state = (State*)call->ten;
     
-    ten_Var strArg = ten_arg( 0 );
-    expectArg( str, OBJ_STR );
+    ten_Var seqArg = ten_arg( 0 );
+    ten_Var optArg = ten_arg( 1 );
+    
+    TVal seqVal = varGet( seqArg );
+    if( !libIsVec( state, seqVal ) )
+        expectVal( seq, OBJ_REC );
+    tenAssert( tvIsObjType( varGet( optArg ), OBJ_REC ) );
+    
+    Closure* less = NULL;
+    Record*  opt  = tvGetObj( varGet( optArg ) );
+    TVal     lessVal = recGet( state, opt, tvInt( 0 ) );
+    if( !tvIsUdf( lessVal ) ) {
+        expectVal( less, OBJ_CLS );
+        less = tvGetObj( lessVal );
+    }
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
-    
-    size_t len = libClen( state, tvGetObj( varGet( strArg ) ) );
-    varSet( retVar, tvInt( len ) );
+    varSet( retVar, libSort( state, seqVal, less ) );
     
     return retTup;
 }
 
-
-ten_define(each) {
+ten_define(map) {
     State* state = (State*)call->ten;
     
-    ten_Var iterArg = ten_arg( 0 );
-    ten_Var whatArg = ten_arg( 1 );
+    ten_Var seqArg = ten_arg( 0 );
+    ten_Var funArg = ten_arg( 1 );
     
-    expectArg( iter, OBJ_CLS );
-    expectArg( what, OBJ_CLS );
+    TVal seqVal = varGet( seqArg );
+    if( !libIsVec( state, seqVal ) )
+        expectVal( seq, OBJ_REC );
+    expectArg( fun, OBJ_CLS );
     
-    libEach( state, tvGetObj( varGet( iterArg ) ), tvGetObj( varGet( whatArg ) ) );
+    ten_Tup retTup = ten_pushA( call->ten, "U" );
+    ten_Var retVar = ten_var( retTup, 0 );
+    varSet( retVar, libMap( state, seqVal, tvGetObj( varGet( funArg ) ) ) );
     
-    return ten_pushA( call->ten, "" );
+    return retTup;
 }
 
-ten_define(fold) {
+ten_define(filter) {
     State* state = (State*)call->ten;
     
-    ten_Var iterArg = ten_arg( 0 );
-    ten_Var agrArg  = ten_arg( 1 );
-    ten_Var howArg  = ten_arg( 2 );
+    ten_Var seqArg  = ten_arg( 0 );
+    ten_Var predArg = ten_arg( 1 );
     
-    expectArg( iter, OBJ_CLS );
-    expectArg( how, OBJ_CLS );
+    TVal seqVal = varGet( seqArg );
+    if( !libIsVec( state, seqVal ) )
+        expectVal( seq, OBJ_REC );
+    expectArg( pred, OBJ_CLS );
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
-    
-    varSet( retVar, libFold( state, tvGetObj( varGet( iterArg ) ), varGet( agrArg ), tvGetObj( varGet( howArg ) ) ) );
+    varSet( retVar, libFilter( state, seqVal, tvGetObj( varGet( predArg ) ) ) );
     
     return retTup;
 }
 
-ten_define(cons) {
+ten_define(reduce) {
     State* state = (State*)call->ten;
     
-    ten_Var carArg = ten_arg( 0 );
-    ten_Var cdrArg = ten_arg( 1 );
+    ten_Var seqArg = ten_arg( 0 );
+    ten_Var agrArg = ten_arg( 1 );
+    ten_Var howArg = ten_arg( 2 );
+    
+    TVal seqVal = varGet( seqArg );
+    if( !libIsVec( state, seqVal ) )
+        expectVal( seq, OBJ_REC );
+    expectArg( how, OBJ_CLS );
     
     ten_Tup retTup = ten_pushA( call->ten, "U" );
     ten_Var retVar = ten_var( retTup, 0 );
-    
-    varSet( retVar, tvObj( libCons( state, varGet( carArg ), varGet(cdrArg ) ) ) );
+    varSet( retVar, libReduce( state, seqVal, varGet( agrArg ), tvGetObj( varGet( howArg ) ) ) );
     
     return retTup;
 }
 
+fast_define( cons ) {
+    TVal carVal = args[0];
+    TVal cdrVal = args[1];
+    
+    return tvObj( libCons( state, carVal, cdrVal ) );
+}
+
 ten_define(sep) {
     State* state = (State*)call->ten;
     
@@ -3165,32 +4948,18 @@ ten_define(yield) {
     return ten_pushA( call->ten, "" );
 }
 
-ten_define(state) {
-    State* state = (State*)call->ten;
-    
-    ten_Var fibArg = ten_arg( 0 );
-    expectArg( fib, OBJ_FIB );
-    
-    Fiber* fib = tvGetObj( varGet( fibArg ) );
+fast_define( state ) {
+    TVal fibVal = args[0];
+    expectVal( fib, OBJ_FIB );
     
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
-    varSet( retVar, tvSym( libState( state, fib ) ) );
-    return retTup;
+    return tvSym( libState( state, tvGetObj( fibVal ) ) );
 }
 
-ten_define(errval) {
-    State* state = (State*)call->ten;
+fast_define( errval ) {
+    TVal fibVal = args[0];
+    expectVal( fib, OBJ_FIB );
     
-    ten_Var fibArg = ten_arg( 0 );
-    expectArg( fib, OBJ_FIB );
-    
-    Fiber* fib = tvGetObj( varGet( fibArg ) );
-    
-    ten_Tup retTup = ten_pushA( call->ten, "U" );
-    ten_Var retVar = ten_var( retTup, 0 );
-    varSet( retVar, libErrval( state, fib ) );
-    return retTup;
+    return libErrval( state, tvGetObj( fibVal ) );
 }
 
 ten_define(trace) {
@@ -3385,6 +5154,67 @@ ten_define(skip) {
     return rets;
 }
 
+ten_define(submit) {
+    State* state = (State*)call->ten;
+    
+    ten_Var funArg  = ten_arg( 0 );
+    ten_Var argsArg = ten_arg( 1 );
+    
+    TVal fun = varGet( funArg );
+    if( !tvIsSym( fun ) )
+        expectArg( fun, OBJ_STR );
+    tenAssert( tvIsObjType( varGet( argsArg ), OBJ_REC ) );
+    
+    Record* args = tvGetObj( varGet( argsArg ) );
+    
+    ten_Tup retTup = ten_pushA( call->ten, "U" );
+    ten_Var retVar = ten_var( retTup, 0 );
+    
+    libSubmit( state, fun, args, &retVar );
+    return retTup;
+}
+
+#define expectFut( ARG ) \
+    libExpect( state, #ARG, tvGetSym( ((DatInfo*)state->libState->futureInfo)->typeVal ), varGet( ARG ## Arg ) )
+
+ten_define(await) {
+    State* state = (State*)call->ten;
+    
+    ten_Var futArg = ten_arg( 0 );
+    expectFut( fut );
+    
+    Future* fut = ten_getDatBuf( call->ten, &futArg );
+    
+    Tup ret = libAwait( state, fut );
+    
+    ten_Tup retTup;
+    memcpy( &retTup, &ret, sizeof(Tup) );
+    return retTup;
+}
+
+ten_define(ready) {
+    State* state = (State*)call->ten;
+    
+    ten_Var futArg = ten_arg( 0 );
+    expectFut( fut );
+    
+    Future* fut = ten_getDatBuf( call->ten, &futArg );
+    
+    ten_Tup retTup = ten_pushA( call->ten, "U" );
+    ten_Var retVar = ten_var( retTup, 0 );
+    varSet( retVar, tvLog( libReady( state, fut ) ) );
+    return retTup;
+}
+
+ten_define(workers) {
+    State* state = (State*)call->ten;
+    
+    ten_Tup retTup = ten_pushA( call->ten, "U" );
+    ten_Var retVar = ten_var( retTup, 0 );
+    varSet( retVar, tvInt( libWorkers( state ) ) );
+    return retTup;
+}
+
 void
 libInit( State* state ) {
     ten_State* s = (ten_State*)state;
@@ -3395,6 +5225,7 @@ libInit( State* state ) {
     lib->val2 = tvUdf();
     lib->cellIdx     = NULL;
     lib->traceIdx    = NULL;
+    lib->splitIdx    = NULL;
     lib->loaders     = NULL;
     lib->translators = NULL;
     lib->modules     = NULL;
@@ -3405,6 +5236,8 @@ libInit( State* state ) {
         lib->opers[i] = symGet( state, "", 0 );
     for( uint i = 0 ; i < OBJ_LAST ; i++ )
         lib->types[i] = symGet( state, "", 0 );
+    for( uint i = 0 ; i < NEXT_LAST ; i++ )
+        lib->nexts[i] = NULL;
     
     lib->scan.cb = libScan; stateInstallScanner( state, &lib->scan );
     lib->finl.cb = libFinl; stateInstallFinalizer( state, &lib->finl );
@@ -3430,6 +5263,7 @@ libInit( State* state ) {
     IDENT( collect );
     IDENT( loader );
     IDENT( clock );
+    IDENT( wclock );
     IDENT( rand );
     
     IDENT( log );
@@ -3450,6 +5284,7 @@ libInit( State* state ) {
     IDENT( bytes );
     IDENT( chars );
     IDENT( split );
+    IDENT( splits );
     IDENT( items );
     IDENT( drange );
     IDENT( irange );
@@ -3470,8 +5305,48 @@ libInit( State* state ) {
     IDENT( blen );
     IDENT( clen );
     
+    IDENT( builder );
+    IDENT( append );
+    IDENT( build );
+    
+    IDENT( buffer );
+    IDENT( bufadd );
+    IDENT( buflen );
+    IDENT( bufget );
+    IDENT( bufset );
+    IDENT( bufcut );
+    IDENT( bufsub );
+    IDENT( bufstr );
+    IDENT( bufpack );
+    IDENT( bufunpack );
+    
+    IDENT( vec );
+    IDENT( vecpush );
+    IDENT( veclen );
+    IDENT( vecget );
+    IDENT( vecset );
+    IDENT( vecsum );
+    IDENT( vecmin );
+    IDENT( vecmax );
+    IDENT( vecdot );
+    IDENT( vecscale );
+    IDENT( vecadd );
+    IDENT( vecmask );
+    IDENT( vecsort );
+    IDENT( vecscan );
+    
     IDENT( each );
     IDENT( fold );
+    IDENT( sort );
+    IDENT( map );
+    IDENT( filter );
+    IDENT( reduce );
+    
+    IDENT( decode );
+    IDENT( encode );
+    IDENT( decoder );
+    IDENT( feed );
+    IDENT( next );
     
     IDENT( sep );
     
@@ -3512,6 +5387,11 @@ libInit( State* state ) {
     IDENT( limit );
     IDENT( skip );
     
+    IDENT( submit );
+    IDENT( await );
+    IDENT( ready );
+    IDENT( workers );
+    
 
     #define OPER( N, O ) \
         lib->opers[OPER_ ## N] = symGet( state, O, sizeof(O)-1 )
@@ -3542,7 +5422,7 @@ libInit( State* state ) {
     TYPE( OBJ_DAT, Dat );
     
     
-    #define FUN( N, P, V )                                          \
+    #define NAT( N, P, V, F )                                       \
     do {                                                            \
         Index* idx = NULL;                                          \
         if( (V) ) {                                                 \
@@ -3552,6 +5432,7 @@ libInit( State* state ) {
                                                                     \
         Function* fun = funNewNat( state, (P), idx, ten_fun( N ) ); \
         fun->u.nat.name = lib->idents[IDENT_ ## N];                 \
+        fun->u.nat.fast = (F);                                      \
         varSet( funVar, tvObj( fun ) );                               \
                                                                     \
         Closure* cls = clsNewNat( state, fun, NULL );               \
@@ -3561,36 +5442,41 @@ libInit( State* state ) {
         ten_def( s, &symVar, &clsVar );                             \
     } while( 0 )
     
+    #define FUN( N, P, V ) NAT( N, P, V, NULL )
+    #define FAST( N, P )   NAT( N, P, false, lf_ ## N )
+    
     FUN( require, 1, false );
     FUN( import, 1, false );
-    FUN( type, 1, false );
+    FAST( type, 1 );
     FUN( panic, 1, false );
     FUN( assert, 2, false );
     FUN( expect, 3, false );
     FUN( collect, 0, false );
     FUN( loader, 2, true );
-    FUN( clock, 0, false );
-    FUN( rand, 0, false );
-    
-    FUN( log, 1, false );
-    FUN( int, 1, false );
-    FUN( dec, 1, false );
-    FUN( sym, 1, false );
-    FUN( str, 1, false );
-    
-    FUN( hex, 1, false );
-    FUN( oct, 1, false );
-    FUN( bin, 1, false );
-    
-    FUN( keys, 1, false );
-    FUN( vals, 1, false );
-    FUN( pairs, 1, false );
+    FAST( clock, 0 );
+    FAST( wclock, 0 );
+    FAST( rand, 0 );
+    
+    FAST( log, 1 );
+    FAST( int, 1 );
+    FAST( dec, 1 );
+    FAST( sym, 1 );
+    FAST( str, 1 );
+    
+    FAST( hex, 1 );
+    FAST( oct, 1 );
+    FAST( bin, 1 );
+    
+    FAST( keys, 1 );
+    FAST( vals, 1 );
+    FAST( pairs, 1 );
     FUN( seq, 0, true );
-    FUN( rseq, 1, false );
-    FUN( bytes, 1, false );
-    FUN( chars, 1, false );
-    FUN( split, 2, false );
-    FUN( items, 1, false );
+    FAST( rseq, 1 );
+    FAST( bytes, 1 );
+    FAST( chars, 1 );
+    FAST( split, 2 );
+    FAST( splits, 2 );
+    FAST( items, 1 );
     FUN( drange, 2, true );
     FUN( irange, 2, true );
     
@@ -3598,32 +5484,66 @@ libInit( State* state ) {
     FUN( warn, 0, true );
     FUN( input, 0, false );
     
-    FUN( ucode, 1, false );
-    FUN( uchar, 1, false );
+    FAST( ucode, 1 );
+    FAST( uchar, 1 );
     
     FUN( cat, 0, true );
     FUN( join, 2, false );
-    FUN( bcmp, 3, false );
-    FUN( ccmp, 3, false );
-    FUN( bsub, 2, false );
-    FUN( csub, 2, false );
-    FUN( blen, 1, false );
-    FUN( clen, 1, false );
+    FAST( bcmp, 3 );
+    FAST( ccmp, 3 );
+    FAST( bsub, 2 );
+    FAST( csub, 2 );
+    FAST( blen, 1 );
+    FAST( clen, 1 );
+    
+    FAST( builder, 0 );
+    FUN( append, 1, true );
+    FAST( build, 1 );
+    
+    FAST( buffer, 0 );
+    FUN( bufadd, 1, true );
+    FAST( buflen, 1 );
+    FAST( bufget, 2 );
+    FUN( bufset, 3, false );
+    FUN( bufcut, 2, false );
+    FAST( bufsub, 3 );
+    FAST( bufstr, 1 );
+    FUN( bufpack, 4, false );
+    FAST( bufunpack, 3 );
+    
+    FAST( vec, 2 );
+    FUN( vecpush, 1, true );
+    FAST( veclen, 1 );
+    FAST( vecget, 2 );
+    FUN( vecset, 3, false );
+    FAST( vecsum, 1 );
+    FAST( vecmin, 1 );
+    FAST( vecmax, 1 );
+    FAST( vecdot, 2 );
+    FUN( vecscale, 2, false );
+    FUN( vecadd, 2, false );
+    FAST( vecmask, 3 );
+    FUN( vecsort, 1, false );
+    FUN( vecscan, 1, false );
     
     FUN( each, 2, false );
     FUN( fold, 3, false );
+    FUN( sort, 1, true );
+    FUN( map, 2, false );
+    FUN( filter, 2, false );
+    FUN( reduce, 3, false );
     
     FUN( sep, 1, false );
     
-    FUN( cons, 2, false );
+    FAST( cons, 2 );
     FUN( list, 0, true );
     FUN( explode, 1, false );
     
     FUN( fiber, 1, true );
     FUN( cont, 2, false );
     FUN( yield, 0, true );
-    FUN( state, 1, false );
-    FUN( errval, 1, false );
+    FAST( state, 1 );
+    FAST( errval, 1 );
     FUN( trace, 1, false );
     
     FUN( script, 2, false );
@@ -3637,6 +5557,31 @@ libInit( State* state ) {
     FUN( limit, 2, false );
     FUN( skip, 2, false );
     
+    FUN( submit, 1, true );
+    FUN( await, 1, false );
+    FUN( ready, 1, false );
+    FUN( workers, 0, false );
+    
+    #define NEXT( N, CB )                                           \
+    do {                                                            \
+        Function* fun = funNewNat( state, 0, NULL, ten_fun( CB ) ); \
+        lib->nexts[NEXT_ ## N] = fun;                               \
+        fun->u.nat.name = symGet( state, #CB, sizeof(#CB)-1 );      \
+    } while( 0 )
+    
+    NEXT( keys, keyIterNext );
+    NEXT( vals, valIterNext );
+    NEXT( pairs, pairIterNext );
+    NEXT( seq, seqNext );
+    NEXT( bytes, byteIterNext );
+    NEXT( chars, charIterNext );
+    NEXT( split, splitIterNext );
+    NEXT( items, listIterNext );
+    NEXT( drange, dRangeNext );
+    NEXT( irange, iRangeNext );
+    NEXT( pump, pumpNext );
+    NEXT( limit, limiterNext );
+    
     
     ten_def( s, ten_sym( s, "N" ), ten_sym( s, "\n" ) );
     ten_def( s, ten_sym( s, "R" ), ten_sym( s, "\r" ) );
@@ -3726,11 +5671,60 @@ libInit( State* state ) {
             .destr = NULL
         }
     );
+    lib->futureInfo = ten_addDatInfo(
+        s,
+        &(ten_DatConfig){
+            .tag   = "Future",
+            .size  = sizeof(Future),
+            .mems  = 0,
+            .destr = futureDestr
+        }
+    );
+    lib->builderInfo = ten_addDatInfo(
+        s,
+        &(ten_DatConfig){
+            .tag   = "Builder",
+            .size  = sizeof(Builder),
+            .mems  = Builder_LAST,
+            .destr = NULL
+        }
+    );
+    lib->bufInfo = ten_addDatInfo(
+        s,
+        &(ten_DatConfig){
+            .tag   = "Buf",
+            .size  = sizeof(ByteBuf),
+            .mems  = ByteBuf_LAST,
+            .destr = NULL
+        }
+    );
+    lib->vecInfo = ten_addDatInfo(
+        s,
+        &(ten_DatConfig){
+            .tag   = "Vec",
+            .size  = sizeof(NumVec),
+            .mems  = NumVec_LAST,
+            .destr = NULL
+        }
+    );
+    lib->jsonDecInfo = ten_addDatInfo(
+        s,
+        &(ten_DatConfig){
+            .tag   = "JsonDec",
+            .size  = sizeof(JsonDec),
+            .mems  = JsonDec_LAST,
+            .destr = jsonDecDestr
+        }
+    );
     
     statePop( state ); // varTup
     
     lib->cellIdx  = idxNew( state );
     lib->traceIdx = idxNew( state );
+    lib->splitIdx = idxNew( state );
+    
+    lib->carLoc = idxAddByKey( state, lib->cellIdx, tvSym( lib->idents[IDENT_car] ) );
+    lib->cdrLoc = idxAddByKey( state, lib->cellIdx, tvSym( lib->idents[IDENT_cdr] ) );
     
     Index* importIdx = idxNew( state );
     lib->val1 = tvObj( importIdx );
@@ -3744,5 +5738,40 @@ libInit( State* state ) {
     lib->modules = recNew( state, moduleIdx );
     
     
+    // The JSON module is registered as already loaded, so
+    // `require( "std:json" )` finds it without a loader.
+    varTup = ten_pushA( s, "UUUU" );
+    
+    Index* jsonIdx = idxNew( state );
+    varSet( idxVar, tvObj( jsonIdx ) );
+    
+    Record* json = recNew( state, jsonIdx );
+    varSet( idxVar, tvObj( json ) );
+    
+    #define MOD( R, N, P )                                          \
+    do {                                                            \
+        Function* fun = funNewNat( state, (P), NULL, ten_fun( N ) );\
+        fun->u.nat.name = lib->idents[IDENT_ ## N];                 \
+        fun->u.nat.fast = NULL;                                     \
+        varSet( funVar, tvObj( fun ) );                             \
+                                                                    \
+        Closure* cls = clsNewNat( state, fun, NULL );               \
+        varSet( clsVar, tvObj( cls ) );                             \
+                                                                    \
+        recDef( state, (R), tvSym( lib->idents[IDENT_ ## N] ), tvObj( cls ) );\
+    } while( 0 )
+    
+    MOD( json, decode, 1 );
+    MOD( json, encode, 1 );
+    MOD( json, decoder, 0 );
+    MOD( json, feed, 2 );
+    MOD( json, next, 1 );
+    
+    varSet( symVar, tvSym( symGet( state, "std:json", 8 ) ) );
+    recDef( state, lib->modules, varGet( symVar ), tvObj( json ) );
+    
+    statePop( state ); // varTup
+    
+    
     state->libState = lib;
 }
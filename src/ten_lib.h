@@ -43,6 +43,9 @@ libLoader( State* state, SymT type, Closure* loadr, Closure* trans );
 DecT
 libClock( State* state );
 
+DecT
+libWclock( State* state );
+
 DecT
 libRand( State* state );
 
@@ -91,6 +94,9 @@ libChars( State* state, String* str );
 Closure*
 libSplit( State* state, String* str, String* sep );
 
+Record*
+libSplits( State* state, String* str, String* sep );
+
 Closure*
 libItems( State* state, Record* list );
 
@@ -121,6 +127,133 @@ libCat( State* state, Record* rec );
 String*
 libJoin( State* state, Closure* seq, String* sep );
 
+// String builders accumulate bytes with amortized constant time
+// appends; `libBuild()` copies the accumulated bytes into a new
+// String, leaving the builder usable for further appends.
+Data*
+libBuilder( State* state );
+
+bool
+libIsBuilder( State* state, TVal val );
+
+void
+libAppend( State* state, Data* bld, TVal val );
+
+void
+libAppendBuf( State* state, Data* bld, char const* buf, size_t len );
+
+String*
+libBuild( State* state, Data* bld );
+
+// Byte buffers are mutable, growable byte arrays; for reading and
+// writing binary data without making a String for every piece.
+// `libBufSub()` returns a view of the buffer's bytes as a String
+// without copying them where it can.
+Data*
+libBuf( State* state );
+
+bool
+libIsBuf( State* state, TVal val );
+
+size_t
+libBufLen( State* state, Data* buf );
+
+char*
+libBufBytes( State* state, Data* buf );
+
+void
+libBufAdd( State* state, Data* buf, TVal val );
+
+void
+libBufAddBytes( State* state, Data* buf, char const* bytes, size_t len );
+
+TVal
+libBufGet( State* state, Data* buf, IntT at );
+
+void
+libBufSet( State* state, Data* buf, IntT at, IntT byte );
+
+void
+libBufCut( State* state, Data* buf, IntT n );
+
+String*
+libBufSub( State* state, Data* buf, IntT at, IntT n );
+
+void
+libBufPack( State* state, Data* buf, IntT at, SymT type, TVal val );
+
+TVal
+libBufUnpack( State* state, Data* buf, IntT at, SymT type );
+
+// Packed vectors keep Ints or Decs in a contiguous array, with the
+// bulk operations implemented by the kernels in `ten_vec.h`.  The
+// in-place operations change the first vector given.
+Data*
+libVec( State* state, bool dec, size_t len );
+
+bool
+libIsVec( State* state, TVal val );
+
+bool
+libVecIsDec( State* state, Data* vec );
+
+size_t
+libVecLen( State* state, Data* vec );
+
+void*
+libVecValues( State* state, Data* vec );
+
+void
+libVecResize( State* state, Data* vec, size_t len );
+
+TVal
+libVecGet( State* state, Data* vec, IntT at );
+
+void
+libVecSet( State* state, Data* vec, IntT at, TVal val );
+
+void
+libVecPush( State* state, Data* vec, TVal val );
+
+TVal
+libVecSum( State* state, Data* vec );
+
+TVal
+libVecMin( State* state, Data* vec );
+
+TVal
+libVecMax( State* state, Data* vec );
+
+TVal
+libVecDot( State* state, Data* vec1, Data* vec2 );
+
+void
+libVecScale( State* state, Data* vec, TVal k );
+
+void
+libVecAdd( State* state, Data* vec1, Data* vec2 );
+
+Data*
+libVecMask( State* state, Data* vec, SymT opr, TVal x );
+
+void
+libVecSort( State* state, Data* vec );
+
+void
+libVecScan( State* state, Data* vec );
+
+// Streaming JSON decoders, input is fed in as Strings of any size
+// and `libJsonNext()` gives each complete top level value in turn,
+// or `udf` if more input is needed first.
+Data*
+libJsonDecoder( State* state );
+
+void
+libJsonFeed( State* state, Data* dec, String* str );
+
+TVal
+libJsonNext( State* state, Data* dec );
+
 TVal
 libBcmp( State* state, String* str1, SymT opr, String* str2 );
 
@@ -145,6 +278,30 @@ libEach( State* state, Closure* seq, Closure* what );
 TVal
 libFold( State* state, Closure* seq, TVal agr, Closure* how );
 
+// The bulk transforms take a sequence record or a packed vector,
+// and return a new one of the same kind.  `less` may be NULL, in
+// which case the values must all be numbers, all strings, or all
+// symbols.
+TVal
+libSort( State* state, TVal seq, Closure* less );
+
+TVal
+libMap( State* state, TVal seq, Closure* fun );
+
+TVal
+libFilter( State* state, TVal seq, Closure* pred );
+
+TVal
+libReduce( State* state, TVal seq, TVal agr, Closure* how );
+
+// If `each` and `range` are the prelude's `each()` and `irange()`
+// or `drange()`, and `start` and `end` are valid bounds for the
+// range, then returns the step the range would advance by.
+// Otherwise returns `udf`.  This is used by the VM to run loops
+// of the form `each( irange( start, end ), ... )` in-frame.
+TVal
+libLoopStep( State* state, TVal each, TVal range, TVal start, TVal end );
+
 
 Record*
 libSep( State* state, Record* rec );
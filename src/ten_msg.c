@@ -0,0 +1,1122 @@
+#include "ten_msg.h"
+#include "ten_state.h"
+#include "ten_assert.h"
+#include "ten_macros.h"
+#include "ten_sym.h"
+#include "ten_str.h"
+#include "ten_idx.h"
+#include "ten_rec.h"
+#include "ten_fun.h"
+#include "ten_cls.h"
+#include "ten_upv.h"
+#include "ten_env.h"
+#include "ten_opcodes.h"
+#include <string.h>
+#include <stdint.h>
+
+typedef void* ObjPtr;
+
+#define BUF_TYPE ObjPtr
+#define BUF_NAME ObjBuf
+    #include "inc/buf.inc"
+#undef BUF_NAME
+#undef BUF_TYPE
+
+// A message buffer is laid out as:
+//
+// [values][record bodies][object table]
+//
+// Where each value is a one byte code followed by its payload;
+// objects are always encoded as a reference (MSG_OBJ) into the
+// object table, which allows shared and cyclic references to be
+// reconstructed.  Each record body is a field count followed by
+// its key and value pairs, and record bodies appear in the same
+// order as their records in the object table.  Each entry in
+// the object table is a code (MSG_STR or MSG_REC) followed by
+// the string's contents or the record's index ID and separation
+// flag.  Object table entries are placed last since we don't
+// know what they'll be until everything else has been encoded;
+// but the unpacker needs to allocate them first.
+//
+// Images extend this with virtual functions (MSG_FUN), their
+// closures (MSG_CLS), upvalues (MSG_UPV), and free standing
+// indices (MSG_IDX), which have bodies of their own.  Since an
+// image never leaves the process, native closures without any
+// Data can be copied as well (MSG_NAT) by their callback pointer;
+// the entry also names the global the closure was found in, if
+// any, so the receiving State's own closure can be reused when
+// it has the same callback.  Values that still can't be copied
+// are encoded as a reference to a global variable by name
+// (MSG_GLB), or as `udf` if they aren't in a global at all.
+typedef enum {
+    MSG_UDF,
+    MSG_NIL,
+    MSG_LOG,
+    MSG_INT,
+    MSG_DEC,
+    MSG_SYM,
+    MSG_GLB,
+    MSG_OBJ,
+    MSG_STR,
+    MSG_REC,
+    MSG_IDX,
+    MSG_FUN,
+    MSG_CLS,
+    MSG_UPV,
+    MSG_NAT
+} MsgCode;
+
+typedef struct {
+    Defer   base;
+    State*  state;
+    Msg*    msg;
+    ObjBuf  objs;
+    Record* ids;
+    Record* idxIds;
+    Record* names;
+} Packer;
+
+static void
+packerDefer( State* state, Defer* defer ) {
+    Packer* p = (Packer*)defer;
+    if( p->msg )
+        msgFree( p->msg );
+    finlObjBuf( state, &p->objs );
+}
+
+static void*
+reserve( Packer* p, size_t n ) {
+    State* state = p->state;
+    Msg*   msg   = p->msg;
+    if( msg->len + n > msg->cap ) {
+        size_t cap = ( msg->len + n )*2;
+        msg = msg->frealloc( msg->udata, msg, sizeof(Msg) + msg->cap, sizeof(Msg) + cap );
+        if( !msg )
+            stateErrVal( state, ten_ERR_FATAL, state->errOutOfMem );
+        msg->cap = cap;
+        p->msg   = msg;
+    }
+    
+    void* ptr = msg->buf + msg->len;
+    msg->len += n;
+    return ptr;
+}
+
+static void
+putCode( Packer* p, MsgCode code ) {
+    *(uchar*)reserve( p, 1 ) = code;
+}
+
+static void
+putU32( Packer* p, uint32_t u ) {
+    memcpy( reserve( p, sizeof(u) ), &u, sizeof(u) );
+}
+
+static void
+putU64( Packer* p, uint64_t u ) {
+    memcpy( reserve( p, sizeof(u) ), &u, sizeof(u) );
+}
+
+static void
+putBytes( Packer* p, char const* buf, size_t len ) {
+    memcpy( reserve( p, len ), buf, len );
+}
+
+static void
+putSym( Packer* p, SymT sym ) {
+    size_t len = symLen( p->state, sym );
+    putU64( p, len );
+    putBytes( p, symBuf( p->state, sym ), len );
+}
+
+// Each object is assigned an ID, its position in the object
+// table, on first encounter.  We keep track of which have
+// already been assigned IDs with a Record; which keys most
+// objects by identity, but Strings by their contents.  So
+// equal Strings share an ID and are unpacked as a single
+// String, which is only visible to identity comparisons.
+static uint
+getObjId( Packer* p, void* obj ) {
+    State* state = p->state;
+    
+    TVal id = recGet( state, p->ids, tvObj( obj ) );
+    if( !tvIsUdf( id ) )
+        return tvGetInt( id );
+    
+    uint next = p->objs.top;
+    if( next >= INT32_MAX )
+        stateErrFmtA( state, ten_ERR_LIMIT, "Too many objects in message" );
+    
+    *putObjBuf( state, &p->objs ) = obj;
+    recDef( state, p->ids, tvObj( obj ), tvInt( next ) );
+    return next;
+}
+
+static bool
+isNat( void* obj ) {
+    if( datGetTag( obj ) != OBJ_CLS )
+        return false;
+    
+    Closure* cls = obj;
+    return cls->fun->type == FUN_NAT && cls->dat.dat == NULL;
+}
+
+static bool
+canPack( Packer* p, void* obj ) {
+    switch( datGetTag( obj ) ) {
+        case OBJ_STR:
+        case OBJ_REC:
+            return true;
+        case OBJ_IDX:
+        case OBJ_UPV:
+            return p->names != NULL;
+        case OBJ_FUN:
+            return p->names != NULL && ((Function*)obj)->type == FUN_VIR;
+        case OBJ_CLS:
+            return p->names != NULL && ( ((Closure*)obj)->fun->type == FUN_VIR || isNat( obj ) );
+        default:
+            return false;
+    }
+}
+
+static void
+packVal( Packer* p, TVal val ) {
+    State* state = p->state;
+    
+    if( p->names && ( tvIsObj( val ) || tvIsPtr( val ) ) ) {
+        TVal name = recGet( state, p->names, val );
+        if( !tvIsUdf( name ) && !( tvIsObj( val ) && isNat( tvGetObj( val ) ) ) ) {
+            putCode( p, MSG_GLB );
+            putSym( p, tvGetSym( name ) );
+            return;
+        }
+    }
+    
+    // Images leave out anything else that can't be copied,
+    // rather than failing the whole snapshot over a fiber
+    // or string builder somewhere in a record.
+    if( p->names && ( tvIsPtr( val ) || ( tvIsObj( val ) && !canPack( p, tvGetObj( val ) ) ) ) ) {
+        putCode( p, MSG_UDF );
+        return;
+    }
+    
+    if( tvIsObj( val ) ) {
+        void* obj = tvGetObj( val );
+        if( !canPack( p, obj ) )
+            stateErrFmtA( state, ten_ERR_TYPE, "Can't transfer value of type %t", val );
+        
+        putCode( p, MSG_OBJ );
+        putU32( p, getObjId( p, obj ) );
+        return;
+    }
+    
+    switch( tvGetTag( val ) ) {
+        case VAL_UDF:
+            putCode( p, MSG_UDF );
+        break;
+        case VAL_NIL:
+            putCode( p, MSG_NIL );
+        break;
+        case VAL_LOG:
+            putCode( p, MSG_LOG );
+            *(uchar*)reserve( p, 1 ) = tvGetLog( val );
+        break;
+        case VAL_INT: {
+            IntT i = tvGetInt( val );
+            putCode( p, MSG_INT );
+            memcpy( reserve( p, sizeof(i) ), &i, sizeof(i) );
+        } break;
+        case VAL_DEC: {
+            DecT d = tvGetDec( val );
+            putCode( p, MSG_DEC );
+            memcpy( reserve( p, sizeof(d) ), &d, sizeof(d) );
+        } break;
+        case VAL_SYM: {
+            putCode( p, MSG_SYM );
+            putSym( p, tvGetSym( val ) );
+        } break;
+        default:
+            stateErrFmtA( state, ten_ERR_TYPE, "Can't transfer value of type %t", val );
+        break;
+    }
+}
+
+static void
+packBody( Packer* p, Record* rec ) {
+    Index* idx  = recIdx( rec );
+    TVal*  vals = recVals( rec );
+    uint   cap  = recCap( rec );
+    
+    // We don't know the field count ahead of time, so
+    // reserve a slot for it and fill it in at the end.
+    // Note that `reserve()` can move the buffer, so we
+    // keep track of the count's offset instead of its
+    // address.
+    size_t countAt = p->msg->len;
+    putU32( p, 0 );
+    
+    uint32_t count = 0;
+    for( uint i = 0 ; i < idx->map.cap ; i++ ) {
+        TVal key = idx->map.keys[i];
+        if( tvIsUdf( key ) )
+            continue;
+        
+        uint loc = idx->map.locs[i];
+        if( loc >= cap || tvIsUdf( vals[loc] ) )
+            continue;
+        
+        packVal( p, key );
+        packVal( p, vals[loc] );
+        count++;
+    }
+    memcpy( p->msg->buf + countAt, &count, sizeof(count) );
+}
+
+// A function body has its constants, label offsets, code, and
+// debug info.  The symbols in the debug info are put last so
+// the unpacker can allocate everything else before interning
+// them.
+static void
+packFun( Packer* p, Function* fun ) {
+    VirFun* vir = &fun->u.vir;
+    
+    for( uint i = 0 ; i < vir->nConsts ; i++ )
+        packVal( p, vir->consts[i] );
+    for( uint i = 0 ; i < vir->nLabels ; i++ )
+        putU32( p, vir->labels[i] - vir->code );
+    putBytes( p, (char*)vir->code, sizeof(instr)*vir->len );
+    
+    if( fun->vargIdx )
+        putU32( p, getObjId( p, fun->vargIdx ) + 1 );
+    else
+        putU32( p, 0 );
+    
+    DbgInfo* dbg = vir->dbg;
+    *(uchar*)reserve( p, 1 ) = dbg != NULL;
+    if( !dbg )
+        return;
+    
+    putU32( p, dbg->start );
+    putU32( p, dbg->nLines );
+    for( uint i = 0 ; i < dbg->nLines ; i++ ) {
+        LineInfo* line = &dbg->lines[i];
+        putU32( p, line->line );
+        putU32( p, line->start );
+        putU32( p, line->end );
+        if( line->text ) {
+            size_t len = strlen( line->text );
+            putU64( p, len );
+            putBytes( p, line->text, len );
+        }
+        else {
+            putU64( p, UINT64_MAX );
+        }
+    }
+    putSym( p, dbg->func );
+    putSym( p, dbg->file );
+}
+
+static void
+packCls( Packer* p, Closure* cls ) {
+    putU32( p, getObjId( p, cls->fun ) );
+    for( uint i = 0 ; i < cls->fun->u.vir.nUpvals ; i++ ) {
+        Upvalue* upv = cls->dat.upvals[i];
+        if( upv )
+            putU32( p, getObjId( p, upv ) + 1 );
+        else
+            putU32( p, 0 );
+    }
+}
+
+// A native closure's entry has everything needed to rebuild
+// its function, the symbols are again put last.  Referencing
+// the variadic index may add it to the object list, but since
+// the table is still being written that's fine.
+static void
+packNat( Packer* p, Closure* cls ) {
+    Function* fun = cls->fun;
+    NatFun*   nat = &fun->u.nat;
+    
+    putCode( p, MSG_NAT );
+    putBytes( p, (char*)&nat->cb, sizeof(nat->cb) );
+    putU32( p, fun->nParams );
+    if( fun->vargIdx )
+        putU32( p, getObjId( p, fun->vargIdx ) + 1 );
+    else
+        putU32( p, 0 );
+    *(uchar*)reserve( p, 1 ) = nat->params != NULL;
+    
+    TVal name = recGet( p->state, p->names, tvObj( cls ) );
+    *(uchar*)reserve( p, 1 ) = !tvIsUdf( name );
+    if( !tvIsUdf( name ) )
+        putSym( p, tvGetSym( name ) );
+    
+    putSym( p, nat->name );
+    for( uint i = 0 ; nat->params && i < fun->nParams ; i++ )
+        putSym( p, nat->params[i] );
+}
+
+static uint
+getIdxId( Packer* p, Index* idx, uint* nIdxs ) {
+    State* state = p->state;
+    
+    TVal id = recGet( state, p->idxIds, tvObj( idx ) );
+    if( tvIsUdf( id ) ) {
+        id = tvInt( *nIdxs );
+        (*nIdxs)++;
+        recDef( state, p->idxIds, tvObj( idx ), id );
+    }
+    return tvGetInt( id );
+}
+
+static Msg*
+pack( State* state, Tup* tup, Record* names ) {
+    ten_MemCb frealloc = state->config.frealloc;
+    void*     udata    = state->config.udata;
+    
+    size_t cap = 64;
+    Msg*   msg = frealloc( udata, NULL, 0, sizeof(Msg) + cap );
+    if( !msg )
+        stateErrVal( state, ten_ERR_FATAL, state->errOutOfMem );
+    
+    msg->frealloc = frealloc;
+    msg->udata    = udata;
+    msg->cap      = cap;
+    msg->len      = 0;
+    msg->nVals    = tup->size;
+    msg->nObjs    = 0;
+    msg->nIdxs    = 0;
+    msg->objs     = 0;
+    
+    Packer p = {
+        .base   = { .cb = packerDefer },
+        .state  = state,
+        .msg    = msg,
+        .ids    = NULL,
+        .idxIds = NULL,
+        .names  = names
+    };
+    initObjBuf( state, &p.objs );
+    stateInstallDefer( state, (Defer*)&p );
+    
+    // The ID maps are kept on the stack to protect them from
+    // the GC; everything else is reachable from `tup`.
+    Tup idsTup = statePush( state, 2 );
+    tupSet( idsTup, 0, tvObj( idxNew( state ) ) );
+    p.ids = recNew( state, tvGetObj( tupGet( idsTup, 0 ) ) );
+    tupSet( idsTup, 0, tvObj( p.ids ) );
+    tupSet( idsTup, 1, tvObj( idxNew( state ) ) );
+    p.idxIds = recNew( state, tvGetObj( tupGet( idsTup, 1 ) ) );
+    tupSet( idsTup, 1, tvObj( p.idxIds ) );
+    
+    for( uint i = 0 ; i < tup->size ; i++ )
+        packVal( &p, tupGet( *tup, i ) );
+    
+    // Packing object bodies may discover more objects, which
+    // will be appended to the object list; so it's important
+    // that we check the list size on each iteration.
+    for( uint i = 0 ; i < p.objs.top ; i++ ) {
+        void* obj = p.objs.buf[i];
+        switch( datGetTag( obj ) ) {
+            case OBJ_REC:
+                packBody( &p, obj );
+            break;
+            case OBJ_FUN:
+                packFun( &p, obj );
+            break;
+            case OBJ_CLS:
+                if( !isNat( obj ) )
+                    packCls( &p, obj );
+            break;
+            case OBJ_UPV:
+                packVal( &p, ((Upvalue*)obj)->val );
+            break;
+        }
+    }
+    
+    // Now the object table.  Index IDs are assigned here,
+    // in the order of first reference.
+    p.msg->objs  = p.msg->len;
+    
+    uint nIdxs = 0;
+    for( uint i = 0 ; i < p.objs.top ; i++ ) {
+        void* obj = p.objs.buf[i];
+        switch( datGetTag( obj ) ) {
+            case OBJ_STR: {
+                String* str = obj;
+                putCode( &p, MSG_STR );
+                putU64( &p, str->len );
+                putBytes( &p, str->buf, str->len );
+            } break;
+            case OBJ_REC: {
+                Record* rec = obj;
+                putCode( &p, MSG_REC );
+                putU32( &p, getIdxId( &p, recIdx( rec ), &nIdxs ) );
+                *(uchar*)reserve( &p, 1 ) = recIsSep( rec ) != 0;
+            } break;
+            case OBJ_IDX: {
+                putCode( &p, MSG_IDX );
+                putU32( &p, getIdxId( &p, obj, &nIdxs ) );
+            } break;
+            case OBJ_FUN: {
+                Function* fun = obj;
+                putCode( &p, MSG_FUN );
+                putU32( &p, fun->nParams );
+                putU32( &p, fun->u.vir.nConsts );
+                putU32( &p, fun->u.vir.nLabels );
+                putU32( &p, fun->u.vir.nUpvals );
+                putU32( &p, fun->u.vir.nLocals );
+                putU32( &p, fun->u.vir.nTemps );
+                putU32( &p, fun->u.vir.len );
+            } break;
+            case OBJ_CLS: {
+                if( isNat( obj ) ) {
+                    packNat( &p, obj );
+                    break;
+                }
+                
+                // The closure's function was already given
+                // an ID when the body was packed.
+                Closure* cls = obj;
+                putCode( &p, MSG_CLS );
+                putU32( &p, getObjId( &p, cls->fun ) );
+            } break;
+            case OBJ_UPV: {
+                putCode( &p, MSG_UPV );
+            } break;
+        }
+    }
+    p.msg->nObjs = p.objs.top;
+    p.msg->nIdxs = nIdxs;
+    
+    statePop( state ); // idsTup
+    
+    msg   = p.msg;
+    p.msg = NULL;
+    stateCommitDefer( state, (Defer*)&p );
+    
+    return msg;
+}
+
+Msg*
+msgPack( State* state, Tup* tup ) {
+    if( tup->size > TUP_MAX )
+        stateErrFmtA( state, ten_ERR_LIMIT, "Too many values in message" );
+    return pack( state, tup, NULL );
+}
+
+typedef struct {
+    char const* ptr;
+} Reader;
+
+static uint32_t
+getU32( Reader* r ) {
+    uint32_t u;
+    memcpy( &u, r->ptr, sizeof(u) );
+    r->ptr += sizeof(u);
+    return u;
+}
+
+static uint64_t
+getU64( Reader* r ) {
+    uint64_t u;
+    memcpy( &u, r->ptr, sizeof(u) );
+    r->ptr += sizeof(u);
+    return u;
+}
+
+static SymT
+getSym( State* state, Reader* r ) {
+    size_t len = getU64( r );
+    SymT   sym = symGet( state, r->ptr, len );
+    r->ptr += len;
+    return sym;
+}
+
+static void
+skipSym( Reader* r ) {
+    size_t len = getU64( r );
+    r->ptr += len;
+}
+
+static void
+skipNat( Reader* r ) {
+    r->ptr += sizeof(ten_FunCb);
+    uint nParams   = getU32( r );
+    r->ptr += sizeof(uint32_t);
+    bool hasParams = *(uchar*)r->ptr++;
+    if( *(uchar*)r->ptr++ )
+        skipSym( r );
+    
+    skipSym( r );
+    for( uint i = 0 ; hasParams && i < nParams ; i++ )
+        skipSym( r );
+}
+
+static TVal
+unpackVal( State* state, Reader* r, Tup* objs ) {
+    MsgCode code = *(uchar*)r->ptr++;
+    switch( code ) {
+        case MSG_UDF:
+            return tvUdf();
+        case MSG_NIL:
+            return tvNil();
+        case MSG_LOG:
+            return tvLog( *(uchar*)r->ptr++ );
+        case MSG_INT: {
+            IntT i;
+            memcpy( &i, r->ptr, sizeof(i) );
+            r->ptr += sizeof(i);
+            return tvInt( i );
+        }
+        case MSG_DEC: {
+            DecT d;
+            memcpy( &d, r->ptr, sizeof(d) );
+            r->ptr += sizeof(d);
+            return tvDec( d );
+        }
+        case MSG_SYM: {
+            SymT sym = getSym( state, r );
+            return tvSym( sym );
+        }
+        case MSG_GLB: {
+            SymT  name = getSym( state, r );
+            TVal* glob = envGetGlobalByName( state, name );
+            if( !glob )
+                return tvUdf();
+            if( tvIsObjType( *glob, OBJ_UPV ) )
+                return ((Upvalue*)tvGetObj( *glob ))->val;
+            return *glob;
+        }
+        case MSG_OBJ: {
+            uint id = getU32( r );
+            return tupGet( *objs, id );
+        }
+        default:
+            tenAssertNeverReached();
+            return tvUdf();
+    }
+}
+
+static Function*
+allocFun( State* state, Reader* r ) {
+    uint nParams = getU32( r );
+    uint nConsts = getU32( r );
+    uint nLabels = getU32( r );
+    uint nUpvals = getU32( r );
+    uint nLocals = getU32( r );
+    uint nTemps  = getU32( r );
+    uint len     = getU32( r );
+    
+    Function* fun = funNewVir( state, nParams, NULL );
+    VirFun*   vir = &fun->u.vir;
+    
+    // Push the function right away to protect it from
+    // the GC while we allocate its buffers, and only
+    // set each count along with the buffer it sizes.
+    Tup funTup = statePush( state, 1 );
+    tupSet( funTup, 0, tvObj( fun ) );
+    
+    Part constsP;
+    TVal* consts = stateAllocRaw( state, &constsP, sizeof(TVal)*nConsts );
+    for( uint i = 0 ; i < nConsts ; i++ )
+        consts[i] = tvUdf();
+    vir->consts  = consts;
+    vir->nConsts = nConsts;
+    stateCommitRaw( state, &constsP );
+    
+    Part labelsP;
+    instr** labels = stateAllocRaw( state, &labelsP, sizeof(instr*)*nLabels );
+    vir->labels  = labels;
+    vir->nLabels = nLabels;
+    stateCommitRaw( state, &labelsP );
+    
+    Part codeP;
+    instr* code = stateAllocRaw( state, &codeP, sizeof(instr)*len );
+    vir->code = code;
+    vir->len  = len;
+    stateCommitRaw( state, &codeP );
+    
+    vir->nUpvals = nUpvals;
+    vir->nLocals = nLocals;
+    vir->nTemps  = nTemps;
+    
+    statePop( state ); // funTup
+    return fun;
+}
+
+static void
+unpackFun( State* state, Reader* r, Tup* objs, Tup* globs, Function* fun ) {
+    VirFun* vir = &fun->u.vir;
+    
+    for( uint i = 0 ; i < vir->nConsts ; i++ )
+        vir->consts[i] = unpackVal( state, r, objs );
+    for( uint i = 0 ; i < vir->nLabels ; i++ )
+        vir->labels[i] = vir->code + getU32( r );
+    memcpy( vir->code, r->ptr, sizeof(instr)*vir->len );
+    r->ptr += sizeof(instr)*vir->len;
+    
+    // Global variables may have different locations in
+    // the receiving State, so global references have to
+    // be relocated.
+    for( uint i = 0 ; globs && i < vir->len ; i++ ) {
+        uint opc = inGetOpc( vir->code[i] );
+        if( opc != OPC_GET_GLOBAL && opc != OPC_REF_GLOBAL )
+            continue;
+        
+        uint loc = tvGetInt( tupGet( *globs, inGetOpr( vir->code[i] ) ) );
+        if( loc > IN_OPR_MAX )
+            stateErrFmtA( state, ten_ERR_LIMIT, "Too many global variables for image" );
+        vir->code[i] = inMake( opc, loc );
+    }
+    
+    uint vargId = getU32( r );
+    if( vargId > 0 )
+        fun->vargIdx = tvGetObj( tupGet( *objs, vargId - 1 ) );
+    
+    if( !*(uchar*)r->ptr++ )
+        return;
+    
+    // The debug info's symbols are stored after everything
+    // else, so they're interned after the debug info is
+    // attached to the function and can be marked.
+    Part dbgP;
+    DbgInfo* dbg = stateAllocRaw( state, &dbgP, sizeof(DbgInfo) );
+    dbg->start  = getU32( r );
+    dbg->nLines = getU32( r );
+    
+    Part linesP;
+    LineInfo* lines = stateAllocRaw( state, &linesP, sizeof(LineInfo)*dbg->nLines );
+    for( uint i = 0 ; i < dbg->nLines ; i++ )
+        lines[i].text = NULL;
+    dbg->lines = lines;
+    dbg->func  = symGet( state, "", 0 );
+    dbg->file  = dbg->func;
+    vir->dbg   = dbg;
+    stateCommitRaw( state, &dbgP );
+    stateCommitRaw( state, &linesP );
+    
+    for( uint i = 0 ; i < dbg->nLines ; i++ ) {
+        LineInfo* line = &dbg->lines[i];
+        line->line  = getU32( r );
+        line->start = getU32( r );
+        line->end   = getU32( r );
+        
+        uint64_t len = getU64( r );
+        if( len == UINT64_MAX )
+            continue;
+        
+        Part  textP;
+        char* text = stateAllocRaw( state, &textP, len + 1 );
+        memcpy( text, r->ptr, len );
+        text[len] = '\0';
+        line->text = text;
+        stateCommitRaw( state, &textP );
+        r->ptr += len;
+    }
+    
+    dbg->func = getSym( state, r );
+    dbg->file = getSym( state, r );
+}
+
+static Closure*
+unpackNat( State* state, Reader* r, Tup* objs ) {
+    ten_FunCb cb;
+    memcpy( &cb, r->ptr, sizeof(cb) );
+    r->ptr += sizeof(cb);
+    
+    uint nParams   = getU32( r );
+    uint vargId    = getU32( r );
+    bool hasParams = *(uchar*)r->ptr++;
+    
+    // If the global the closure was found in has a closure
+    // with the same callback in this State then use that
+    // instead, this saves making a copy of every prelude
+    // function referenced by the image.
+    if( *(uchar*)r->ptr++ ) {
+        SymT  name = getSym( state, r );
+        TVal* glob = envGetGlobalByName( state, name );
+        TVal  val  = glob ? *glob : tvUdf();
+        if( tvIsObjType( val, OBJ_UPV ) )
+            val = ((Upvalue*)tvGetObj( val ))->val;
+        
+        if( tvIsObj( val ) && isNat( tvGetObj( val ) ) ) {
+            Closure* cls = tvGetObj( val );
+            if( cls->fun->u.nat.cb == cb ) {
+                skipSym( r );
+                for( uint i = 0 ; hasParams && i < nParams ; i++ )
+                    skipSym( r );
+                return cls;
+            }
+        }
+    }
+    
+    Index* vargIdx = NULL;
+    if( vargId > 0 )
+        vargIdx = tvGetObj( tupGet( *objs, vargId - 1 ) );
+    
+    Function* fun = funNewNat( state, nParams, vargIdx, cb );
+    Tup funTup = statePush( state, 1 );
+    tupSet( funTup, 0, tvObj( fun ) );
+    
+    // The parameter names are initialized to a valid
+    // symbol so the function can be marked while the
+    // real ones are interned.
+    NatFun* nat = &fun->u.nat;
+    if( hasParams ) {
+        Part paramsP;
+        SymT* params = stateAllocRaw( state, &paramsP, sizeof(SymT)*nParams );
+        for( uint i = 0 ; i < nParams ; i++ )
+            params[i] = nat->name;
+        nat->params = params;
+        stateCommitRaw( state, &paramsP );
+    }
+    
+    nat->name = getSym( state, r );
+    for( uint i = 0 ; hasParams && i < nParams ; i++ )
+        nat->params[i] = getSym( state, r );
+    
+    Closure* cls = clsNewNat( state, fun, NULL );
+    
+    statePop( state ); // funTup
+    return cls;
+}
+
+// Unpacks the message's values into `vals` and its objects
+// into `objs`; `idxs` should have a slot for each index.  For
+// images `globs` maps the global locations of the packing
+// State to those of this one, and is filled in by `bind()`
+// before any functions are unpacked.
+static void
+unpack(
+    State* state, Msg* msg, Tup* vals, Tup* objs, Tup* idxs,
+    Tup* globs, void (*bind)( State* state, Tup* vals, Tup* globs )
+) {
+    
+    // Allocate all the objects first, so values and object
+    // bodies can refer to them by ID.  Closures go last, since
+    // they need their function to be allocated first.
+    Reader r = { .ptr = msg->buf + msg->objs };
+    for( uint i = 0 ; i < msg->nObjs ; i++ ) {
+        MsgCode code = *(uchar*)r.ptr++;
+        switch( code ) {
+            case MSG_STR: {
+                size_t  len = getU64( &r );
+                String* str = strNew( state, r.ptr, len );
+                r.ptr += len;
+                tupSet( *objs, i, tvObj( str ) );
+            } break;
+            case MSG_REC: {
+                uint id = getU32( &r );
+                r.ptr++;
+                
+                if( tvIsUdf( tupGet( *idxs, id ) ) )
+                    tupSet( *idxs, id, tvObj( idxNew( state ) ) );
+                
+                Record* rec = recNew( state, tvGetObj( tupGet( *idxs, id ) ) );
+                tupSet( *objs, i, tvObj( rec ) );
+            } break;
+            case MSG_IDX: {
+                uint id = getU32( &r );
+                if( tvIsUdf( tupGet( *idxs, id ) ) )
+                    tupSet( *idxs, id, tvObj( idxNew( state ) ) );
+                tupSet( *objs, i, tupGet( *idxs, id ) );
+            } break;
+            case MSG_FUN: {
+                Function* fun = allocFun( state, &r );
+                tupSet( *objs, i, tvObj( fun ) );
+            } break;
+            case MSG_CLS: {
+                r.ptr += sizeof(uint32_t);
+            } break;
+            case MSG_UPV: {
+                Upvalue* upv = upvNew( state, tvUdf() );
+                tupSet( *objs, i, tvObj( upv ) );
+            } break;
+            case MSG_NAT: {
+                skipNat( &r );
+            } break;
+            default: {
+                tenAssertNeverReached();
+            } break;
+        }
+    }
+    
+    r.ptr = msg->buf + msg->objs;
+    for( uint i = 0 ; i < msg->nObjs ; i++ ) {
+        MsgCode code = *(uchar*)r.ptr++;
+        switch( code ) {
+            case MSG_STR:
+                r.ptr += getU64( &r );
+            break;
+            case MSG_REC:
+                r.ptr += sizeof(uint32_t) + 1;
+            break;
+            case MSG_IDX:
+                r.ptr += sizeof(uint32_t);
+            break;
+            case MSG_FUN:
+                r.ptr += sizeof(uint32_t)*7;
+            break;
+            case MSG_CLS: {
+                uint      id  = getU32( &r );
+                Function* fun = tvGetObj( tupGet( *objs, id ) );
+                Closure*  cls = clsNewVir( state, fun, NULL );
+                tupSet( *objs, i, tvObj( cls ) );
+            } break;
+            case MSG_NAT: {
+                Closure* cls = unpackNat( state, &r, objs );
+                tupSet( *objs, i, tvObj( cls ) );
+            } break;
+            default:
+            break;
+        }
+    }
+    
+    r.ptr = msg->buf;
+    for( uint i = 0 ; i < msg->nVals ; i++ )
+        tupSet( *vals, i, unpackVal( state, &r, objs ) );
+    
+    if( bind )
+        bind( state, vals, globs );
+    
+    // Temporary slots for record keys and values, since a
+    // freshly interned symbol could otherwise be collected
+    // while unpacking or defining the other.
+    Tup tmpTup = statePush( state, 2 );
+    
+    for( uint i = 0 ; i < msg->nObjs ; i++ ) {
+        TVal obj = tupGet( *objs, i );
+        if( !tvIsObj( obj ) )
+            continue;
+        
+        switch( datGetTag( tvGetObj( obj ) ) ) {
+            case OBJ_REC: {
+                Record* rec   = tvGetObj( obj );
+                uint    count = getU32( &r );
+                for( uint j = 0 ; j < count ; j++ ) {
+                    tupSet( tmpTup, 0, unpackVal( state, &r, objs ) );
+                    tupSet( tmpTup, 1, unpackVal( state, &r, objs ) );
+                    
+                    // Fields keyed by something left out of an
+                    // image are dropped along with it.
+                    if( tvIsUdf( tupGet( tmpTup, 0 ) ) )
+                        continue;
+                    recDef( state, rec, tupGet( tmpTup, 0 ), tupGet( tmpTup, 1 ) );
+                }
+            } break;
+            case OBJ_FUN: {
+                unpackFun( state, &r, objs, globs, tvGetObj( obj ) );
+            } break;
+            case OBJ_CLS: {
+                Closure* cls = tvGetObj( obj );
+                if( cls->fun->type != FUN_VIR )
+                    break;
+                
+                r.ptr += sizeof(uint32_t);
+                for( uint j = 0 ; j < cls->fun->u.vir.nUpvals ; j++ ) {
+                    uint id = getU32( &r );
+                    if( id > 0 )
+                        cls->dat.upvals[j] = tvGetObj( tupGet( *objs, id - 1 ) );
+                }
+            } break;
+            case OBJ_UPV: {
+                Upvalue* upv = tvGetObj( obj );
+                upv->val = unpackVal( state, &r, objs );
+            } break;
+        }
+    }
+    tenAssert( r.ptr == msg->buf + msg->objs );
+    
+    // Separation has to wait until the records are populated,
+    // otherwise each would get its own copy of the Index.
+    for( uint i = 0 ; i < msg->nObjs ; i++ ) {
+        MsgCode code = *(uchar*)r.ptr++;
+        switch( code ) {
+            case MSG_STR:
+                r.ptr += getU64( &r );
+            break;
+            case MSG_REC:
+                r.ptr += sizeof(uint32_t);
+                if( *(uchar*)r.ptr++ )
+                    recSep( state, tvGetObj( tupGet( *objs, i ) ) );
+            break;
+            case MSG_IDX:
+            case MSG_CLS:
+                r.ptr += sizeof(uint32_t);
+            break;
+            case MSG_FUN:
+                r.ptr += sizeof(uint32_t)*7;
+            break;
+            case MSG_NAT:
+                skipNat( &r );
+            break;
+            default:
+            break;
+        }
+    }
+    
+    statePop( state ); // tmpTup
+}
+
+Tup
+msgUnpack( State* state, Msg* msg ) {
+    Tup vals = statePush( state, msg->nVals );
+    Tup objs = statePush( state, msg->nObjs );
+    Tup idxs = statePush( state, msg->nIdxs );
+    
+    unpack( state, msg, &vals, &objs, &idxs, NULL, NULL );
+    
+    statePop( state ); // idxs
+    statePop( state ); // objs
+    
+    return vals;
+}
+
+// An image is packed from a tuple with the name of each
+// global variable, in order of location, followed by
+// their values.
+static void
+snapGlobal( State* state, void* udat, SymT name, uint loc ) {
+    Tup* globs = udat;
+    uint n     = globs->size/2;
+    
+    tupSet( *globs, loc, tvSym( name ) );
+    tupSet( *globs, n + loc, *envGetGlobalByLoc( state, loc ) );
+}
+
+static bool
+bindByName( TVal val ) {
+    if( tvIsPtr( val ) )
+        return true;
+    if( !tvIsObj( val ) )
+        return false;
+    
+    void* obj = tvGetObj( val );
+    switch( datGetTag( obj ) ) {
+        case OBJ_FIB:
+        case OBJ_DAT:
+            return true;
+        case OBJ_FUN:
+            return ((Function*)obj)->type == FUN_NAT;
+        case OBJ_CLS:
+            return ((Closure*)obj)->fun->type == FUN_NAT && !isNat( obj );
+        default:
+            return false;
+    }
+}
+
+Msg*
+msgPackImage( State* state ) {
+    uint n = envNumGlobals( state );
+    
+    Tup namesTup = statePush( state, 1 );
+    tupSet( namesTup, 0, tvObj( idxNew( state ) ) );
+    Record* names = recNew( state, tvGetObj( tupGet( namesTup, 0 ) ) );
+    tupSet( namesTup, 0, tvObj( names ) );
+    
+    Tup globs = statePush( state, n*2 );
+    envForEachGlobal( state, &globs, snapGlobal );
+    
+    // Values which can't be copied are bound by name, this
+    // is how native functions, data objects, and pointers
+    // are re-bound in the receiving State.  If a value is
+    // in more than one global then the first defined is
+    // used, since it's most likely the original name.  The
+    // names of native closures are recorded as well, so the
+    // receiving State's own closures can be reused.
+    for( uint i = 0 ; i < n ; i++ ) {
+        TVal val = tupGet( globs, n + i );
+        if( tvIsObjType( val, OBJ_UPV ) )
+            val = ((Upvalue*)tvGetObj( val ))->val;
+        
+        bool named = bindByName( val ) || ( tvIsObj( val ) && isNat( tvGetObj( val ) ) );
+        if( named && tvIsUdf( recGet( state, names, val ) ) )
+            recDef( state, names, val, tupGet( globs, i ) );
+    }
+    
+    Msg* img = pack( state, &globs, names );
+    
+    statePop( state ); // globs
+    statePop( state ); // namesTup
+    return img;
+}
+
+static void
+bindGlobals( State* state, Tup* vals, Tup* globs ) {
+    uint n = vals->size/2;
+    for( uint i = 0 ; i < n ; i++ ) {
+        SymT name = tvGetSym( tupGet( *vals, i ) );
+        uint loc  = envAddGlobal( state, name );
+        tupSet( *globs, i, tvInt( loc ) );
+    }
+}
+
+void
+msgLoadImage( State* state, Msg* img ) {
+    uint n = img->nVals/2;
+    
+    Tup vals  = statePush( state, img->nVals );
+    Tup objs  = statePush( state, img->nObjs );
+    Tup idxs  = statePush( state, img->nIdxs );
+    Tup globs = statePush( state, n );
+    
+    unpack( state, img, &vals, &objs, &idxs, &globs, bindGlobals );
+    
+    // Undefined globals are skipped, so they don't clobber
+    // anything the host has already defined.  Globals which
+    // have been captured as upvalues are updated in place.
+    for( uint i = 0 ; i < n ; i++ ) {
+        TVal val = tupGet( vals, n + i );
+        if( tvIsUdf( val ) )
+            continue;
+        
+        TVal* glob = envGetGlobalByLoc( state, tvGetInt( tupGet( globs, i ) ) );
+        if( tvIsObjType( *glob, OBJ_UPV ) && !tvIsObjType( val, OBJ_UPV ) )
+            ((Upvalue*)tvGetObj( *glob ))->val = val;
+        else
+            *glob = val;
+    }
+    
+    statePop( state ); // globs
+    statePop( state ); // idxs
+    statePop( state ); // objs
+    statePop( state ); // vals
+}
+
+Msg*
+msgMakeStr( ten_MemCb frealloc, void* udata, char const* str, size_t len ) {
+    uint32_t id   = 0;
+    uint64_t slen = len;
+    size_t   vlen = 1 + sizeof(id);
+    size_t   cap  = vlen + 1 + sizeof(slen) + len;
+    
+    Msg* msg = frealloc( udata, NULL, 0, sizeof(Msg) + cap );
+    if( !msg )
+        return NULL;
+    
+    msg->frealloc = frealloc;
+    msg->udata    = udata;
+    msg->cap      = cap;
+    msg->len      = cap;
+    msg->nVals    = 1;
+    msg->nObjs    = 1;
+    msg->nIdxs    = 0;
+    msg->objs     = vlen;
+    
+    char* ptr = msg->buf;
+    *ptr++ = MSG_OBJ;
+    memcpy( ptr, &id, sizeof(id) );
+    ptr += sizeof(id);
+    *ptr++ = MSG_STR;
+    memcpy( ptr, &slen, sizeof(slen) );
+    ptr += sizeof(slen);
+    memcpy( ptr, str, len );
+    
+    return msg;
+}
+
+void
+msgFree( Msg* msg ) {
+    msg->frealloc( msg->udata, msg, sizeof(Msg) + msg->cap, 0 );
+}
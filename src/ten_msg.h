@@ -0,0 +1,82 @@
+/**********************************************************************
+This component implements messages, which are self-contained copies
+of a tuple of Ten values that can be moved between separate instances
+of the runtime.  A message is packed from the values of one State and
+unpacked into (possibly many) others; it doesn't reference memory owned
+by either State, so it can be handed to a different thread once packed.
+
+Only data values can be transferred this way: `udf`, `nil`, logicals,
+integers, decimals, symbols, strings, and records.  Records are copied
+deeply, but shared references (including cycles) and records sharing
+an Index are preserved in the copy.  Symbols are transferred by name
+and re-interned by the receiving State.
+
+The same encoding is used for images, which are snapshots of a State's
+global variables that can be loaded into other States to skip running
+the code that defined them.  Images can also contain virtual closures,
+along with their functions and upvalues; and any value which still
+can't be copied (native closures, fibers, data objects, and pointers)
+is bound by the name of a global variable it was found in, to be
+looked up again in the receiving State; or left out, as `udf`, if
+it isn't in a global.  Global variable locations are relocated as
+each function is unpacked.
+**********************************************************************/
+
+#ifndef ten_msg_h
+#define ten_msg_h
+#include "ten.h"
+#include "ten_types.h"
+#include <stddef.h>
+
+typedef struct Msg Msg;
+
+struct Msg {
+    
+    // The allocator that owns the message buffer.  We keep
+    // a copy here since the message may be released by a
+    // different State, or none at all.
+    ten_MemCb frealloc;
+    void*     udata;
+    
+    // The message is encoded into the trailing buffer, `cap`
+    // gives its allocated size and `len` its used size.
+    size_t cap;
+    size_t len;
+    
+    // Number of values in the packed tuple, number of heap
+    // objects (strings, records, etc.), and number of distinct
+    // indices referenced by the records.  The object table
+    // is placed after the values and record bodies, at the
+    // `objs` offset.
+    uint   nVals;
+    uint   nObjs;
+    uint   nIdxs;
+    size_t objs;
+    
+    char buf[];
+};
+
+Msg*
+msgPack( State* state, Tup* tup );
+
+Tup
+msgUnpack( State* state, Msg* msg );
+
+Msg*
+msgMakeStr( ten_MemCb frealloc, void* udata, char const* str, size_t len );
+
+void
+msgFree( Msg* msg );
+
+// Snapshot the State's global variables.
+Msg*
+msgPackImage( State* state );
+
+// Define the global variables from an image in the State,
+// native functions and other values bound by name in the
+// image should already be defined; any that aren't come
+// out as `udf`.
+void
+msgLoadImage( State* state, Msg* img );
+
+#endif
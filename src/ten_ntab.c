@@ -141,6 +141,17 @@ ntabGet( State* state, NTab* ntab, SymT name ) {
     return UINT_MAX;
 }
 
+void
+ntabForEach( State* state, NTab* ntab, void* udat, ProcNameCb proc ) {
+    for( uint i = 0 ; i < ntab->map.cap ; i++ ) {
+        NameNode* node = ntab->map.buf[i];
+        while( node ) {
+            proc( state, udat, node->name, node->loc );
+            node = node->next;
+        }
+    }
+}
+
 static void
 growMap( State* state, NTab* ntab ) {
     uint mcap;
@@ -23,4 +23,9 @@ ntabAdd( State* state, NTab* ntab, SymT name );
 uint
 ntabGet( State* state, NTab* ntab, SymT name );
 
+typedef void (*ProcNameCb)( State* state, void* udat, SymT name, uint loc );
+
+void
+ntabForEach( State* state, NTab* ntab, void* udat, ProcNameCb proc );
+
 #endif
@@ -0,0 +1,639 @@
+#include "ten_pool.h"
+#include "ten_msg.h"
+#include "ten_state.h"
+#include "ten_assert.h"
+#include "ten_macros.h"
+#include "ten_sym.h"
+#include "ten_str.h"
+#include "ten_rec.h"
+#include "ten_cls.h"
+#include "ten_fib.h"
+#include "ten_sync.h"
+#include <string.h>
+
+#ifndef ten_NO_THREADS
+
+#include <pthread.h>
+#include <setjmp.h>
+#include <sched.h>
+
+// Intrusive link for the job queues, this is kept as the first
+// member of each Job so we can convert between the two.
+typedef struct Link {
+    struct Link* next;
+} Link;
+
+// Worker inboxes are Dmitry Vyukov's intrusive MPSC queue.  Any
+// number of threads can push to the queue with a single atomic
+// exchange, but only the owning worker can pop.  The queue has
+// a stub node which allows it to be empty without the producers
+// and consumer touching the same pointer.
+typedef struct {
+    Link* head;
+    Link* tail;
+    Link  stub;
+} Queue;
+
+static void
+queueInit( Queue* q ) {
+    q->stub.next = NULL;
+    q->head      = &q->stub;
+    q->tail      = &q->stub;
+}
+
+static void
+queuePush( Queue* q, Link* link ) {
+    atomicStore( &link->next, NULL );
+    Link* prev = atomicSwap( &q->head, link );
+    atomicStore( &prev->next, link );
+}
+
+// Pop the oldest link from the queue.  This can spuriously return
+// NULL if a push is in progress; which is fine since the pusher
+// will wake the worker again once it's finished.
+static Link*
+queuePop( Queue* q ) {
+    Link* tail = q->tail;
+    Link* next = atomicLoad( &tail->next );
+    if( tail == &q->stub ) {
+        if( !next )
+            return NULL;
+        q->tail = next;
+        tail    = next;
+        next    = atomicLoad( &next->next );
+    }
+    if( next ) {
+        q->tail = next;
+        return tail;
+    }
+    
+    if( tail != atomicLoad( &q->head ) )
+        return NULL;
+    
+    queuePush( q, &q->stub );
+    next = atomicLoad( &tail->next );
+    if( next ) {
+        q->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+// Check whether the queue is really empty, with no push in
+// progress; unlike a NULL from `queuePop()`.
+static bool
+queueEmpty( Queue* q ) {
+    return q->tail == &q->stub && atomicLoad( &q->head ) == &q->stub;
+}
+
+typedef struct Worker Worker;
+
+struct Job {
+    Link  link;
+    Pool* pool;
+    
+    // The request and result messages.  The result is
+    // written by the worker before `done` is set, and
+    // taken by the submitter after.
+    Msg* req;
+    Msg* res;
+    bool failed;
+    bool taken;
+    
+    // Both the submitter and the worker hold a reference
+    // to the job, it's freed when both are released.
+    int done;
+    int refs;
+};
+
+struct Worker {
+    Pool*      pool;
+    pthread_t  thread;
+    ten_State* ten;
+    
+    // The job currently being run, this is how the runner
+    // closure finds the job to unpack.
+    Job* job;
+    
+    // Persistent stack slot holding the runner closure.
+    ten_Tup vars;
+    
+    // Inbox and the machinery for sleeping while it's empty.
+    // Submitters only take the lock if `sleeping` is set.
+    Queue           inbox;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    int             sleeping;
+    bool            starting;
+    bool            broken;
+};
+
+struct Pool {
+    ten_Config config;
+    void     (*setup)( ten_State* s, void* udata );
+    void*      udata;
+    
+    Worker* workers;
+    uint    nWorkers;
+    uint    next;
+    int     stop;
+    
+    // Each job holds a reference to the pool, as well as the
+    // pool's owner; so jobs whose futures outlive `poolFree()`
+    // can still be waited on and released.
+    int refs;
+    
+    // Job completion is signalled through a single pool-wide
+    // condition; waiters re-check their own job when woken.
+    pthread_mutex_t doneLock;
+    pthread_cond_t  doneCond;
+};
+
+static void*
+poolAlloc( Pool* pool, size_t size ) {
+    return pool->config.frealloc( pool->config.udata, NULL, 0, size );
+}
+
+static void
+poolDealloc( Pool* pool, void* ptr, size_t size ) {
+    pool->config.frealloc( pool->config.udata, ptr, size, 0 );
+}
+
+static void
+poolRelease( Pool* pool ) {
+    if( atomicSub( &pool->refs, 1 ) > 1 )
+        return;
+    
+    pthread_mutex_destroy( &pool->doneLock );
+    pthread_cond_destroy( &pool->doneCond );
+    poolDealloc( pool, pool, sizeof(Pool) );
+}
+
+
+static void
+jobFinish( Job* job, Msg* res, bool failed ) {
+    Pool* pool = job->pool;
+    
+    job->res    = res;
+    job->failed = failed;
+    
+    pthread_mutex_lock( &pool->doneLock );
+    atomicStore( &job->done, true );
+    pthread_cond_broadcast( &pool->doneCond );
+    pthread_mutex_unlock( &pool->doneLock );
+}
+
+static void
+jobFail( Job* job, char const* err ) {
+    Pool* pool = job->pool;
+    Msg*  res  = msgMakeStr( pool->config.frealloc, pool->config.udata, err, strlen( err ) );
+    jobFinish( job, res, true );
+}
+
+bool
+jobDone( Job* job ) {
+    return atomicLoad( &job->done );
+}
+
+Msg*
+jobWait( Job* job, bool* failed ) {
+    Pool* pool = job->pool;
+    tenAssert( !job->taken );
+    
+    if( !atomicLoad( &job->done ) ) {
+        pthread_mutex_lock( &pool->doneLock );
+        while( !atomicLoad( &job->done ) )
+            pthread_cond_wait( &pool->doneCond, &pool->doneLock );
+        pthread_mutex_unlock( &pool->doneLock );
+    }
+    
+    Msg* res = job->res;
+    *failed    = job->failed;
+    job->res   = NULL;
+    job->taken = true;
+    return res;
+}
+
+void
+jobRelease( Job* job ) {
+    if( atomicSub( &job->refs, 1 ) > 1 )
+        return;
+    
+    if( job->req )
+        msgFree( job->req );
+    if( job->res )
+        msgFree( job->res );
+    
+    Pool* pool = job->pool;
+    poolDealloc( pool, job, sizeof(Job) );
+    poolRelease( pool );
+}
+
+
+typedef enum {
+    Runner_CACHE,
+    Runner_LAST
+} RunnerMem;
+
+// Resolve the function value of a request, which is given either
+// as the name of a global or as the source of an expression which
+// evaluates to a closure.
+static Closure*
+getRunFun( State* state, Record* cache, Tup* tmp, TVal fun ) {
+    ten_State* ten = (ten_State*)state;
+    ten_Var    var = { .tup = (ten_Tup*)tmp, .loc = 0 };
+    
+    if( tvIsSym( fun ) ) {
+        ten_Var name = { .tup = (ten_Tup*)tmp, .loc = 1 };
+        varSet( name, fun );
+        ten_get( ten, &name, &var );
+    }
+    else {
+        String* src = tvGetObj( fun );
+        tupSet( *tmp, 1, tvSym( symGet( state, src->buf, src->len ) ) );
+        
+        TVal cls = recGet( state, cache, tupGet( *tmp, 1 ) );
+        if( tvIsUdf( cls ) ) {
+            ten_Source* s = ten_stringSource( ten, strBuf( state, src ), "<submit>" );
+            ten_compileExpr( ten, NULL, s, ten_SCOPE_LOCAL, ten_COM_CLS, &var );
+            
+            Tup args = statePush( state, 0 );
+            Tup rets = fibCall( state, tvGetObj( tupGet( *tmp, 0 ) ), &args );
+            tupSet( *tmp, 0, rets.size > 0 ? tupGet( rets, 0 ) : tvUdf() );
+            statePop( state ); // rets
+            statePop( state ); // args
+            
+            if( tvIsObjType( tupGet( *tmp, 0 ), OBJ_CLS ) )
+                recDef( state, cache, tupGet( *tmp, 1 ), tupGet( *tmp, 0 ) );
+        }
+        else {
+            tupSet( *tmp, 0, cls );
+        }
+    }
+    
+    TVal cls = tupGet( *tmp, 0 );
+    if( !tvIsObjType( cls, OBJ_CLS ) )
+        stateErrFmtA( state, ten_ERR_TYPE, "Submitted function is %t, need Cls", cls );
+    return tvGetObj( cls );
+}
+
+// Runs within a fresh fiber for each job, so any errors are
+// localized to the fiber and can be reported back to the
+// submitter.
+ten_define(runJob) {
+    State*  state = (State*)call->ten;
+    Worker* w     = *(Worker**)call->data;
+    Record* cache = tvGetObj( varGet( ten_mem( Runner_CACHE ) ) );
+    
+    Tup req = msgUnpack( state, w->job->req );
+    Tup tmp = statePush( state, 2 );
+    
+    tenAssert( req.size > 0 );
+    Closure* cls  = getRunFun( state, cache, &tmp, tupGet( req, 0 ) );
+    Tup      args = { .base = req.base, .offset = req.offset + 1, .size = req.size - 1 };
+    Tup      rets = fibCall( state, cls, &args );
+    
+    Msg* res = msgPack( state, &rets );
+    jobFinish( w->job, res, false );
+    
+    statePop( state ); // rets
+    statePop( state ); // tmp
+    statePop( state ); // req
+    
+    return ten_pushA( call->ten, "" );
+}
+
+static void
+workerStart( Worker* w, jmp_buf* errJmp ) {
+    Pool* pool = w->pool;
+    
+    ten_Config config = pool->config;
+    config.pool = NULL;
+    
+    w->ten = ten_make( &config, errJmp );
+    ten_State* ten = w->ten;
+    
+    w->vars = ten_pushA( ten, "U" );
+    ten_Var runVar = ten_var( w->vars, 0 );
+    
+    ten_Tup varTup = ten_pushA( ten, "UUUU" );
+    ten_Var idxVar = ten_var( varTup, 0 );
+    ten_Var recVar = ten_var( varTup, 1 );
+    ten_Var datVar = ten_var( varTup, 2 );
+    ten_Var funVar = ten_var( varTup, 3 );
+    
+    ten_DatInfo* info = ten_addDatInfo(
+        ten,
+        &(ten_DatConfig){
+            .tag   = "Runner",
+            .size  = sizeof(Worker*),
+            .mems  = Runner_LAST,
+            .destr = NULL
+        }
+    );
+    Worker** dat = ten_newDat( ten, info, &datVar );
+    *dat = w;
+    
+    ten_newIdx( ten, &idxVar );
+    ten_newRec( ten, &idxVar, &recVar );
+    ten_setMember( ten, &datVar, Runner_CACHE, &recVar );
+    
+    ten_FunParams p = {
+        .name   = "runJob",
+        .params = NULL,
+        .cb     = ten_fun(runJob)
+    };
+    ten_newFun( ten, &p, &funVar );
+    ten_newCls( ten, &funVar, &datVar, &runVar );
+    
+    ten_pop( ten ); // varTup
+    
+    if( pool->setup )
+        pool->setup( ten, pool->udata );
+}
+
+static void
+workerRun( Worker* w, Job* job ) {
+    ten_State* ten = w->ten;
+    
+    ten_Tup fibTup = ten_pushA( ten, "U" );
+    ten_Var fibVar = ten_var( fibTup, 0 );
+    ten_Var runVar = ten_var( w->vars, 0 );
+    ten_newFib( ten, &runVar, NULL, &fibVar );
+    
+    ten_Tup args = ten_pushA( ten, "" );
+    ten_cont( ten, &fibVar, &args );
+    ten_pop( ten ); // rets
+    ten_pop( ten ); // args
+    
+    // The runner finishes the job itself when successful, so if
+    // it isn't done then the fiber must have failed.
+    if( !jobDone( job ) ) {
+        tenAssert( ten_state( ten, &fibVar ) == ten_FIB_FAILED );
+        jobFail( job, ten_getErrStr( ten, &fibVar ) );
+    }
+    
+    ten_pop( ten ); // fibTup
+}
+
+static void
+workerFatal( Worker* w ) {
+    State* state = (State*)w->ten;
+    Job*   job   = w->job;
+    
+    // We can't do anything with the State itself at this point
+    // since it might be in a broken state; so the error message
+    // is copied directly from the error value if possible.
+    if( job && !jobDone( job ) ) {
+        TVal err = state ? state->errVal : tvUdf();
+        if( tvIsObjType( err, OBJ_STR ) ) {
+            Pool*   pool = w->pool;
+            String* str  = tvGetObj( err );
+            Msg*    res  = msgMakeStr( pool->config.frealloc, pool->config.udata, str->buf, str->len );
+            jobFinish( job, res, true );
+        }
+        else {
+            jobFail( job, "Fatal error in worker" );
+        }
+    }
+    if( job )
+        jobRelease( job );
+    w->job = NULL;
+    
+    if( w->ten )
+        ten_free( w->ten );
+    w->ten = NULL;
+}
+
+static Job*
+workerNext( Worker* w ) {
+    Link* link = queuePop( &w->inbox );
+    if( link )
+        return (Job*)link;
+    
+    pthread_mutex_lock( &w->lock );
+    atomicStore( &w->sleeping, true );
+    for( ;; ) {
+        link = queuePop( &w->inbox );
+        if( link )
+            break;
+        
+        // Once stopping, keep going until the queue is drained.
+        // A NULL while a push is in progress would otherwise drop
+        // the job, so wait for the push to land.
+        if( atomicLoad( &w->pool->stop ) ) {
+            if( queueEmpty( &w->inbox ) )
+                break;
+            sched_yield();
+            continue;
+        }
+        pthread_cond_wait( &w->wake, &w->lock );
+    }
+    atomicStore( &w->sleeping, false );
+    pthread_mutex_unlock( &w->lock );
+    
+    return (Job*)link;
+}
+
+static void*
+workerMain( void* udata ) {
+    Worker* w = udata;
+    
+    // Fatal errors, which can't be localized to the job's fiber,
+    // jump back here.  The State is discarded and a new one will
+    // be created for the next job.  If the State can't even be
+    // initialized then the worker is marked as broken, and will
+    // fail all of its jobs.
+    jmp_buf errJmp;
+    if( setjmp( errJmp ) ) {
+        if( w->starting )
+            w->broken = true;
+        w->starting = false;
+        workerFatal( w );
+    }
+    
+    for( ;; ) {
+        Job* job = workerNext( w );
+        if( !job )
+            break;
+        w->job = job;
+        
+        if( !w->ten && !w->broken ) {
+            w->starting = true;
+            workerStart( w, &errJmp );
+            w->starting = false;
+        }
+        
+        if( w->broken )
+            jobFail( job, "Worker failed to initialize" );
+        else
+            workerRun( w, job );
+        
+        w->job = NULL;
+        jobRelease( job );
+    }
+    
+    if( w->ten )
+        ten_free( w->ten );
+    w->ten = NULL;
+    
+    return NULL;
+}
+
+Pool*
+poolMake( ten_Config const* config, uint workers, void (*setup)( ten_State* s, void* udata ), void* udata ) {
+    if( workers == 0 )
+        return NULL;
+    
+    Pool* pool = config->frealloc( config->udata, NULL, 0, sizeof(Pool) );
+    if( !pool )
+        return NULL;
+    
+    pool->config      = *config;
+    pool->config.pool = NULL;
+    pool->setup       = setup;
+    pool->udata       = udata;
+    pool->next        = 0;
+    pool->stop        = false;
+    pool->refs        = 1;
+    pool->nWorkers    = 0;
+    pool->workers     = poolAlloc( pool, sizeof(Worker)*workers );
+    if( !pool->workers ) {
+        poolDealloc( pool, pool, sizeof(Pool) );
+        return NULL;
+    }
+    
+    pthread_mutex_init( &pool->doneLock, NULL );
+    pthread_cond_init( &pool->doneCond, NULL );
+    
+    for( uint i = 0 ; i < workers ; i++ ) {
+        Worker* w = &pool->workers[i];
+        w->pool     = pool;
+        w->ten      = NULL;
+        w->job      = NULL;
+        w->sleeping = false;
+        w->starting = false;
+        w->broken   = false;
+        queueInit( &w->inbox );
+        pthread_mutex_init( &w->lock, NULL );
+        pthread_cond_init( &w->wake, NULL );
+        
+        if( pthread_create( &w->thread, NULL, workerMain, w ) ) {
+            pthread_mutex_destroy( &w->lock );
+            pthread_cond_destroy( &w->wake );
+            break;
+        }
+        pool->nWorkers++;
+    }
+    
+    if( pool->nWorkers == 0 ) {
+        poolFree( pool );
+        return NULL;
+    }
+    
+    return pool;
+}
+
+void
+poolFree( Pool* pool ) {
+    atomicStore( &pool->stop, true );
+    for( uint i = 0 ; i < pool->nWorkers ; i++ ) {
+        Worker* w = &pool->workers[i];
+        pthread_mutex_lock( &w->lock );
+        pthread_cond_signal( &w->wake );
+        pthread_mutex_unlock( &w->lock );
+    }
+    for( uint i = 0 ; i < pool->nWorkers ; i++ ) {
+        Worker* w = &pool->workers[i];
+        pthread_join( w->thread, NULL );
+        pthread_mutex_destroy( &w->lock );
+        pthread_cond_destroy( &w->wake );
+    }
+    
+    // The workers finish every queued job before stopping, but
+    // the jobs themselves are freed once the submitter releases
+    // them too; which may be after this.
+    uint cap = pool->nWorkers;
+    poolDealloc( pool, pool->workers, sizeof(Worker)*cap );
+    pool->workers  = NULL;
+    pool->nWorkers = 0;
+    poolRelease( pool );
+}
+
+uint
+poolSize( Pool* pool ) {
+    return pool->nWorkers;
+}
+
+Job*
+poolSubmit( Pool* pool, Msg* req ) {
+    Job* job = poolAlloc( pool, sizeof(Job) );
+    if( !job )
+        return NULL;
+    
+    job->pool   = pool;
+    job->req    = req;
+    job->res    = NULL;
+    job->failed = false;
+    job->taken  = false;
+    job->done   = false;
+    job->refs   = 2;
+    atomicAdd( &pool->refs, 1 );
+    
+    // Workers are picked round robin, which is good enough
+    // for the independent and similarly sized jobs pools
+    // are meant for.
+    uint    i = atomicAdd( &pool->next, 1 ) % pool->nWorkers;
+    Worker* w = &pool->workers[i];
+    
+    queuePush( &w->inbox, &job->link );
+    if( atomicLoad( &w->sleeping ) ) {
+        pthread_mutex_lock( &w->lock );
+        pthread_cond_signal( &w->wake );
+        pthread_mutex_unlock( &w->lock );
+    }
+    
+    return job;
+}
+
+#else
+
+Pool*
+poolMake( ten_Config const* config, uint workers, void (*setup)( ten_State* s, void* udata ), void* udata ) {
+    return NULL;
+}
+
+void
+poolFree( Pool* pool ) {
+    tenAssertNeverReached();
+}
+
+uint
+poolSize( Pool* pool ) {
+    return 0;
+}
+
+Job*
+poolSubmit( Pool* pool, Msg* req ) {
+    tenAssertNeverReached();
+    return NULL;
+}
+
+bool
+jobDone( Job* job ) {
+    tenAssertNeverReached();
+    return false;
+}
+
+Msg*
+jobWait( Job* job, bool* failed ) {
+    tenAssertNeverReached();
+    return NULL;
+}
+
+void
+jobRelease( Job* job ) {
+    tenAssertNeverReached();
+}
+
+#endif
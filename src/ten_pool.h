@@ -0,0 +1,74 @@
+/**********************************************************************
+This component implements worker pools, which allow Ten code to make
+use of multiple cores despite each State being single threaded.  A
+pool owns a number of worker threads, each with its own isolated
+State; work is submitted to the pool as a message (see `ten_msg.h`)
+and pushed onto a worker's inbox, which is a lock-free multi-producer
+single-consumer queue.  The worker unpacks the message into its own
+State, runs the requested function, and packs the results into a
+reply message which the submitter can wait on.
+
+Since closures can't be transferred between States, the function to
+run is named either by a global variable defined in the worker States
+(usually by the pool's `setup` callback) or by the source code of an
+expression which evaluates to a closure.  Compiled expressions are
+cached per worker, so repeated submissions of the same source are
+only compiled once.
+
+Threads are implemented with POSIX threads; when compiled with the
+`ten_NO_THREADS` macro pools are unavailable and `poolMake()` always
+returns NULL.
+**********************************************************************/
+
+#ifndef ten_pool_h
+#define ten_pool_h
+#include "ten.h"
+#include "ten_types.h"
+#include "ten_msg.h"
+#include <stdbool.h>
+
+typedef struct Pool Pool;
+typedef struct Job  Job;
+
+// Create a pool with the given number of workers, each of which
+// is created with a copy of `config` and then passed to `setup`
+// (if given) for initialization.  Returns NULL if the pool can't
+// be created.  The config's allocator will be called from the
+// worker threads, so it must be thread safe.
+Pool*
+poolMake( ten_Config const* config, uint workers, void (*setup)( ten_State* s, void* udata ), void* udata );
+
+// Stop the pool's workers, waiting for any outstanding jobs to
+// finish first, and release the pool's resources.  Jobs which
+// haven't been released yet keep the pool alive until they are,
+// but no more can be submitted.
+void
+poolFree( Pool* pool );
+
+uint
+poolSize( Pool* pool );
+
+// Submit a job to the pool.  The pool takes ownership of `req`,
+// which should contain the function to run followed by its
+// arguments.  Returns NULL if the job couldn't be allocated,
+// in which case `req` is left to the caller.  The returned job
+// must be released with `jobRelease()`.
+Job*
+poolSubmit( Pool* pool, Msg* req );
+
+// Check if a job has completed without blocking.
+bool
+jobDone( Job* job );
+
+// Wait for a job to complete and take its result message, this
+// can only be done once for each job.  If the job failed then
+// `failed` is set and the message contains a single string with
+// the error message; the result may also be NULL if the job failed
+// and the worker wasn't able to allocate a message.
+Msg*
+jobWait( Job* job, bool* failed );
+
+void
+jobRelease( Job* job );
+
+#endif
@@ -35,10 +35,31 @@ recNew( State* state, Index* idx ) {
     return rec;
 }
 
+Record*
+recNewFixed( State* state, Index* idx ) {
+    tenAssert( idx->nextLoc < USHRT_MAX );
+    uint row = idx->refs.row;
+    uint cap = recCapTable[row];
+    
+    Part recP;
+    Record* rec = stateAllocObj( state, &recP, sizeof(Record) + sizeof(TVal)*cap, OBJ_REC );
+    
+    TVal* vals = (TVal*)(rec + 1);
+    for( uint i = 0 ; i < cap ; i++ )
+        vals[i] = tvUdf();
+    
+    rec->idx  = tpMake( row << 2 | REC_FIXED, idx );
+    rec->vals = tpMake( row, vals );
+    
+    stateCommitObj( state, &recP );
+    
+    return rec;
+}
+
 void
 recSep( State* state, Record* rec ) {
     Index* idx = tpGetPtr( rec->idx );
-    rec->idx = tpMake( 1, idx );
+    rec->idx = tpMake( tpGetTag( rec->idx ) | REC_SEP, idx );
 }
 
 Index*
@@ -58,9 +79,9 @@ recDef( State* state, Record* rec, TVal key, TVal val ) {
     // If the Record is marked to be separated from
     // the Index then copy a subset of the Index as
     // the Record's new Index.
-    if( tpGetTag( rec->idx ) ) {
+    if( recIsSep( rec ) ) {
         Index* sdx = idxSub( state, idx, cap );
-        rec->idx = tpMake( 0, sdx );
+        rec->idx = tpMake( tpGetTag( rec->idx ) & ~REC_SEP, sdx );
         for( uint i = 0 ; i < cap ; i++ )
             if( !tvIsUdf( vals[i] ) ) {
                 idxRemByLoc( state, idx, i );
@@ -89,7 +110,9 @@ recDef( State* state, Record* rec, TVal key, TVal val ) {
         idxAddByLoc( state, idx, i );
     
     
-    // Adjust size of value array if too small.
+    // Adjust size of value array if too small.  An inline
+    // array can't be resized, so its values are moved to
+    // a separate one instead.
     if( i >= cap ) {
         Part valsP = {.ptr = vals, .sz = sizeof(TVal)*cap };
         
@@ -97,7 +120,16 @@ recDef( State* state, Record* rec, TVal key, TVal val ) {
         uint ncap = recCapTable[nrow];
         if( ncap == UINT_MAX )
             stateErrFmtA( state, ten_ERR_RECORD, "Record exceeds max size" );
-        TVal* nvals = stateResizeRaw( state, &valsP, sizeof(TVal)*ncap );
+        
+        TVal* nvals;
+        if( vals == (TVal*)(rec + 1) ) {
+            nvals = stateAllocRaw( state, &valsP, sizeof(TVal)*ncap );
+            for( uint j = 0 ; j < cap ; j++ )
+                nvals[j] = vals[j];
+        }
+        else {
+            nvals = stateResizeRaw( state, &valsP, sizeof(TVal)*ncap );
+        }
         for( uint j = cap ; j < ncap ; j++ )
             nvals[j] = tvUdf();
         
@@ -204,5 +236,6 @@ recDestruct( State* state, Record* rec ) {
             if( !tvIsUdf( vals[i] ) )
                 idxRemByLoc( state, idx, i );
     
-    stateFreeRaw( state, vals, sizeof(TVal)*cap );
+    if( vals != (TVal*)(rec + 1) )
+        stateFreeRaw( state, vals, sizeof(TVal)*cap );
 }
@@ -20,6 +20,10 @@ struct Record {
     // the copy overhead if possible, so the first `def`
     // after the Record has been separated will result in
     // its Index being replaced with a copy of the original.
+    // Records made by `recNewFixed()` also keep the REC_FIXED
+    // flag and the row of their inline value array here, the
+    // array may later be outgrown but the Record's allocation
+    // still includes it.
     TPtr idx;
     
     // A pointer to the array of field values, tagged with
@@ -28,13 +32,20 @@ struct Record {
     TPtr vals;
 };
 
-#define recSize( STATE, REC ) (sizeof(Record))
+#define REC_SEP   (1)
+#define REC_FIXED (2)
+
+#define recSize( STATE, REC ) (sizeof(Record) + recFixedSize( REC ))
+#define recFixedSize( REC )                                             \
+    ( tpGetTag( (REC)->idx ) & REC_FIXED                                \
+        ? sizeof(TVal)*recCapTable[tpGetTag( (REC)->idx ) >> 2] : 0 )
 #define recTrav( STATE, REC ) (recTraverse( STATE, REC ))
 #define recDest( STATE, REC ) (recDestruct( STATE, REC ))
 
 #define recCap( REC )  (recCapTable[tpGetTag( (REC)->vals )])
 #define recVals( REC ) (tpGetPtr( (REC)->vals ))
 #define recIdx( REC )  (tpGetPtr( (REC)->idx ))
+#define recIsSep( REC ) (tpGetTag( (REC)->idx ) & REC_SEP)
 
 
 void
@@ -43,6 +54,13 @@ recInit( State* state );
 Record*
 recNew( State* state, Index* idx );
 
+// Same as `recNew()`, but the value array is placed in the
+// same allocation as the Record itself.  This is meant for
+// small records of a fixed shape, like list cells, which
+// are created in large numbers and rarely grow.
+Record*
+recNewFixed( State* state, Index* idx );
+
 void
 recSep( State* state, Record* rec );
 
@@ -0,0 +1,399 @@
+#include "ten_ssym.h"
+#include "ten_sync.h"
+#include "ten_assert.h"
+#include "ten_macros.h"
+#include <string.h>
+#include <limits.h>
+
+#define SSYM_SHARDS    (16)
+#define SSYM_SEGS      (26)
+#define SSYM_SEG_SHIFT (6)
+#define SSYM_MAP_CAP   (64)
+
+typedef struct SSymNode {
+    struct SSymNode* next;
+    
+    SymT   sym;
+    uint   hash;
+    ullong epoch;
+    size_t len;
+    char   buf[];
+} SSymNode;
+
+typedef struct {
+    Lock       lock;
+    uint       count;
+    uint       cap;
+    SSymNode** map;
+} Shard;
+
+struct SymTab {
+    ten_MemCb frealloc;
+    void*     udata;
+    
+    Shard shards[SSYM_SHARDS];
+    
+    // Symbol values index into a segmented array of nodes;
+    // segment `i` has `2^(i + SSYM_SEG_SHIFT)` entries, and
+    // segments are only ever added, so readers can index it
+    // without a lock.  Freed symbol values are reused.
+    SSymNode** segs[SSYM_SEGS];
+    Lock       symLock;
+    SymT       next;
+    SymT*      free;
+    uint       freeTop;
+    uint       freeCap;
+    
+    // The attached States, and the epoch counter.  `swept` is
+    // the oldest epoch still in use as of the last sweep, there's
+    // no point sweeping again until it advances.
+    Lock      userLock;
+    SymUser* users;
+    ullong    epoch;
+    ullong    swept;
+};
+
+static void*
+ssymAlloc( SymTab* tab, size_t size ) {
+    return tab->frealloc( tab->udata, NULL, 0, size );
+}
+
+static void
+ssymDealloc( SymTab* tab, void* ptr, size_t size ) {
+    tab->frealloc( tab->udata, ptr, size, 0 );
+}
+
+static uint
+hash( char const* str, size_t len ) {
+    uint h = 0;
+    for( size_t i = 0 ; i < len ; i++ )
+        h = h*37 + str[i];
+    return h;
+}
+
+// Find the segment and offset for a symbol value.
+static void
+locate( SymT sym, uint* seg, uint* off ) {
+    ullong n = ( sym >> SSYM_SEG_SHIFT ) + 1;
+    uint   s = 0;
+    while( n >>= 1 )
+        s++;
+    
+    *seg = s;
+    *off = sym - ( ( ( 1ull << s ) - 1 ) << SSYM_SEG_SHIFT );
+}
+
+static SSymNode*
+getNode( SymTab* tab, SymT sym ) {
+    uint seg, off;
+    locate( sym, &seg, &off );
+    tenAssert( seg < SSYM_SEGS );
+    
+    SSymNode** nodes = atomicLoad( &tab->segs[seg] );
+    tenAssert( nodes );
+    return atomicLoad( &nodes[off] );
+}
+
+static bool
+setNode( SymTab* tab, SymT sym, SSymNode* node ) {
+    uint seg, off;
+    locate( sym, &seg, &off );
+    if( seg >= SSYM_SEGS )
+        return false;
+    
+    SSymNode** nodes = tab->segs[seg];
+    if( !nodes ) {
+        size_t size = sizeof(SSymNode*) << ( seg + SSYM_SEG_SHIFT );
+        nodes = ssymAlloc( tab, size );
+        if( !nodes )
+            return false;
+        memset( nodes, 0, size );
+        atomicStore( &tab->segs[seg], nodes );
+    }
+    
+    atomicStore( &nodes[off], node );
+    return true;
+}
+
+// Raise the node's epoch to at least `epoch`.
+static void
+touch( SSymNode* node, ullong epoch ) {
+    ullong old = atomicLoad( &node->epoch );
+    while( old < epoch && !atomicCas( &node->epoch, &old, epoch ) )
+        ;
+}
+
+SymTab*
+ssymMake( ten_MemCb frealloc, void* udata ) {
+    SymTab* tab = frealloc( udata, NULL, 0, sizeof(SymTab) );
+    if( !tab )
+        return NULL;
+    
+    tab->frealloc = frealloc;
+    tab->udata    = udata;
+    
+    for( uint i = 0 ; i < SSYM_SHARDS ; i++ ) {
+        Shard* shard = &tab->shards[i];
+        shard->count = 0;
+        shard->cap   = SSYM_MAP_CAP;
+        shard->map   = ssymAlloc( tab, sizeof(SSymNode*)*SSYM_MAP_CAP );
+        if( !shard->map ) {
+            for( uint j = 0 ; j < i ; j++ )
+                ssymDealloc( tab, tab->shards[j].map, sizeof(SSymNode*)*SSYM_MAP_CAP );
+            ssymDealloc( tab, tab, sizeof(SymTab) );
+            return NULL;
+        }
+        for( uint j = 0 ; j < SSYM_MAP_CAP ; j++ )
+            shard->map[j] = NULL;
+        lockInit( &shard->lock );
+    }
+    
+    for( uint i = 0 ; i < SSYM_SEGS ; i++ )
+        tab->segs[i] = NULL;
+    
+    tab->next    = 0;
+    tab->free    = NULL;
+    tab->freeTop = 0;
+    tab->freeCap = 0;
+    tab->users   = NULL;
+    tab->epoch   = 1;
+    tab->swept   = 0;
+    lockInit( &tab->symLock );
+    lockInit( &tab->userLock );
+    
+    return tab;
+}
+
+void
+ssymFree( SymTab* tab ) {
+    tenAssert( tab->users == NULL );
+    
+    for( uint i = 0 ; i < SSYM_SHARDS ; i++ ) {
+        Shard* shard = &tab->shards[i];
+        for( uint j = 0 ; j < shard->cap ; j++ ) {
+            SSymNode* nIt = shard->map[j];
+            while( nIt ) {
+                SSymNode* node = nIt;
+                nIt = nIt->next;
+                ssymDealloc( tab, node, sizeof(SSymNode) + node->len + 1 );
+            }
+        }
+        ssymDealloc( tab, shard->map, sizeof(SSymNode*)*shard->cap );
+        lockFinl( &shard->lock );
+    }
+    
+    for( uint i = 0 ; i < SSYM_SEGS ; i++ ) {
+        if( tab->segs[i] )
+            ssymDealloc( tab, tab->segs[i], sizeof(SSymNode*) << ( i + SSYM_SEG_SHIFT ) );
+    }
+    if( tab->free )
+        ssymDealloc( tab, tab->free, sizeof(SymT)*tab->freeCap );
+    
+    lockFinl( &tab->symLock );
+    lockFinl( &tab->userLock );
+    ssymDealloc( tab, tab, sizeof(SymTab) );
+}
+
+void
+ssymAttach( SymTab* tab, SymUser* user ) {
+    lockAcquire( &tab->userLock );
+    user->start = 0;
+    user->done  = atomicLoad( &tab->epoch );
+    addNode( &tab->users, user );
+    lockRelease( &tab->userLock );
+}
+
+void
+ssymDetach( SymTab* tab, SymUser* user ) {
+    lockAcquire( &tab->userLock );
+    remNode( user );
+    lockRelease( &tab->userLock );
+}
+
+static bool
+growShard( SymTab* tab, Shard* shard ) {
+    uint       cap = shard->cap*2;
+    SSymNode** map = ssymAlloc( tab, sizeof(SSymNode*)*cap );
+    if( !map )
+        return false;
+    for( uint i = 0 ; i < cap ; i++ )
+        map[i] = NULL;
+    
+    for( uint i = 0 ; i < shard->cap ; i++ ) {
+        SSymNode* nIt = shard->map[i];
+        while( nIt ) {
+            SSymNode* node = nIt;
+            nIt = nIt->next;
+            
+            uint s = ( node->hash / SSYM_SHARDS ) % cap;
+            node->next = map[s];
+            map[s] = node;
+        }
+    }
+    
+    ssymDealloc( tab, shard->map, sizeof(SSymNode*)*shard->cap );
+    shard->map = map;
+    shard->cap = cap;
+    return true;
+}
+
+static bool
+newSym( SymTab* tab, SSymNode* node ) {
+    lockAcquire( &tab->symLock );
+    
+    bool ok = true;
+    if( tab->freeTop > 0 ) {
+        node->sym = tab->free[--tab->freeTop];
+    }
+    else {
+        node->sym = tab->next;
+        ok = setNode( tab, node->sym, NULL );
+        if( ok )
+            tab->next++;
+    }
+    if( ok )
+        setNode( tab, node->sym, node );
+    
+    lockRelease( &tab->symLock );
+    return ok;
+}
+
+static void
+freeSym( SymTab* tab, SymT sym ) {
+    lockAcquire( &tab->symLock );
+    
+    setNode( tab, sym, NULL );
+    
+    // If we can't grow the free list then the value is
+    // just leaked, it's not worth failing over.
+    if( tab->freeTop >= tab->freeCap ) {
+        uint  cap  = tab->freeCap ? tab->freeCap*2 : 64;
+        SymT* free = tab->frealloc( tab->udata, tab->free, sizeof(SymT)*tab->freeCap, sizeof(SymT)*cap );
+        if( free ) {
+            tab->free    = free;
+            tab->freeCap = cap;
+        }
+    }
+    if( tab->freeTop < tab->freeCap )
+        tab->free[tab->freeTop++] = sym;
+    
+    lockRelease( &tab->symLock );
+}
+
+bool
+ssymGet( SymTab* tab, char const* buf, size_t len, SymT* sym ) {
+    uint   h     = hash( buf, len );
+    Shard* shard = &tab->shards[h % SSYM_SHARDS];
+    
+    lockAcquire( &shard->lock );
+    
+    uint      s    = ( h / SSYM_SHARDS ) % shard->cap;
+    SSymNode* node = shard->map[s];
+    while( node ) {
+        if( node->hash == h && node->len == len && !memcmp( node->buf, buf, len ) )
+            break;
+        node = node->next;
+    }
+    
+    if( !node ) {
+        if( shard->count*2 >= shard->cap && growShard( tab, shard ) )
+            s = ( h / SSYM_SHARDS ) % shard->cap;
+        
+        node = ssymAlloc( tab, sizeof(SSymNode) + len + 1 );
+        if( !node ) {
+            lockRelease( &shard->lock );
+            return false;
+        }
+        node->hash  = h;
+        node->epoch = 0;
+        node->len   = len;
+        memcpy( node->buf, buf, len );
+        node->buf[len] = '\0';
+        
+        if( !newSym( tab, node ) ) {
+            ssymDealloc( tab, node, sizeof(SSymNode) + len + 1 );
+            lockRelease( &shard->lock );
+            return false;
+        }
+        
+        node->next = shard->map[s];
+        shard->map[s] = node;
+        shard->count++;
+    }
+    
+    // Interning counts as a reference in the current epoch,
+    // this has to be done while we hold the lock, otherwise
+    // the node could be swept from under us.
+    touch( node, atomicLoad( &tab->epoch ) );
+    *sym = node->sym;
+    
+    lockRelease( &shard->lock );
+    return true;
+}
+
+char const*
+ssymBuf( SymTab* tab, SymT sym ) {
+    return getNode( tab, sym )->buf;
+}
+
+size_t
+ssymLen( SymTab* tab, SymT sym ) {
+    return getNode( tab, sym )->len;
+}
+
+void
+ssymStartCycle( SymTab* tab, SymUser* user ) {
+    user->start = atomicAdd( &tab->epoch, 1 ) + 1;
+}
+
+void
+ssymMark( SymTab* tab, SymUser* user, SymT sym ) {
+    touch( getNode( tab, sym ), user->start );
+}
+
+void
+ssymFinishCycle( SymTab* tab, SymUser* user ) {
+    lockAcquire( &tab->userLock );
+    
+    user->done = user->start;
+    
+    ullong oldest = ULLONG_MAX;
+    for( SymUser* uIt = tab->users ; uIt ; uIt = uIt->next ) {
+        if( uIt->done < oldest )
+            oldest = uIt->done;
+    }
+    
+    // Only one user needs to sweep for each advance of the
+    // oldest epoch.
+    bool sweep = oldest > tab->swept;
+    if( sweep )
+        tab->swept = oldest;
+    
+    lockRelease( &tab->userLock );
+    
+    if( !sweep )
+        return;
+    
+    for( uint i = 0 ; i < SSYM_SHARDS ; i++ ) {
+        Shard* shard = &tab->shards[i];
+        lockAcquire( &shard->lock );
+        
+        for( uint j = 0 ; j < shard->cap ; j++ ) {
+            SSymNode** link = &shard->map[j];
+            while( *link ) {
+                SSymNode* node = *link;
+                if( atomicLoad( &node->epoch ) >= oldest ) {
+                    link = &node->next;
+                    continue;
+                }
+                
+                *link = node->next;
+                shard->count--;
+                freeSym( tab, node->sym );
+                ssymDealloc( tab, node, sizeof(SSymNode) + node->len + 1 );
+            }
+        }
+        
+        lockRelease( &shard->lock );
+    }
+}
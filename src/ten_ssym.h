@@ -0,0 +1,72 @@
+/**********************************************************************
+This component implements the shared symbol table, which can be used
+in place of the per-State symbol table for long symbols (short ones
+are always encoded directly in the symbol value).  States attached to
+the same table intern each symbol once, and get the same `SymT` for
+the same content; so symbols can be compared between them.
+
+The table can be used from multiple threads concurrently.  Symbols are
+stored in a segmented array which never moves, so getting a symbol's
+content is lock free; interning takes the lock of one of several shards,
+selected by the symbol's hash.
+
+Since each State only knows about its own references, symbols are
+collected with epochs.  Each full GC cycle of an attached State starts
+a new epoch, and every symbol marked or interned during the cycle is
+tagged with the epoch number.  Once every attached State has finished
+a cycle starting after a symbol's last epoch, the symbol isn't used by
+any of them and can be freed.
+**********************************************************************/
+
+#ifndef ten_ssym_h
+#define ten_ssym_h
+#include "ten.h"
+#include "ten_types.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct SymTab  SymTab;
+typedef struct SymUser SymUser;
+
+// Each attached State keeps one of these, to tell the table
+// which epochs it's finished.
+struct SymUser {
+    SymUser*  next;
+    SymUser** link;
+    ullong    start;
+    ullong    done;
+};
+
+SymTab*
+ssymMake( ten_MemCb frealloc, void* udata );
+
+void
+ssymFree( SymTab* tab );
+
+void
+ssymAttach( SymTab* tab, SymUser* user );
+
+void
+ssymDetach( SymTab* tab, SymUser* user );
+
+// Intern a symbol, returning false if memory couldn't be
+// allocated for it.
+bool
+ssymGet( SymTab* tab, char const* buf, size_t len, SymT* sym );
+
+char const*
+ssymBuf( SymTab* tab, SymT sym );
+
+size_t
+ssymLen( SymTab* tab, SymT sym );
+
+void
+ssymStartCycle( SymTab* tab, SymUser* user );
+
+void
+ssymMark( SymTab* tab, SymUser* user, SymT sym );
+
+void
+ssymFinishCycle( SymTab* tab, SymUser* user );
+
+#endif
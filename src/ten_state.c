@@ -35,7 +35,7 @@ static void
 freeRaw( State* state, void* old, size_t osz );
 
 static void
-collect( State* state, size_t extra );
+collect( State* state, size_t extra, bool full );
 
 static void
 onError( State* state );
@@ -84,6 +84,7 @@ stateInit( State* state, ten_Config const* config, jmp_buf* errJmp ) {
     state->errVal   = tvUdf();
     state->errJmp   = errJmp;
     state->memLimit = MEM_LIMIT_INIT;
+    state->memMax   = config->memMax;
     
     state->errOutOfMem = tvUdf();
     
@@ -531,7 +532,7 @@ stateMark( State* state, void* ptr ) {
 
 void
 stateCollect( State* state ) {
-    collect( state, 0 );
+    collect( state, 0, false );
 }
 
 static void*
@@ -545,11 +546,25 @@ reallocRaw( State* state, void* old, size_t osz, size_t nsz ) {
     
     size_t need = state->memUsed + nsz;
     if( need > state->memLimit )
-        collect( state, nsz );
+        collect( state, nsz, false );
+    
+    // If the allocation would put us over the hard cap then
+    // do a full collection to free up as much as possible
+    // before giving up.  Unlike the allocator failing this
+    // isn't fatal, since the State is still in good shape
+    // and the script can recover by dropping references.
+    if( state->memMax > 0 && nsz > osz ) {
+        tenAssert( state->memUsed >= osz );
+        if( state->memUsed - osz + nsz > state->memMax ) {
+            collect( state, nsz, true );
+            if( state->memUsed - osz + nsz > state->memMax )
+                stateErrVal( state, ten_ERR_SYSTEM, state->errOutOfMem );
+        }
+    }
     
     void* mem = state->config.frealloc( state->config.udata, old, osz, nsz );
     if( nsz > 0 && !mem ) {
-        collect( state, nsz );
+        collect( state, nsz, true );
         mem = state->config.frealloc( state->config.udata, old, osz, nsz );
         if( !mem )
             stateErrVal( state, ten_ERR_FATAL, state->errOutOfMem );
@@ -557,6 +572,8 @@ reallocRaw( State* state, void* old, size_t osz, size_t nsz ) {
     
     state->memUsed += nsz;
     state->memUsed -= osz;
+    if( state->memUsed > state->memPeak )
+        state->memPeak = state->memUsed;
     
     return mem;
 }
@@ -626,14 +643,15 @@ traverseStack( State* state ) {
 }
 
 static void
-collect( State* state, size_t extra ) {
+collect( State* state, size_t extra, bool full ) {
     CHECK_STATE;
     
     // Every 5th cycle we do a full traversal to
     // scan for Pointers and Symbols as well as
-    // normal objects.
+    // normal objects.  A full cycle can also be
+    // requested when memory is tight.
     state->gcProg = true;
-    if( state->gcCount++ % 5 == 0 ) {
+    if( state->gcCount++ % 5 == 0 || full ) {
         state->gcFull = true;
         symStartCycle( state );
         ptrStartCycle( state );
@@ -716,12 +734,20 @@ onError( State* state ) {
     CHECK_STATE;
     tenAssert( state->gcProg == false );
     
+    // The memory cap is lifted while the deferred handlers
+    // run, since they may need to allocate to record the
+    // error; otherwise running out of memory would just
+    // raise another error.
+    size_t memMax = state->memMax;
+    state->memMax = 0;
+    
     Defer* dIt = state->defers;
     while( dIt ) {
         dIt->cb( state, dIt );
         dIt = dIt->next;
     }
     
+    state->memMax = memMax;
     state->defers = NULL;
     freeParts( state );
     
@@ -854,7 +880,7 @@ freeParts( State* state ) {
         #ifdef ten_DEBUG
             checkObjPart( state, pIt, __FILE__, __LINE__ );
         #endif
-        stateFreeRaw( state, pIt->ptr, sizeof(Object) + pIt->sz );
+        stateFreeRaw( state, datGetObj( pIt->ptr ), sizeof(Object) + pIt->sz );
         pIt = pIt->next;
     }
     state->objParts = NULL;
@@ -232,9 +232,13 @@ struct State {
     
     // Current number of bytes allocated on the heap, and
     // the number that needs to be reached to trigger the
-    // next GC.
+    // next GC.  The `memMax` is a hard cap on `memUsed`,
+    // or zero for no cap; and `memPeak` is the highest
+    // `memUsed` has been.
     size_t memUsed;
     size_t memLimit;
+    size_t memMax;
+    size_t memPeak;
     #define MEM_LIMIT_INIT   (2048)
     #define DEFAULT_MEM_GROWTH (1.5)
     
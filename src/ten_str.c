@@ -1,32 +1,88 @@
 #include "ten_str.h"
 #include "ten_state.h"
 #include "ten_assert.h"
+#include "ten_utf.h"
 #include <string.h>
+#include <stdint.h>
+
+// Substrings shorter than this are always copied, since the
+// copy costs about as much as a slice would.
+#define SLICE_MIN (32)
+
+// Longer substrings are sliced if they cover at least 1/SLICE_SHARE
+// of their parent, or if at least that much of the parent has been
+// taken as substrings already.
+#define SLICE_SHARE (4)
 
 void
 strInit( State* state ) {
     state->strState = NULL;
 }
 
+static String*
+allocStr( State* state, Part* p, size_t len ) {
+    String* str = stateAllocObj( state, p, sizeof(String)+len+1, OBJ_STR );
+    str->len      = len;
+    str->buf      = str->data;
+    str->u.sliced = 0;
+    str->hash     = 0;
+    str->enc      = STR_UNCHECKED;
+    str->ext      = false;
+    str->buf[len] = '\0';
+    return str;
+}
+
 String*
 strNew( State* state, char const* src, size_t len ) {
     Part strP;
-    String* str = stateAllocObj( state, &strP, sizeof(String)+len+1, OBJ_STR );
-    str->len = len;
+    String* str = allocStr( state, &strP, len );
     memcpy( str->buf, src, len );
-    str->buf[str->len] = '\0';
     
     stateCommitObj( state, &strP );
     return str;
 }
 
+String*
+strAlloc( State* state, size_t len ) {
+    Part strP;
+    String* str = allocStr( state, &strP, len );
+    
+    stateCommitObj( state, &strP );
+    return str;
+}
+
+String*
+strNewExt( State* state, char const* buf, size_t len, ten_StrDestr destr, void* udata ) {
+    Part strP;
+    String* str = stateAllocObj( state, &strP, sizeof(String) + sizeof(StrExt), OBJ_STR );
+    str->len      = len;
+    str->buf      = (char*)buf;
+    str->u.sliced = 0;
+    str->hash     = 0;
+    str->enc      = STR_UNCHECKED;
+    str->ext      = true;
+    
+    StrExt* ext = strExt( str );
+    ext->destr = destr;
+    ext->udata = udata;
+    ext->term  = NULL;
+    
+    stateCommitObj( state, &strP );
+    return str;
+}
+
+void
+strDestruct( State* state, String* str ) {
+    StrExt* ext = strExt( str );
+    if( ext->destr )
+        ext->destr( str->buf, str->len, ext->udata );
+}
+
 String*
 strCpy( State* state, String* str ) {
     Part cpyP;
-    String* cpy = stateAllocObj( state, &cpyP, sizeof(String)+str->len+1, OBJ_STR );
-    cpy->len = str->len;
+    String* cpy = allocStr( state, &cpyP, str->len );
     memcpy( cpy->buf, str->buf, str->len );
-    cpy->buf[cpy->len] = '\0';
     
     stateCommitObj( state, &cpyP );
     return cpy;
@@ -37,12 +93,11 @@ strCat( State* state, String* str1, String* str2 ) {
     size_t  len = str1->len + str2->len;
     
     Part catP;
-    String* cat = stateAllocObj( state, &catP, sizeof(String)+len+1, OBJ_STR );
-    
-    cat->len = len;
+    String* cat = allocStr( state, &catP, len );
     memcpy( cat->buf, str1->buf, str1->len );
     memcpy( cat->buf + str1->len, str2->buf, str2->len );
-    cat->buf[cat->len] = '\0';
+    if( str1->enc == STR_ASCII && str2->enc == STR_ASCII )
+        cat->enc = STR_ASCII;
     
     stateCommitObj( state, &catP );
     return cat;
@@ -69,21 +124,110 @@ strSub( State* state, String* str, llong loc, llong len ) {
     if( loc < 0 || loc >= str->len || end < 0 || end > str->len )
         stateErrFmtA( state, ten_ERR_STRING, "Out of range" );
     
-    Part subP;
-    String* sub = stateAllocObj( state, &subP, sizeof(String)+len+1, OBJ_STR );
-    sub->len = len;
-    memcpy( sub->buf, str->buf + loc, len );
+    return strSlice( state, str, loc, len );
+}
+
+String*
+strSlice( State* state, String* str, size_t loc, size_t len ) {
+    tenAssert( loc + len <= str->len );
+    
+    String* parent = strIsSlice( str ) ? str->u.parent : str;
+    parent->u.sliced += len;
+    
+    bool slice =
+        len >= SLICE_MIN &&
+        ( len*SLICE_SHARE >= parent->len ||
+          parent->u.sliced*SLICE_SHARE >= parent->len );
+    
+    String* sub;
+    if( slice ) {
+        Part subP;
+        sub = stateAllocObj( state, &subP, sizeof(String) + sizeof(String*), OBJ_STR );
+        sub->len      = len;
+        sub->buf      = str->buf + loc;
+        sub->u.parent = parent;
+        sub->hash     = 0;
+        sub->enc      = STR_UNCHECKED;
+        sub->ext      = false;
+        strTerm( sub ) = NULL;
+        stateCommitObj( state, &subP );
+    }
+    else {
+        sub = strNew( state, str->buf + loc, len );
+    }
+    
+    // Any part of an ASCII string is ASCII too.
+    if( str->enc == STR_ASCII )
+        sub->enc = STR_ASCII;
     
-    stateCommitObj( state, &subP );
     return sub;
 }
 
 char const*
 strBuf( State* state, String* str ) {
-    return str->buf;
+    if( str->ext ) {
+        StrExt* ext = strExt( str );
+        if( !ext->term )
+            ext->term = strNew( state, str->buf, str->len );
+        return ext->term->buf;
+    }
+    
+    // Slices of external Strings can't look past their end,
+    // it may be past the end of the host's buffer.
+    if( !strIsSlice( str ) )
+        return str->buf;
+    if( !str->u.parent->ext && str->buf[str->len] == '\0' )
+        return str->buf;
+    
+    // Keep a terminated copy of the bytes with the slice, the
+    // slice still references its parent so pointers into the
+    // parent's buffer stay valid.
+    if( !strTerm( str ) )
+        strTerm( str ) = strNew( state, str->buf, str->len );
+    return strTerm( str )->buf;
 }
 
 size_t
 strLen( State* state, String* str ) {
     return str->len;
 }
+
+uint
+strHashSlow( State* state, String* str ) {
+    // FNV-1a, with 0 reserved to mean 'not yet computed'.
+    uint32_t h = 2166136261u;
+    for( size_t i = 0 ; i < str->len ; i++ ) {
+        h ^= (unsigned char)str->buf[i];
+        h *= 16777619u;
+    }
+    if( h == 0 )
+        h = 1;
+    
+    str->hash = h;
+    return h;
+}
+
+StrEnc
+strEncSlow( State* state, String* str ) {
+    size_t ascii = utfAscii( str->buf, str->len );
+    if( ascii == str->len )
+        str->enc = STR_ASCII;
+    else
+    if( utfCheck( str->buf + ascii, str->len - ascii ) )
+        str->enc = STR_UTF8;
+    else
+        str->enc = STR_BINARY;
+    
+    return str->enc;
+}
+
+bool
+strEqual( State* state, String* str1, String* str2 ) {
+    if( str1 == str2 )
+        return true;
+    if( str1->len != str2->len )
+        return false;
+    if( str1->hash && str2->hash && str1->hash != str2->hash )
+        return false;
+    return !memcmp( str1->buf, str2->buf, str1->len );
+}
@@ -2,21 +2,89 @@
 This component implements Ten's String data type, and immutable
 sequence of bytes.  String instances aren't sensitive to any
 particular encoding; any byte sequence is allowed.
+
+Substrings can be made as slices, which reference a range of their
+parent's buffer instead of copying it, and keep the parent alive.
+To keep a small slice from pinning a much larger parent, substrings
+are only sliced if they're a good part of the parent, or the parent
+has already had a good part of its bytes taken as substrings, as when
+tokenizing it; otherwise they're copied.  A slice's buffer isn't NUL
+terminated unless it happens to end where its parent's does, so
+`strBuf()`, which promises a terminated buffer, gives a terminated
+copy of a slice's bytes when needed; made on first use and kept with
+the slice.  The slice itself keeps pointing into its parent, so code
+that only looks at `len` bytes can use `buf` directly.
+
+External Strings reference bytes owned by the host instead of their
+own, along with a callback to release them once the String is
+collected.  They can be sliced like any other String, but since the
+host's buffer isn't necessarily terminated `strBuf()` gives a
+terminated copy, made on first use and kept with the String.
 ***********************************************************************/
 
 #ifndef ten_str_h
 #define ten_str_h
+#include "ten.h"
 #include "ten_types.h"
 #include <stddef.h>
+#include <stdbool.h>
 
 struct String {
     size_t len;
-    char   buf[];
+    char*  buf;
+    
+    // Strings that own their bytes keep them in `data`, and
+    // count the bytes taken from them as substrings in `sliced`.
+    // Slices keep the String that owns their bytes in `parent`.
+    union {
+        size_t  sliced;
+        String* parent;
+    } u;
+    
+    // Hash of the String's contents, used when it's a record
+    // key; computed on first use, 0 until then.
+    uint hash;
+    
+    // Encoding of the String's contents, one of `StrEnc`;
+    // found on first use, STR_UNCHECKED until then.
+    uchar enc;
+    
+    // Set for external Strings, which keep a `StrExt` right
+    // after the String instead of their bytes; not in `data`,
+    // which isn't aligned for it.
+    bool  ext;
+    char  data[];
 };
 
-#define strSize( STATE, STR ) (sizeof(String) + (STR)->len + 1)
-#define strTrav( STATE, STR ) 
-#define strDest( STATE, STR ) 
+typedef struct {
+    ten_StrDestr destr;
+    void*        udata;
+    String*      term;
+} StrExt;
+
+typedef enum {
+    STR_UNCHECKED,
+    STR_ASCII,
+    STR_UTF8,
+    STR_BINARY
+} StrEnc;
+
+#define strIsSlice( STR ) ((STR)->buf != (STR)->data && !(STR)->ext)
+#define strExt( STR )     ((StrExt*)((STR) + 1))
+
+// Slices keep the terminated copy of their bytes given by
+// `strBuf()` right after the String, NULL until it's made.
+#define strTerm( STR )    (*(String**)((STR) + 1))
+
+#define strSize( STATE, STR ) \
+    (sizeof(String) + ((STR)->ext ? sizeof(StrExt) : strIsSlice( STR ) ? sizeof(String*) : (STR)->len + 1))
+#define strTrav( STATE, STR ) \
+    (strIsSlice( STR ) ? \
+        ( stateMark( STATE, (STR)->u.parent ), \
+          strTerm( STR ) ? stateMark( STATE, strTerm( STR ) ) : (void)0 ) : \
+     (STR)->ext && strExt( STR )->term ? stateMark( STATE, strExt( STR )->term ) : (void)0)
+#define strDest( STATE, STR ) \
+    ((STR)->ext ? strDestruct( STATE, STR ) : (void)0)
 
 void
 strInit( State* state );
@@ -24,6 +92,20 @@ strInit( State* state );
 String*
 strNew( State* state, char const* src, size_t len );
 
+// Allocate a String of the given length without initializing
+// its contents, the caller should fill in the buffer before
+// the String is exposed to Ten code.
+String*
+strAlloc( State* state, size_t len );
+
+// Make an external String referencing the host's `buf`, which
+// is released with `destr` when the String is collected.
+String*
+strNewExt( State* state, char const* buf, size_t len, ten_StrDestr destr, void* udata );
+
+void
+strDestruct( State* state, String* str );
+
 String*
 strCpy( State* state, String* str );
 
@@ -33,9 +115,33 @@ strCat( State* state, String* str1, String* str2 );
 String*
 strSub( State* state, String* str, llong loc, llong len );
 
+// Make a String of the `len` bytes at `loc` in `str`, which
+// must be in range.  This is a slice of `str`, or of the
+// String `str` is a slice of, unless a copy is preferable.
+String*
+strSlice( State* state, String* str, size_t loc, size_t len );
+
 char const*
 strBuf( State* state, String* str );
 
+// Hash and compare Strings by their contents.
+#define strHash( STATE, STR ) \
+    ((STR)->hash ? (STR)->hash : strHashSlow( STATE, STR ))
+
+uint
+strHashSlow( State* state, String* str );
+
+bool
+strEqual( State* state, String* str1, String* str2 );
+
+// Find whether the String is all ASCII, otherwise well formed
+// UTF-8, or neither.
+#define strEnc( STATE, STR ) \
+    ((STR)->enc ? (StrEnc)(STR)->enc : strEncSlow( STATE, STR ))
+
+StrEnc
+strEncSlow( State* state, String* str );
+
 size_t
 strLen( State* state, String* str );
 
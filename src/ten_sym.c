@@ -1,49 +1,88 @@
 #include "ten_sym.h"
 #include "ten_state.h"
 #include "ten_assert.h"
-#include "ten_tables.h"
 #include "ten_macros.h"
+#include "ten_ssym.h"
 #include <string.h>
 #include <limits.h>
 
 #define SYM_SHORT_LIM (4)
 #define SYM_META_BYTE (5)
 
+// Long symbols are packed into chunks of this many bytes, except
+// for those bigger than a quarter chunk which get their own.
+#define SYM_CHUNK_SIZE (4096)
+
+// Initial capacity of the slot map, always a power of two.
+#define SYM_MAP_CAP (64)
+
+#define SYM_NONE UINT_MAX
+
 typedef union {
     SymT s;
     char b[6];
 } SymBuf;
 
-typedef struct SymNode {
-    struct SymNode*  next;
-    struct SymNode** link;
-    
-    uint   hash;
-    bool   mark;
-    uint   loc;
-    size_t len;
-    char*  buf;
-} SymNode;
+// Symbol contents are kept in a chain of arena chunks, which are
+// never moved or resized so `symBuf()` pointers stay valid for as
+// long as the symbol is alive.  A chunk is released once all the
+// symbols in it have been collected.
+typedef struct SymChunk {
+    struct SymChunk*  next;
+    struct SymChunk** link;
+    
+    size_t cap;
+    size_t top;
+    uint   live;
+    char   buf[];
+} SymChunk;
+
+// Each long symbol's value is the index of its entry, entries of
+// collected symbols are kept in a free list, linked by `next`, to
+// be reused.
+typedef struct {
+    char*     buf;
+    SymChunk* chunk;
+    size_t    len;
+    union {
+        uint hash;
+        uint next;
+    } u;
+    bool mark;
+} SymEntry;
+
+// The map is an open addressing table with linear probing; each
+// slot keeps the entry's hash alongside its index so most probes
+// don't have to touch the entry itself.
+typedef struct {
+    uint hash;
+    uint sym;
+} SymSlot;
 
 struct SymState {
     Finalizer finl;
     
     uint count;
-    uint next;
     
     struct {
-        uint      row;
-        uint      cap;
-        SymNode** buf;
+        uint     cap;
+        SymSlot* buf;
     } map;
     
     struct {
+        uint      top;
         uint      cap;
-        SymNode** buf;
-    } nodes;
+        SymEntry* buf;
+        uint      free;
+    } entries;
     
-    SymNode* recycled;
-    char     symBuf[5];
+    SymChunk* chunks;
+    char      symBuf[5];
+    
+    // If the State is attached to a shared symbol table
+    // then long symbols are interned there instead.
+    SymTab* shared;
+    SymUser user;
 };
 
 static uint
@@ -52,34 +91,31 @@ hash( char const* str, size_t len );
 static void
 growMap( State* state );
 
+static void
+freeChunk( State* state, SymChunk* chunk ) {
+    remNode( chunk );
+    stateFreeRaw( state, chunk, sizeof(SymChunk) + chunk->cap );
+}
+
 static void
 symFinl( State* state, Finalizer* finl ) {
     SymState* symState = (SymState*)finl;
     
-    for( uint i = 0 ; i < symState->next ; i++ ) {
-        SymNode* n = symState->nodes.buf[i];
-        if( !n )
-            continue;
-        stateFreeRaw( state, n->buf, n->len + 1 );
-        stateFreeRaw( state, n, sizeof(SymNode) );
-    }
+    if( symState->shared )
+        ssymDetach( symState->shared, &symState->user );
     
-    SymNode* nIt = symState->recycled;
-    while( nIt ) {
-        SymNode* n = nIt;
-        nIt = nIt->next;
-        stateFreeRaw( state, n, sizeof(SymNode) );
-    }
+    while( symState->chunks )
+        freeChunk( state, symState->chunks );
     
     stateFreeRaw(
         state,
         symState->map.buf,
-        sizeof(SymNode*)*symState->map.cap
+        sizeof(SymSlot)*symState->map.cap
     );
     stateFreeRaw(
         state,
-        symState->nodes.buf,
-        sizeof(SymNode*)*symState->nodes.cap
+        symState->entries.buf,
+        sizeof(SymEntry)*symState->entries.cap
     );
     stateFreeRaw( state, symState, sizeof(SymState) );
     state->symState = NULL;
@@ -87,46 +123,105 @@ symFinl( State* state, Finalizer* finl ) {
 
 void
 symInit( State* state ) {
-    uint mcap = slowGrowthMapCapTable[0];
+    uint mcap = SYM_MAP_CAP;
     
     Part stateP;
     SymState* symState = stateAllocRaw( state, &stateP, sizeof(SymState) );
     
     Part mapP;
-    SymNode** map = stateAllocRaw( state, &mapP, sizeof(SymNode*)*mcap );
+    SymSlot* map = stateAllocRaw( state, &mapP, sizeof(SymSlot)*mcap );
     for( uint i = 0 ; i < mcap ; i++ )
-        map[i] = NULL;
-    
-    uint ncap = 7;
-    Part nodesP;
-    SymNode** nodes = stateAllocRaw( state, &nodesP, sizeof(SymNode*)*ncap );
-    for( uint i = 0 ; i < ncap ; i++ )
-        nodes[i] = NULL;
-    
-    symState->count     = 0;
-    symState->next      = 0;
-    symState->map.row   = 0;
-    symState->map.cap   = mcap;
-    symState->map.buf   = map;
-    symState->nodes.cap = ncap;
-    symState->nodes.buf = nodes;
-    symState->recycled  = NULL;
-    symState->finl.cb   = symFinl;
+        map[i].sym = SYM_NONE;
+    
+    uint ecap = 8;
+    Part entriesP;
+    SymEntry* entries = stateAllocRaw( state, &entriesP, sizeof(SymEntry)*ecap );
+    
+    symState->count        = 0;
+    symState->map.cap      = mcap;
+    symState->map.buf      = map;
+    symState->entries.top  = 0;
+    symState->entries.cap  = ecap;
+    symState->entries.buf  = entries;
+    symState->entries.free = SYM_NONE;
+    symState->chunks       = NULL;
+    symState->shared       = (SymTab*)state->config.symtab;
+    symState->finl.cb      = symFinl;
     stateInstallFinalizer( state, &symState->finl );
     stateCommitRaw( state, &stateP );
     stateCommitRaw( state, &mapP );
-    stateCommitRaw( state, &nodesP );
+    stateCommitRaw( state, &entriesP );
+    
+    if( symState->shared )
+        ssymAttach( symState->shared, &symState->user );
     
     state->symState = symState;
 }
 
+// Find space for `len` bytes in the arena, the first chunk is
+// the one being filled, so big symbols' chunks go after it.
+static char*
+arenaAlloc( State* state, size_t len, SymChunk** chunk ) {
+    SymState* symState = state->symState;
+    
+    SymChunk* head = symState->chunks;
+    if( head && head->cap - head->top >= len ) {
+        char* buf = head->buf + head->top;
+        head->top += len;
+        head->live++;
+        *chunk = head;
+        return buf;
+    }
+    
+    bool   big = len > SYM_CHUNK_SIZE/4;
+    size_t cap = big ? len : SYM_CHUNK_SIZE;
+    
+    Part chunkP;
+    SymChunk* c = stateAllocRaw( state, &chunkP, sizeof(SymChunk) + cap );
+    c->cap  = cap;
+    c->top  = len;
+    c->live = 1;
+    if( big && head )
+        addNode( &head->next, c );
+    else
+        addNode( &symState->chunks, c );
+    stateCommitRaw( state, &chunkP );
+    
+    *chunk = c;
+    return c->buf;
+}
+
+static uint
+newEntry( State* state ) {
+    SymState* symState = state->symState;
+    
+    if( symState->entries.free != SYM_NONE ) {
+        uint sym = symState->entries.free;
+        symState->entries.free = symState->entries.buf[sym].u.next;
+        return sym;
+    }
+    
+    tenAssert( symState->entries.top < SYM_NONE );
+    if( symState->entries.top >= symState->entries.cap ) {
+        Part entriesP = {
+            .ptr = symState->entries.buf,
+            .sz  = symState->entries.cap*sizeof(SymEntry)
+        };
+        
+        uint      cap     = symState->entries.cap*2;
+        SymEntry* entries = stateResizeRaw( state, &entriesP, sizeof(SymEntry)*cap );
+        
+        symState->entries.cap = cap;
+        symState->entries.buf = entries;
+        stateCommitRaw( state, &entriesP );
+    }
+    return symState->entries.top++;
+}
+
 SymT
 symGet( State* state, char const* buf, size_t len ) {
     SymState* symState = state->symState;
     
-    if( symState->count*3 >= symState->map.cap )
-        growMap( state );
-    
     // Encode short symbols directly in the int value.
     if( len <= SYM_SHORT_LIM ) {
         SymBuf u;
@@ -143,64 +238,55 @@ symGet( State* state, char const* buf, size_t len ) {
         return u.s;
     }
     
-    // Look for an existing node with the same content.
-    uint h = hash( buf, len );
-    uint s = h % symState->map.cap;
-    SymNode* node = symState->map.buf[s];
-    while( node ) {
-        if( node->len == len && !memcmp( node->buf, buf, len ) )
-            return node->loc;
-        node = node->next;
+    if( symState->shared ) {
+        SymT sym;
+        if( !ssymGet( symState->shared, buf, len, &sym ) )
+            stateErrVal( state, ten_ERR_FATAL, state->errOutOfMem );
+        return sym;
     }
     
-    // If the symbol doesn't exist then either create or
-    // recycle a node to put it in.
-    if( symState->recycled ) {
-        node = symState->recycled;
-        remNode( node );
-    }
-    else {
-        Part nodeP;
-        node = stateAllocRaw( state, &nodeP, sizeof(SymNode) );
-        node->len = 0;
-        node->buf = NULL;
-        
-        tenAssert( symState->next < UINT_MAX );
-        node->loc = symState->next++;
-        if( symState->next >= symState->nodes.cap ) {
-            Part nodesP = {
-                .ptr = symState->nodes.buf,
-                .sz  = symState->nodes.cap*sizeof(SymNode*)
-            };
-            
-            uint      cap   = symState->nodes.cap*2;
-            SymNode** nodes = stateResizeRaw( state, &nodesP, sizeof(SymNode*)*cap );
-            for( uint i = symState->nodes.cap ; i < cap ; i++ )
-                nodes[i] = NULL;
-            
-            symState->nodes.cap = cap;
-            symState->nodes.buf = nodes;
-            stateCommitRaw( state, &nodesP );
+    if( (symState->count + 1)*3 >= symState->map.cap*2 )
+        growMap( state );
+    
+    // Look for an existing entry with the same content.
+    uint     h    = hash( buf, len );
+    uint     mask = symState->map.cap - 1;
+    SymSlot* map  = symState->map.buf;
+    uint     s    = h & mask;
+    while( map[s].sym != SYM_NONE ) {
+        if( map[s].hash == h ) {
+            SymEntry* e = &symState->entries.buf[map[s].sym];
+            if( e->len == len && !memcmp( e->buf, buf, len ) )
+                return map[s].sym;
         }
-        stateCommitRaw( state, &nodeP );
+        s = (s + 1) & mask;
     }
     
-    addNode( &symState->map.buf[s], node );
-    
-    Part conP;
-    char* con = stateAllocRaw( state, &conP, len+1 );
+    // If the symbol doesn't exist then copy its contents into
+    // the arena and give it an entry.
+    SymChunk* chunk;
+    char*     con = arenaAlloc( state, len + 1, &chunk );
     memcpy( con, buf, len );
     con[len] = '\0';
-    stateCommitRaw( state, &conP );
     
-    node->len  = len;
-    node->buf  = con;
-    node->mark = false;
-    node->hash = h;
-    symState->nodes.buf[node->loc] = node;
+    uint      sym = newEntry( state );
+    SymEntry* e   = &symState->entries.buf[sym];
+    e->buf    = con;
+    e->chunk  = chunk;
+    e->len    = len;
+    e->u.hash = h;
+    e->mark   = false;
+    
+    // The allocations may have triggered a GC cycle, which can
+    // shift slots around, so find the free slot again.
+    s = h & mask;
+    while( map[s].sym != SYM_NONE )
+        s = (s + 1) & mask;
+    map[s].hash = h;
+    map[s].sym  = sym;
     symState->count++;
     
-    return node->loc;
+    return sym;
 }
 
 char const*
@@ -218,9 +304,12 @@ symBuf( State* state, SymT sym ) {
         return symState->symBuf;
     }
     
-    // Otherwise return the node buffer.
-    tenAssert( sym < symState->next );
-    return symState->nodes.buf[sym]->buf;
+    // Otherwise return the entry's buffer.
+    if( symState->shared )
+        return ssymBuf( symState->shared, sym );
+    
+    tenAssert( sym < symState->entries.top );
+    return symState->entries.buf[sym].buf;
 }
 
 size_t
@@ -237,14 +326,19 @@ symLen( State* state, SymT sym ) {
         return len;
     }
     
-    // Otherwise return the length from the respective node.
-    tenAssert( sym < symState->next );
-    return symState->nodes.buf[sym]->len;
+    // Otherwise return the length from the respective entry.
+    if( symState->shared )
+        return ssymLen( symState->shared, sym );
+    
+    tenAssert( sym < symState->entries.top );
+    return symState->entries.buf[sym].len;
 }
 
 void
 symStartCycle( State* state ) {
-    // NADA
+    SymState* symState = state->symState;
+    if( symState->shared )
+        ssymStartCycle( symState->shared, &symState->user );
 }
 
 void
@@ -255,32 +349,81 @@ symMark( State* state, SymT sym ) {
     if( u.b[SYM_META_BYTE] )
         return;
     
-    tenAssert( sym < symState->next );
-    SymNode* node = symState->nodes.buf[sym];
-    node->mark = true;
+    if( symState->shared ) {
+        ssymMark( symState->shared, &symState->user, sym );
+        return;
+    }
+    
+    tenAssert( sym < symState->entries.top );
+    symState->entries.buf[sym].mark = true;
+}
+
+// Remove the entry's slot from the map, shifting any slots
+// after it in the probe sequence back to fill the gap so the
+// map never needs tombstones.
+static void
+remSlot( SymState* symState, uint sym, uint h ) {
+    uint     mask = symState->map.cap - 1;
+    SymSlot* map  = symState->map.buf;
+    
+    uint i = h & mask;
+    while( map[i].sym != sym )
+        i = (i + 1) & mask;
+    
+    uint j = i;
+    for( ;; ) {
+        j = (j + 1) & mask;
+        if( map[j].sym == SYM_NONE )
+            break;
+        
+        // The slot at `j` can only move back to `i` if its home
+        // slot isn't cyclically in (i, j].
+        uint k = map[j].hash & mask;
+        if( i <= j ? ( i < k && k <= j ) : ( i < k || k <= j ) )
+            continue;
+        
+        map[i] = map[j];
+        i = j;
+    }
+    map[i].sym = SYM_NONE;
 }
 
 void
 symFinishCycle( State* state ) {
     SymState* symState = state->symState;
     
-    for( uint i = 0 ; i < symState->next ; i++ ) {
-        SymNode* node = symState->nodes.buf[i];
-        if( !node || !node->buf )
+    if( symState->shared ) {
+        ssymFinishCycle( symState->shared, &symState->user );
+        return;
+    }
+    
+    for( uint i = 0 ; i < symState->entries.top ; i++ ) {
+        SymEntry* e = &symState->entries.buf[i];
+        if( !e->buf )
             continue;
-        if( node->mark ) {
-            node->mark = false;
+        if( e->mark ) {
+            e->mark = false;
             continue;
         }
         
-        remNode( node );
-        symState->nodes.buf[i] = NULL;
+        remSlot( symState, i, e->u.hash );
         
-        stateFreeRaw( state, node->buf, node->len + 1 );
-        node->len = 0;
-        node->buf = NULL;
+        // Release the chunk once it's empty; unless it's the
+        // one being filled, which is just reset.
+        SymChunk* chunk = e->chunk;
+        tenAssert( chunk->live > 0 );
+        if( --chunk->live == 0 ) {
+            if( chunk == symState->chunks )
+                chunk->top = 0;
+            else
+                freeChunk( state, chunk );
+        }
         
-        addNode( &symState->recycled, node );
+        e->buf    = NULL;
+        e->chunk  = NULL;
+        e->len    = 0;
+        e->u.next = symState->entries.free;
+        symState->entries.free = i;
         
         tenAssert( symState->count > 0 );
         symState->count--;
@@ -289,9 +432,13 @@ symFinishCycle( State* state ) {
 
 static uint
 hash( char const* str, size_t len ) {
-    uint h = 0;
-    for( size_t i = 0 ; i < len ; i++ )
-        h = h*37 + str[i];
+    // FNV-1a, the map is indexed by the low bits so the
+    // hash needs to mix well.
+    uint h = 2166136261u;
+    for( size_t i = 0 ; i < len ; i++ ) {
+        h ^= (unsigned char)str[i];
+        h *= 16777619u;
+    }
     return h;
 }
 
@@ -299,31 +446,27 @@ static void
 growMap( State* state ) {
     SymState* symState = state->symState;
     
-    uint mcap;
-    if( symState->map.row + 1 < slowGrowthMapCapTableSize )
-        mcap = slowGrowthMapCapTable[++symState->map.row];
-    else
-        mcap = symState->map.cap * 2;
+    uint mcap = symState->map.cap * 2;
+    uint mask = mcap - 1;
     
     Part mapP;
-    SymNode** map = stateAllocRaw( state, &mapP, sizeof(SymNode*)*mcap );
+    SymSlot* map = stateAllocRaw( state, &mapP, sizeof(SymSlot)*mcap );
     for( uint i = 0 ; i < mcap ; i++ )
-        map[i] = NULL;
+        map[i].sym = SYM_NONE;
     
     for( uint i = 0 ; i < symState->map.cap ; i++ ) {
-        SymNode* nIt = symState->map.buf[i];
-        while( nIt ) {
-            SymNode* node = nIt;
-            nIt = nIt->next;
-            
-            uint s = node->hash % mcap;
-            addNode( &map[s], node );
-        }
+        SymSlot slot = symState->map.buf[i];
+        if( slot.sym == SYM_NONE )
+            continue;
+        
+        uint s = slot.hash & mask;
+        while( map[s].sym != SYM_NONE )
+            s = (s + 1) & mask;
+        map[s] = slot;
     }
     
-    stateFreeRaw( state, symState->map.buf, sizeof(SymNode*)*symState->map.cap );
+    stateFreeRaw( state, symState->map.buf, sizeof(SymSlot)*symState->map.cap );
     stateCommitRaw( state, &mapP );
     symState->map.cap = mcap;
     symState->map.buf = map;
 }
-
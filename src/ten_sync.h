@@ -0,0 +1,40 @@
+/**********************************************************************
+This header provides the few synchronization primitives used by the
+components that can be shared between threads: atomic operations on
+plain integers and pointers, and a simple mutex.  The atomics map to
+the GCC/Clang builtins and are all sequentially consistent, the
+shared components are never hot enough for weaker orderings to
+be worth the extra care.  When compiled with `ten_NO_THREADS` the
+locks become no-ops.
+**********************************************************************/
+
+#ifndef ten_sync_h
+#define ten_sync_h
+
+#define atomicLoad( PTR )         __atomic_load_n( PTR, __ATOMIC_SEQ_CST )
+#define atomicStore( PTR, VAL )   __atomic_store_n( PTR, VAL, __ATOMIC_SEQ_CST )
+#define atomicSwap( PTR, VAL )    __atomic_exchange_n( PTR, VAL, __ATOMIC_SEQ_CST )
+#define atomicAdd( PTR, VAL )     __atomic_fetch_add( PTR, VAL, __ATOMIC_SEQ_CST )
+#define atomicSub( PTR, VAL )     __atomic_fetch_sub( PTR, VAL, __ATOMIC_SEQ_CST )
+#define atomicCas( PTR, EXP, VAL ) \
+    __atomic_compare_exchange_n( PTR, EXP, VAL, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST )
+
+#ifndef ten_NO_THREADS
+    #include <pthread.h>
+
+    typedef pthread_mutex_t Lock;
+
+    #define lockInit( LOCK )    pthread_mutex_init( LOCK, NULL )
+    #define lockFinl( LOCK )    pthread_mutex_destroy( LOCK )
+    #define lockAcquire( LOCK ) pthread_mutex_lock( LOCK )
+    #define lockRelease( LOCK ) pthread_mutex_unlock( LOCK )
+#else
+    typedef int Lock;
+
+    #define lockInit( LOCK )    ((void)(LOCK))
+    #define lockFinl( LOCK )    ((void)(LOCK))
+    #define lockAcquire( LOCK ) ((void)(LOCK))
+    #define lockRelease( LOCK ) ((void)(LOCK))
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+#include "ten_utf.h"
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) && !defined(ten_NO_SIMD)
+    #include <emmintrin.h>
+    #define UTF_SSE2
+#endif
+
+#define BLOCK (16)
+
+#define isLead( C ) ( ( (uchar)(C) & 0xC0 ) != 0x80 )
+
+static inline uint
+popcnt( uint32_t v ) {
+    #ifdef __GNUC__
+        return __builtin_popcount( v );
+    #else
+        uint n = 0;
+        while( v ) {
+            v &= v - 1;
+            n++;
+        }
+        return n;
+    #endif
+}
+
+#ifdef UTF_SSE2
+
+static inline bool
+blockAscii( char const* buf ) {
+    __m128i v = _mm_loadu_si128( (__m128i const*)buf );
+    return _mm_movemask_epi8( v ) == 0;
+}
+
+// Continuation bytes are the only ones below -64 as signed
+// bytes, so everything above that starts a character.
+static inline uint
+blockLeads( char const* buf ) {
+    __m128i v = _mm_loadu_si128( (__m128i const*)buf );
+    __m128i m = _mm_cmpgt_epi8( v, _mm_set1_epi8( -65 ) );
+    return popcnt( _mm_movemask_epi8( m ) );
+}
+
+#else
+
+#define HIGH_BITS (0x8080808080808080ull)
+
+static inline bool
+blockAscii( char const* buf ) {
+    uint64_t w[2];
+    memcpy( w, buf, BLOCK );
+    return ( ( w[0] | w[1] ) & HIGH_BITS ) == 0;
+}
+
+// A byte is a continuation byte if its top bit is set and the
+// next one isn't; shifting left lines the second bit up with
+// the first, and bits shifted across bytes are masked out.
+static inline uint
+blockLeads( char const* buf ) {
+    uint64_t w[2];
+    memcpy( w, buf, BLOCK );
+    
+    uint64_t c0 = w[0] & ~( w[0] << 1 ) & HIGH_BITS;
+    uint64_t c1 = w[1] & ~( w[1] << 1 ) & HIGH_BITS;
+    return BLOCK - popcnt( c0 >> 32 ) - popcnt( c0 )
+                 - popcnt( c1 >> 32 ) - popcnt( c1 );
+}
+
+#endif
+
+size_t
+utfAscii( char const* buf, size_t len ) {
+    size_t i = 0;
+    while( i + BLOCK <= len && blockAscii( buf + i ) )
+        i += BLOCK;
+    while( i < len && (uchar)buf[i] < 0x80 )
+        i++;
+    return i;
+}
+
+// Check `buf` one character at a time, it must start on a
+// character boundary.
+static bool
+checkChars( char const* buf, size_t len ) {
+    size_t i = 0;
+    while( i < len ) {
+        uchar c = buf[i];
+        
+        // Skip over runs of ASCII a block at a time.
+        if( c < 0x80 ) {
+            if( i + BLOCK <= len && blockAscii( buf + i ) )
+                i += BLOCK;
+            else
+                i++;
+            continue;
+        }
+        
+        uint n;
+        if( c >> 5 == 6 )
+            n = 2;
+        else
+        if( c >> 4 == 14 )
+            n = 3;
+        else
+        if( c >> 3 == 30 )
+            n = 4;
+        else
+            return false;
+        
+        if( len - i < n )
+            return false;
+        for( uint j = 1 ; j < n ; j++ )
+            if( isLead( buf[i + j] ) )
+                return false;
+        i += n;
+    }
+    return true;
+}
+
+#ifdef UTF_SSE2
+
+// Shift the block `cur` up by N bytes, filling in from the
+// top of `prv`.
+#define shiftIn( CUR, PRV, N ) \
+    _mm_or_si128( _mm_slli_si128( CUR, N ), _mm_srli_si128( PRV, 16 - N ) )
+
+bool
+utfCheck( char const* buf, size_t len ) {
+    // A byte must be a continuation byte exactly when a lead byte
+    // one, two, or three bytes before it calls for one that far
+    // ahead.  As signed bytes, leads of two or more bytes are negative
+    // and above -65, three or more above -33, four above -17; and
+    // negative bytes above -9 are never valid.  Continuation bytes
+    // are below -64.
+    __m128i need1 = _mm_setzero_si128();
+    __m128i need2 = _mm_setzero_si128();
+    __m128i need3 = _mm_setzero_si128();
+    __m128i errs  = _mm_setzero_si128();
+    
+    size_t i = 0;
+    for( ; i + BLOCK <= len ; i += BLOCK ) {
+        __m128i v    = _mm_loadu_si128( (__m128i const*)( buf + i ) );
+        __m128i neg  = _mm_cmplt_epi8( v, _mm_setzero_si128() );
+        __m128i n1   = _mm_and_si128( neg, _mm_cmpgt_epi8( v, _mm_set1_epi8( -65 ) ) );
+        __m128i n2   = _mm_and_si128( neg, _mm_cmpgt_epi8( v, _mm_set1_epi8( -33 ) ) );
+        __m128i n3   = _mm_and_si128( neg, _mm_cmpgt_epi8( v, _mm_set1_epi8( -17 ) ) );
+        __m128i bad  = _mm_and_si128( neg, _mm_cmpgt_epi8( v, _mm_set1_epi8( -9 ) ) );
+        __m128i cont = _mm_cmplt_epi8( v, _mm_set1_epi8( -64 ) );
+        
+        __m128i want = _mm_or_si128(
+            _mm_or_si128( shiftIn( n1, need1, 1 ), shiftIn( n2, need2, 2 ) ),
+            shiftIn( n3, need3, 3 )
+        );
+        errs = _mm_or_si128( errs, _mm_xor_si128( want, cont ) );
+        errs = _mm_or_si128( errs, bad );
+        
+        need1 = n1;
+        need2 = n2;
+        need3 = n3;
+    }
+    if( _mm_movemask_epi8( errs ) )
+        return false;
+    
+    // The last character in the blocks may run past them, so
+    // check the rest from its lead byte.
+    size_t j = i;
+    for( size_t k = 1 ; k <= 3 && k <= i ; k++ ) {
+        if( isLead( buf[i - k] ) ) {
+            j = i - k;
+            break;
+        }
+    }
+    return checkChars( buf + j, len - j );
+}
+
+#else
+
+bool
+utfCheck( char const* buf, size_t len ) {
+    return checkChars( buf, len );
+}
+
+#endif
+
+size_t
+utfCount( char const* buf, size_t len ) {
+    size_t n = 0;
+    size_t i = 0;
+    for( ; i + BLOCK <= len ; i += BLOCK )
+        n += blockLeads( buf + i );
+    for( ; i < len ; i++ )
+        n += isLead( buf[i] );
+    return n;
+}
+
+size_t
+utfSkip( char const* buf, size_t len, size_t n ) {
+    size_t i = 0;
+    
+    // If a block has no more than `n` characters starting in
+    // it then the one we're looking for comes after it.
+    while( i + BLOCK <= len ) {
+        uint c = blockLeads( buf + i );
+        if( c > n )
+            break;
+        n -= c;
+        i += BLOCK;
+    }
+    for( ; i < len ; i++ ) {
+        if( !isLead( buf[i] ) )
+            continue;
+        if( n == 0 )
+            return i;
+        n--;
+    }
+    return n == 0 ? len : SIZE_MAX;
+}
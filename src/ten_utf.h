@@ -0,0 +1,36 @@
+/***********************************************************************
+This component implements the UTF-8 scanning used by the character
+oriented string functions.  Ten only cares about the structure of
+the encoding: each lead byte must be followed by as many continuation
+bytes as it calls for, which is all the decoder relies on.  The scans
+work a block of 16 bytes at a time, with SSE2 where available and on
+64-bit words otherwise; define `ten_NO_SIMD` to use the portable
+version everywhere.  These work on raw buffers, see `strEnc()` for
+the cached per-String results.
+***********************************************************************/
+
+#ifndef ten_utf_h
+#define ten_utf_h
+#include "ten_types.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+// Number of leading bytes in `buf` that are ASCII.
+size_t
+utfAscii( char const* buf, size_t len );
+
+// Check that `buf` is well formed UTF-8.
+bool
+utfCheck( char const* buf, size_t len );
+
+// Number of characters in `buf`, which must be well formed.
+size_t
+utfCount( char const* buf, size_t len );
+
+// Byte offset of the character following the first `n` in
+// `buf`, which must be well formed; or `SIZE_MAX` if there
+// are fewer than `n` characters.
+size_t
+utfSkip( char const* buf, size_t len, size_t n );
+
+#endif
@@ -0,0 +1,423 @@
+#include "ten_vec.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(ten_NO_SIMD)
+    #if defined(__SSE2__)
+        #include <emmintrin.h>
+        #define VEC_SSE2
+    #endif
+    #if defined(__AVX2__)
+        #include <immintrin.h>
+        #define VEC_AVX2
+    #endif
+#endif
+
+#define wrapAdd( A, B ) ((IntT)( (uint32_t)(A) + (uint32_t)(B) ))
+#define wrapMul( A, B ) ((IntT)( (uint32_t)(A) * (uint32_t)(B) ))
+
+int64_t
+vecSumI( IntT const* v, size_t n ) {
+    size_t  i   = 0;
+    int64_t sum = 0;
+    
+    #ifdef VEC_SSE2
+        // Sign extend each lane to 64 bits by interleaving it with
+        // its sign, so the sum can't overflow.
+        __m128i acc = _mm_setzero_si128();
+        for( ; i + 4 <= n ; i += 4 ) {
+            __m128i x = _mm_loadu_si128( (__m128i const*)( v + i ) );
+            __m128i s = _mm_srai_epi32( x, 31 );
+            acc = _mm_add_epi64( acc, _mm_unpacklo_epi32( x, s ) );
+            acc = _mm_add_epi64( acc, _mm_unpackhi_epi32( x, s ) );
+        }
+        int64_t lanes[2];
+        _mm_storeu_si128( (__m128i*)lanes, acc );
+        sum = lanes[0] + lanes[1];
+    #endif
+    
+    for( ; i < n ; i++ )
+        sum += v[i];
+    return sum;
+}
+
+DecT
+vecSumD( DecT const* v, size_t n ) {
+    size_t i   = 0;
+    DecT   sum = 0.0;
+    
+    #ifdef VEC_SSE2
+        __m128d acc0 = _mm_setzero_pd();
+        __m128d acc1 = _mm_setzero_pd();
+        for( ; i + 4 <= n ; i += 4 ) {
+            acc0 = _mm_add_pd( acc0, _mm_loadu_pd( v + i ) );
+            acc1 = _mm_add_pd( acc1, _mm_loadu_pd( v + i + 2 ) );
+        }
+        double lanes[2];
+        _mm_storeu_pd( lanes, _mm_add_pd( acc0, acc1 ) );
+        sum = lanes[0] + lanes[1];
+    #endif
+    
+    for( ; i < n ; i++ )
+        sum += v[i];
+    return sum;
+}
+
+#if defined(VEC_AVX2)
+
+#define minMaxI( NAME, OP, SIMD )                                       \
+    IntT                                                                \
+    NAME( IntT const* v, size_t n ) {                                   \
+        size_t i = 0;                                                   \
+        IntT   r = v[0];                                                \
+        if( n >= 8 ) {                                                  \
+            __m256i acc = _mm256_loadu_si256( (__m256i const*)v );      \
+            for( i = 8 ; i + 8 <= n ; i += 8 )                          \
+                acc = SIMD( acc, _mm256_loadu_si256( (__m256i const*)( v + i ) ) ); \
+            IntT lanes[8];                                              \
+            _mm256_storeu_si256( (__m256i*)lanes, acc );                \
+            for( uint j = 0 ; j < 8 ; j++ )                             \
+                if( lanes[j] OP r )                                     \
+                    r = lanes[j];                                       \
+        }                                                               \
+        for( ; i < n ; i++ )                                            \
+            if( v[i] OP r )                                             \
+                r = v[i];                                               \
+        return r;                                                       \
+    }
+
+minMaxI( vecMinI, <, _mm256_min_epi32 )
+minMaxI( vecMaxI, >, _mm256_max_epi32 )
+
+#elif defined(VEC_SSE2)
+
+// SSE2 has no 32 bit min or max, so select with a comparison.
+static inline __m128i
+selectI( __m128i m, __m128i a, __m128i b ) {
+    return _mm_or_si128( _mm_and_si128( m, a ), _mm_andnot_si128( m, b ) );
+}
+
+#define minMaxI( NAME, OP, CMP )                                        \
+    IntT                                                                \
+    NAME( IntT const* v, size_t n ) {                                   \
+        size_t i = 0;                                                   \
+        IntT   r = v[0];                                                \
+        if( n >= 4 ) {                                                  \
+            __m128i acc = _mm_loadu_si128( (__m128i const*)v );         \
+            for( i = 4 ; i + 4 <= n ; i += 4 ) {                        \
+                __m128i x = _mm_loadu_si128( (__m128i const*)( v + i ) ); \
+                acc = selectI( CMP( x, acc ), x, acc );                 \
+            }                                                           \
+            IntT lanes[4];                                              \
+            _mm_storeu_si128( (__m128i*)lanes, acc );                   \
+            for( uint j = 0 ; j < 4 ; j++ )                             \
+                if( lanes[j] OP r )                                     \
+                    r = lanes[j];                                       \
+        }                                                               \
+        for( ; i < n ; i++ )                                            \
+            if( v[i] OP r )                                             \
+                r = v[i];                                               \
+        return r;                                                       \
+    }
+
+minMaxI( vecMinI, <, _mm_cmplt_epi32 )
+minMaxI( vecMaxI, >, _mm_cmpgt_epi32 )
+
+#else
+
+#define minMaxI( NAME, OP )                                             \
+    IntT                                                                \
+    NAME( IntT const* v, size_t n ) {                                   \
+        IntT r = v[0];                                                  \
+        for( size_t i = 1 ; i < n ; i++ )                               \
+            if( v[i] OP r )                                             \
+                r = v[i];                                               \
+        return r;                                                       \
+    }
+
+minMaxI( vecMinI, < )
+minMaxI( vecMaxI, > )
+
+#endif
+
+#if defined(VEC_SSE2)
+
+#define minMaxD( NAME, OP, SIMD )                                       \
+    DecT                                                                \
+    NAME( DecT const* v, size_t n ) {                                   \
+        size_t i = 0;                                                   \
+        DecT   r = v[0];                                                \
+        if( n >= 2 ) {                                                  \
+            __m128d acc = _mm_loadu_pd( v );                            \
+            for( i = 2 ; i + 2 <= n ; i += 2 )                          \
+                acc = SIMD( acc, _mm_loadu_pd( v + i ) );               \
+            double lanes[2];                                            \
+            _mm_storeu_pd( lanes, acc );                                \
+            for( uint j = 0 ; j < 2 ; j++ )                             \
+                if( lanes[j] OP r )                                     \
+                    r = lanes[j];                                       \
+        }                                                               \
+        for( ; i < n ; i++ )                                            \
+            if( v[i] OP r )                                             \
+                r = v[i];                                               \
+        return r;                                                       \
+    }
+
+minMaxD( vecMinD, <, _mm_min_pd )
+minMaxD( vecMaxD, >, _mm_max_pd )
+
+#else
+
+#define minMaxD( NAME, OP )                                             \
+    DecT                                                                \
+    NAME( DecT const* v, size_t n ) {                                   \
+        DecT r = v[0];                                                  \
+        for( size_t i = 1 ; i < n ; i++ )                               \
+            if( v[i] OP r )                                             \
+                r = v[i];                                               \
+        return r;                                                       \
+    }
+
+minMaxD( vecMinD, < )
+minMaxD( vecMaxD, > )
+
+#endif
+
+int64_t
+vecDotI( IntT const* a, IntT const* b, size_t n ) {
+    size_t  i   = 0;
+    int64_t dot = 0;
+    
+    #ifdef VEC_AVX2
+        // The signed multiply only looks at the even lanes, so
+        // the odd ones are shifted down to be multiplied next.
+        __m256i acc = _mm256_setzero_si256();
+        for( ; i + 8 <= n ; i += 8 ) {
+            __m256i x = _mm256_loadu_si256( (__m256i const*)( a + i ) );
+            __m256i y = _mm256_loadu_si256( (__m256i const*)( b + i ) );
+            acc = _mm256_add_epi64( acc, _mm256_mul_epi32( x, y ) );
+            acc = _mm256_add_epi64(
+                acc,
+                _mm256_mul_epi32( _mm256_srli_epi64( x, 32 ), _mm256_srli_epi64( y, 32 ) )
+            );
+        }
+        int64_t lanes[4];
+        _mm256_storeu_si256( (__m256i*)lanes, acc );
+        dot = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    #endif
+    
+    for( ; i < n ; i++ )
+        dot += (int64_t)a[i] * b[i];
+    return dot;
+}
+
+DecT
+vecDotD( DecT const* a, DecT const* b, size_t n ) {
+    size_t i   = 0;
+    DecT   dot = 0.0;
+    
+    #ifdef VEC_SSE2
+        __m128d acc0 = _mm_setzero_pd();
+        __m128d acc1 = _mm_setzero_pd();
+        for( ; i + 4 <= n ; i += 4 ) {
+            acc0 = _mm_add_pd( acc0, _mm_mul_pd( _mm_loadu_pd( a + i ), _mm_loadu_pd( b + i ) ) );
+            acc1 = _mm_add_pd( acc1, _mm_mul_pd( _mm_loadu_pd( a + i + 2 ), _mm_loadu_pd( b + i + 2 ) ) );
+        }
+        double lanes[2];
+        _mm_storeu_pd( lanes, _mm_add_pd( acc0, acc1 ) );
+        dot = lanes[0] + lanes[1];
+    #endif
+    
+    for( ; i < n ; i++ )
+        dot += a[i] * b[i];
+    return dot;
+}
+
+void
+vecScaleI( IntT* v, size_t n, IntT k ) {
+    size_t i = 0;
+    
+    #ifdef VEC_AVX2
+        __m256i kv = _mm256_set1_epi32( k );
+        for( ; i + 8 <= n ; i += 8 ) {
+            __m256i x = _mm256_loadu_si256( (__m256i const*)( v + i ) );
+            _mm256_storeu_si256( (__m256i*)( v + i ), _mm256_mullo_epi32( x, kv ) );
+        }
+    #endif
+    
+    for( ; i < n ; i++ )
+        v[i] = wrapMul( v[i], k );
+}
+
+void
+vecScaleD( DecT* v, size_t n, DecT k ) {
+    size_t i = 0;
+    
+    #ifdef VEC_SSE2
+        __m128d kv = _mm_set1_pd( k );
+        for( ; i + 2 <= n ; i += 2 )
+            _mm_storeu_pd( v + i, _mm_mul_pd( _mm_loadu_pd( v + i ), kv ) );
+    #endif
+    
+    for( ; i < n ; i++ )
+        v[i] *= k;
+}
+
+void
+vecAddI( IntT* a, IntT const* b, size_t n ) {
+    size_t i = 0;
+    
+    #ifdef VEC_SSE2
+        for( ; i + 4 <= n ; i += 4 ) {
+            __m128i x = _mm_loadu_si128( (__m128i const*)( a + i ) );
+            __m128i y = _mm_loadu_si128( (__m128i const*)( b + i ) );
+            _mm_storeu_si128( (__m128i*)( a + i ), _mm_add_epi32( x, y ) );
+        }
+    #endif
+    
+    for( ; i < n ; i++ )
+        a[i] = wrapAdd( a[i], b[i] );
+}
+
+void
+vecAddD( DecT* a, DecT const* b, size_t n ) {
+    size_t i = 0;
+    
+    #ifdef VEC_SSE2
+        for( ; i + 2 <= n ; i += 2 )
+            _mm_storeu_pd( a + i, _mm_add_pd( _mm_loadu_pd( a + i ), _mm_loadu_pd( b + i ) ) );
+    #endif
+    
+    for( ; i < n ; i++ )
+        a[i] += b[i];
+}
+
+#define cmpScalar( CMP, A, B )          \
+    ( (CMP) == VEC_LT ? (A) <  (B) :    \
+      (CMP) == VEC_MT ? (A) >  (B) :    \
+      (CMP) == VEC_EQ ? (A) == (B) :    \
+      (CMP) == VEC_LE ? (A) <= (B) :    \
+      (CMP) == VEC_ME ? (A) >= (B) :    \
+                        (A) != (B) )
+
+#ifdef VEC_SSE2
+
+// Lanes of all ones where the comparison holds, SSE2 only has
+// less than, greater than, and equality for integers; so the rest
+// are the inverse of one of those.
+static inline __m128i
+cmpI( VecCmp cmp, __m128i a, __m128i b ) {
+    __m128i ones = _mm_set1_epi32( -1 );
+    switch( cmp ) {
+        case VEC_LT: return _mm_cmplt_epi32( a, b );
+        case VEC_MT: return _mm_cmpgt_epi32( a, b );
+        case VEC_EQ: return _mm_cmpeq_epi32( a, b );
+        case VEC_LE: return _mm_xor_si128( _mm_cmpgt_epi32( a, b ), ones );
+        case VEC_ME: return _mm_xor_si128( _mm_cmplt_epi32( a, b ), ones );
+        default:     return _mm_xor_si128( _mm_cmpeq_epi32( a, b ), ones );
+    }
+}
+
+static inline __m128d
+cmpD( VecCmp cmp, __m128d a, __m128d b ) {
+    switch( cmp ) {
+        case VEC_LT: return _mm_cmplt_pd( a, b );
+        case VEC_MT: return _mm_cmpgt_pd( a, b );
+        case VEC_EQ: return _mm_cmpeq_pd( a, b );
+        case VEC_LE: return _mm_cmple_pd( a, b );
+        case VEC_ME: return _mm_cmpge_pd( a, b );
+        default:     return _mm_cmpneq_pd( a, b );
+    }
+}
+
+#endif
+
+void
+vecMaskI( IntT* dst, IntT const* v, size_t n, VecCmp cmp, IntT x ) {
+    size_t i = 0;
+    
+    #ifdef VEC_SSE2
+        __m128i xv = _mm_set1_epi32( x );
+        for( ; i + 4 <= n ; i += 4 ) {
+            __m128i m = cmpI( cmp, _mm_loadu_si128( (__m128i const*)( v + i ) ), xv );
+            _mm_storeu_si128( (__m128i*)( dst + i ), _mm_srli_epi32( m, 31 ) );
+        }
+    #endif
+    
+    for( ; i < n ; i++ )
+        dst[i] = cmpScalar( cmp, v[i], x );
+}
+
+void
+vecMaskD( IntT* dst, DecT const* v, size_t n, VecCmp cmp, DecT x ) {
+    size_t i = 0;
+    
+    #ifdef VEC_SSE2
+        __m128d xv = _mm_set1_pd( x );
+        for( ; i + 2 <= n ; i += 2 ) {
+            int m = _mm_movemask_pd( cmpD( cmp, _mm_loadu_pd( v + i ), xv ) );
+            dst[i]   = m & 1;
+            dst[i+1] = m >> 1;
+        }
+    #endif
+    
+    for( ; i < n ; i++ )
+        dst[i] = cmpScalar( cmp, v[i], x );
+}
+
+static int
+compareI( void const* a, void const* b ) {
+    IntT x = *(IntT const*)a;
+    IntT y = *(IntT const*)b;
+    return ( x > y ) - ( x < y );
+}
+
+static int
+compareD( void const* a, void const* b ) {
+    DecT x = *(DecT const*)a;
+    DecT y = *(DecT const*)b;
+    return ( x > y ) - ( x < y );
+}
+
+void
+vecSortI( IntT* v, size_t n ) {
+    qsort( v, n, sizeof(IntT), compareI );
+}
+
+void
+vecSortD( DecT* v, size_t n ) {
+    qsort( v, n, sizeof(DecT), compareD );
+}
+
+void
+vecScanI( IntT* v, size_t n ) {
+    for( size_t i = 1 ; i < n ; i++ )
+        v[i] = wrapAdd( v[i], v[i-1] );
+}
+
+void
+vecScanD( DecT* v, size_t n ) {
+    for( size_t i = 1 ; i < n ; i++ )
+        v[i] += v[i-1];
+}
+
+bool
+vecHasNaND( DecT const* v, size_t n ) {
+    size_t i = 0;
+    
+    #ifdef VEC_SSE2
+        // Only NaN lanes are unordered with themselves.
+        __m128d acc = _mm_setzero_pd();
+        for( ; i + 2 <= n ; i += 2 ) {
+            __m128d x = _mm_loadu_pd( v + i );
+            acc = _mm_or_pd( acc, _mm_cmpunord_pd( x, x ) );
+        }
+        if( _mm_movemask_pd( acc ) )
+            return true;
+    #endif
+    
+    for( ; i < n ; i++ )
+        if( v[i] != v[i] )
+            return true;
+    return false;
+}
@@ -0,0 +1,95 @@
+/***********************************************************************
+This component implements the numeric kernels behind the prelude's
+packed vectors, which keep `IntT` or `DecT` values in contiguous
+arrays instead of records of boxed values.  Kernels work on raw
+arrays two or four lanes at a time with SSE2 where available, with
+AVX2 used for the integer operations SSE2 lacks when compiled for
+it; and fall back to plain loops otherwise.  Define `ten_NO_SIMD`
+to use the portable versions everywhere.
+
+Integer arithmetic wraps around on overflow, sums and products are
+accumulated in 64 bits so callers can check the result's range.
+The sum of Decs is accumulated in lanes, so may round differently
+than a sequential sum would.
+***********************************************************************/
+
+#ifndef ten_vec_h
+#define ten_vec_h
+#include "ten_types.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    VEC_LT,
+    VEC_MT,
+    VEC_EQ,
+    VEC_LE,
+    VEC_ME,
+    VEC_NE
+} VecCmp;
+
+int64_t
+vecSumI( IntT const* v, size_t n );
+
+DecT
+vecSumD( DecT const* v, size_t n );
+
+// The min and max kernels expect `n > 0`.
+IntT
+vecMinI( IntT const* v, size_t n );
+
+IntT
+vecMaxI( IntT const* v, size_t n );
+
+DecT
+vecMinD( DecT const* v, size_t n );
+
+DecT
+vecMaxD( DecT const* v, size_t n );
+
+int64_t
+vecDotI( IntT const* a, IntT const* b, size_t n );
+
+DecT
+vecDotD( DecT const* a, DecT const* b, size_t n );
+
+void
+vecScaleI( IntT* v, size_t n, IntT k );
+
+void
+vecScaleD( DecT* v, size_t n, DecT k );
+
+// Add `b` to `a` element-wise.
+void
+vecAddI( IntT* a, IntT const* b, size_t n );
+
+void
+vecAddD( DecT* a, DecT const* b, size_t n );
+
+// Set each `dst[i]` to `1` if `v[i] CMP x`, `0` otherwise.
+void
+vecMaskI( IntT* dst, IntT const* v, size_t n, VecCmp cmp, IntT x );
+
+void
+vecMaskD( IntT* dst, DecT const* v, size_t n, VecCmp cmp, DecT x );
+
+// Sort ascending in place.
+void
+vecSortI( IntT* v, size_t n );
+
+void
+vecSortD( DecT* v, size_t n );
+
+// Replace each value with the sum of itself and those before it.
+void
+vecScanI( IntT* v, size_t n );
+
+void
+vecScanD( DecT* v, size_t n );
+
+// Check whether any of the values is NaN.
+bool
+vecHasNaND( DecT const* v, size_t n );
+
+#endif
@@ -0,0 +1,59 @@
+/**********************************************************************
+Helpers shared by the interface tests, which exercise the API from C
+rather than from a test script.  Each test file has an entry point
+which prints its groups and checks in the same format as the script
+tests; these are declared at the bottom and called by the tester.
+**********************************************************************/
+
+#ifndef interface_h
+#define interface_h
+#include <ten.h>
+#include <stdbool.h>
+
+typedef bool (*Test)( ten_State* ten );
+
+// Outputs a group header for the given group name.
+void
+group( char const* name );
+
+// Runs the test in a fresh State, made with the given config, and
+// outputs whether it passed.  It passes if it returns `true` and
+// doesn't raise any errors that it doesn't catch itself.
+void
+check( char const* what, ten_Config* config, Test test );
+
+// Calls `fun` and returns whether it raised an error in the State,
+// the error is left in place to be inspected with `ten_getErrStr()`
+// and friends.
+bool
+fails( ten_State* ten, void (*fun)( ten_State* ten, void* udata ), void* udata );
+
+// Runs a script in the State's global scope.
+void
+script( ten_State* ten, char const* src );
+
+// Evaluates an expression in the State's global scope and returns
+// whether it came out as `true`.
+bool
+holds( ten_State* ten, char const* expr );
+
+// Test files.
+void
+testImages( void );
+
+void
+testMemory( void );
+
+void
+testPatterns( void );
+
+void
+testGlobals( void );
+
+void
+testPrepared( void );
+
+void
+testStrings( void );
+
+#endif
@@ -0,0 +1,69 @@
+#include "interface.h"
+
+static bool
+refUndefined( ten_State* ten ) {
+    ten_GlobalRef ref = ten_globalRef( ten, ten_sym( ten, "x" ) );
+    
+    ten_Tup tup = ten_pushA( ten, "U" );
+    ten_Var var = ten_var( tup, 0 );
+    ten_getGlobal( ten, ref, &var );
+    if( !ten_isUdf( ten, &var ) )
+        return false;
+    
+    // Setting through the handle defines the global.
+    ten_setGlobal( ten, ref, ten_int( ten, 1 ) );
+    return holds( ten, "x = 1" );
+}
+
+static bool
+refPromoted( ten_State* ten ) {
+    script( ten, "def x: 1" );
+    ten_GlobalRef ref = ten_globalRef( ten, ten_sym( ten, "x" ) );
+    
+    // Capturing the global in a closure moves its value into an
+    // Upvalue, which the handle should see through.
+    script( ten, "def getX: [] x\ndef setX: [ v ] set x: v" );
+    
+    ten_Tup tup = ten_pushA( ten, "U" );
+    ten_Var var = ten_var( tup, 0 );
+    ten_getGlobal( ten, ref, &var );
+    if( !ten_isInt( ten, &var ) || ten_getInt( ten, &var ) != 1 )
+        return false;
+    
+    ten_setGlobal( ten, ref, ten_int( ten, 5 ) );
+    if( !holds( ten, "getX() = 5" ) || !holds( ten, "x = 5" ) )
+        return false;
+    
+    script( ten, "setX( 9 )" );
+    ten_getGlobal( ten, ref, &var );
+    return ten_isInt( ten, &var ) && ten_getInt( ten, &var ) == 9;
+}
+
+static bool
+snapshot( ten_State* ten ) {
+    script( ten, "def a: 1\ndef b: \"str\"\ndef getA: [] a" );
+    ten_globalRef( ten, ten_sym( ten, "unset" ) );
+    
+    ten_Tup tup = ten_pushA( ten, "U" );
+    ten_Var var = ten_var( tup, 0 );
+    ten_globals( ten, &var );
+    ten_def( ten, ten_sym( ten, "snap" ), &var );
+    
+    // Promoted globals show their values, reserved but undefined
+    // ones are left out, and later changes aren't seen.
+    script( ten, "set a: 2" );
+    return
+        holds( ten, "snap.a = 1" ) &&
+        holds( ten, "bcmp( snap.b, '=', \"str\" )" ) &&
+        holds( ten, "snap.getA = getA" ) &&
+        holds( ten, "snap.unset != udf" ) &&
+        holds( ten, "snap.snap != udf" );
+}
+
+void
+testGlobals( void ) {
+    group( "Globals" );
+    check( "Ref To Undefined Global", NULL, refUndefined );
+    check( "Ref To Promoted Global", NULL, refPromoted );
+    check( "Globals Snapshot", NULL, snapshot );
+}
@@ -0,0 +1,121 @@
+#include "interface.h"
+
+// Globals of every kind that can be copied into an image.
+static char const* copyable =
+    "def n:   123\n"
+    "def s:   \"str\"\n"
+    "def r:   { .a: 1, .b: { 2, 3 } }\n"
+    "def r.self: r\n"
+    "def add: [ a, b ] a + b\n"
+    "def cnt: 0\n"
+    "def inc: [] set cnt: cnt + 1\n";
+
+// And some that can't, since they're tied to the State that
+// made them.
+static char const* uncopyable =
+    "def fib: fiber( [] 1 )\n"
+    "def itr: keys( { .a: 1 } )\n"
+    "def bld: builder()\n"
+    "def buf: buffer()\n"
+    "def vct: vec( 'Int', 4 )\n"
+    "def mix: { .f: fiber( [] 1 ), .i: 1 }\n"
+    "def mix@( builder() ): 2\n";
+
+static bool
+hasCopies( ten_State* ten ) {
+    return
+        holds( ten, "n = 123" ) &&
+        holds( ten, "bcmp( s, '=', \"str\" )" ) &&
+        holds( ten, "r.b@1 = 3" ) &&
+        holds( ten, "r.self.self.a = 1" ) &&
+        holds( ten, "add( 1, 2 ) = 3" ) &&
+        holds( ten, "do inc(), inc() for cnt = 2" );
+}
+
+static bool
+forkCopy( ten_State* ten ) {
+    script( ten, copyable );
+    
+    jmp_buf    jmp;
+    ten_State* child = ten_fork( ten, &jmp );
+    if( setjmp( jmp ) ) {
+        ten_free( child );
+        return false;
+    }
+    
+    bool passed = hasCopies( child );
+    
+    // Neither sees the other's changes.
+    passed = passed && holds( child, "do set n: 321 for n = 321" );
+    passed = passed && holds( ten, "n = 123" );
+    passed = passed && holds( ten, "cnt = 0" );
+    
+    ten_free( child );
+    return passed;
+}
+
+static bool
+forkSkip( ten_State* ten ) {
+    script( ten, copyable );
+    script( ten, uncopyable );
+    
+    jmp_buf    jmp;
+    ten_State* child = ten_fork( ten, &jmp );
+    if( setjmp( jmp ) ) {
+        ten_free( child );
+        return false;
+    }
+    
+    bool passed =
+        hasCopies( child ) &&
+        holds( child, "fib != udf" ) &&
+        holds( child, "itr != udf" ) &&
+        holds( child, "bld != udf" ) &&
+        holds( child, "buf != udf" ) &&
+        holds( child, "vct != udf" ) &&
+        holds( child, "mix.f != udf" ) &&
+        holds( child, "mix.i = 1" ) &&
+        holds( child, "fold( vals( mix ), 0, [ a, v ] a + 1 ) = 1" );
+    
+    ten_free( child );
+    return passed && holds( ten, "'Fib' = type( fib )" );
+}
+
+static bool
+restoreSkip( ten_State* ten ) {
+    script( ten, copyable );
+    script( ten, uncopyable );
+    
+    ten_Image* img = ten_snapshot( ten );
+    
+    jmp_buf    jmp;
+    ten_State* other = ten_make( NULL, &jmp );
+    if( setjmp( jmp ) ) {
+        ten_free( other );
+        ten_freeImage( img );
+        return false;
+    }
+    
+    // Globals the host defines before restoring are rebound,
+    // those it doesn't come out undefined.
+    script( other, "def buf: buffer()" );
+    ten_restore( other, img );
+    
+    bool passed =
+        hasCopies( other ) &&
+        holds( other, "fib != udf" ) &&
+        holds( other, "bld != udf" ) &&
+        holds( other, "buflen( buf ) = 0" );
+    
+    ten_free( other );
+    ten_freeImage( img );
+    return passed;
+}
+
+void
+testImages( void ) {
+    group( "Images" );
+    check( "Fork Copies Globals", NULL, forkCopy );
+    check( "Fork Skips Uncopyable Values", NULL, forkSkip );
+    check( "Restore Skips Unbound Values", NULL, restoreSkip );
+}
@@ -0,0 +1,62 @@
+#include "interface.h"
+
+// Builds a record of a couple hundred thousand strings, several
+// megabytes in all.
+#define FILL                                                            \
+    "def big: {}\n"                                                     \
+    "each( irange( 0, 200_000 ), [ i ] def big@i: cat( \"item-\", i ) )\n"
+
+static void
+fill( ten_State* ten, void* udata ) {
+    script( ten, "do\n" FILL "for()" );
+}
+
+static bool
+usage( ten_State* ten ) {
+    size_t used = ten_memUsed( ten );
+    if( used == 0 || ten_memPeak( ten ) < used )
+        return false;
+    
+    script( ten, FILL );
+    size_t full = ten_memUsed( ten );
+    size_t peak = ten_memPeak( ten );
+    if( full <= used || peak < full )
+        return false;
+    
+    // Dropping the record frees its memory, but the peak stays.
+    script( ten, "def big: nil\ncollect()" );
+    return ten_memUsed( ten ) < full && ten_memPeak( ten ) == peak;
+}
+
+static bool
+cap( ten_State* ten ) {
+    if( !fails( ten, fill, NULL ) )
+        return false;
+    if( ten_getErrNum( ten, NULL ) != ten_ERR_SYSTEM )
+        return false;
+    ten_clearError( ten, NULL );
+    
+    // The State stays usable, and the cap was never passed.
+    script( ten, "def small: cat( \"a\", \"b\" )" );
+    return
+        holds( ten, "bcmp( small, '=', \"ab\" )" ) &&
+        ten_memPeak( ten ) <= 1024*1024;
+}
+
+static bool
+capInFiber( ten_State* ten ) {
+    script( ten, "def fib: fiber( [] do\n" FILL "for() )\ncont( fib, {} )" );
+    return
+        holds( ten, "'failed' = state( fib )" ) &&
+        holds( ten, "do def r: { 1, 2, 3 } for r@2 = 3" );
+}
+
+void
+testMemory( void ) {
+    ten_Config capped = { .memMax = 1024*1024 };
+    
+    group( "Memory" );
+    check( "Usage Queries", NULL, usage );
+    check( "Memory Cap", &capped, cap );
+    check( "Memory Cap In Fiber", &capped, capInFiber );
+}
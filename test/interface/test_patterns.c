@@ -0,0 +1,186 @@
+#include "interface.h"
+#include <stddef.h>
+#include <string.h>
+
+static bool
+isSym( ten_State* ten, ten_Var* var, char const* sym ) {
+    return
+        ten_isSym( ten, var ) &&
+        ten_getSymLen( ten, var ) == strlen( sym ) &&
+        !memcmp( ten_getSymBuf( ten, var ), sym, strlen( sym ) );
+}
+
+static bool
+isStr( ten_State* ten, ten_Var* var, char const* str ) {
+    return
+        ten_isStr( ten, var ) &&
+        ten_getStrLen( ten, var ) == strlen( str ) &&
+        !memcmp( ten_getStrBuf( ten, var ), str, strlen( str ) );
+}
+
+static bool
+pushPattern( ten_State* ten ) {
+    ten_Tup vTup = ten_pushA( ten, "I", 7L );
+    ten_Var vVar = ten_var( vTup, 0 );
+    
+    ten_Pattern* pat = ten_addPattern( ten, "UNLIDSV" );
+    ten_Tup      tup = ten_pushP( ten, pat, true, 123L, 1.5, "abc", &vVar );
+    
+    ten_Var u = ten_var( tup, 0 );
+    ten_Var n = ten_var( tup, 1 );
+    ten_Var l = ten_var( tup, 2 );
+    ten_Var i = ten_var( tup, 3 );
+    ten_Var d = ten_var( tup, 4 );
+    ten_Var s = ten_var( tup, 5 );
+    ten_Var v = ten_var( tup, 6 );
+    return
+        ten_size( ten, &tup ) == 7 &&
+        ten_isUdf( ten, &u ) &&
+        ten_isNil( ten, &n ) &&
+        ten_getLog( ten, &l ) == true &&
+        ten_getInt( ten, &i ) == 123 &&
+        ten_getDec( ten, &d ) == 1.5 &&
+        isSym( ten, &s, "abc" ) &&
+        ten_getInt( ten, &v ) == 7;
+}
+
+static bool
+pushPlain( ten_State* ten ) {
+    ten_Pattern* pat = ten_addPattern( ten, "NUN" );
+    ten_Tup      tup = ten_pushP( ten, pat );
+    
+    ten_Var v0 = ten_var( tup, 0 );
+    ten_Var v1 = ten_var( tup, 1 );
+    ten_Var v2 = ten_var( tup, 2 );
+    return
+        ten_size( ten, &tup ) == 3 &&
+        ten_isNil( ten, &v0 ) &&
+        ten_isUdf( ten, &v1 ) &&
+        ten_isNil( ten, &v2 );
+}
+
+typedef struct {
+    ten_Var* first;
+    ten_Var* second;
+    long     count;
+    double   ratio;
+    bool     flag;
+} Fields;
+
+static size_t const fieldOffs[] = {
+    offsetof( Fields, first ),
+    offsetof( Fields, second ),
+    offsetof( Fields, count ),
+    offsetof( Fields, ratio ),
+    offsetof( Fields, flag )
+};
+
+static bool
+readPattern( ten_State* ten ) {
+    ten_Tup symTup = ten_pushA( ten, "UU" );
+    ten_Var sym1   = ten_var( symTup, 0 );
+    ten_Var sym2   = ten_var( symTup, 1 );
+    
+    // Both symbols are short, so they'd share a buffer if they
+    // were decoded while reading.
+    ten_Pattern* pat = ten_addPattern( ten, "SSIDL" );
+    ten_Tup      tup = ten_pushP( ten, pat, "foo", "bar", 3L, 0.25, true );
+    
+    Fields f = { .first = &sym1, .second = &sym2 };
+    ten_readP( ten, pat, &tup, &f, fieldOffs );
+    return
+        isSym( ten, &sym1, "foo" ) &&
+        isSym( ten, &sym2, "bar" ) &&
+        f.count == 3 &&
+        f.ratio == 0.25 &&
+        f.flag == true;
+}
+
+static void
+readWrongSize( ten_State* ten, void* udata ) {
+    ten_Pattern* pat = udata;
+    ten_Tup      tup = ten_pushA( ten, "II", 1L, 2L );
+    
+    Fields f;
+    ten_readP( ten, pat, &tup, &f, fieldOffs + 2 );
+}
+
+static void
+readWrongType( ten_State* ten, void* udata ) {
+    ten_Pattern* pat = udata;
+    ten_Tup      tup = ten_pushA( ten, "IIL", 1L, 2L, false );
+    
+    Fields f;
+    ten_readP( ten, pat, &tup, &f, fieldOffs + 2 );
+}
+
+static bool
+readMismatch( ten_State* ten ) {
+    ten_Pattern* pat = ten_addPattern( ten, "IDL" );
+    
+    if( !fails( ten, readWrongSize, pat ) )
+        return false;
+    if( ten_getErrNum( ten, NULL ) != ten_ERR_TUPLE )
+        return false;
+    ten_clearError( ten, NULL );
+    
+    if( !fails( ten, readWrongType, pat ) )
+        return false;
+    return ten_getErrNum( ten, NULL ) == ten_ERR_TYPE;
+}
+
+static bool
+freePatterns( ten_State* ten ) {
+    ten_Pattern* p1 = ten_addPattern( ten, "I" );
+    ten_Pattern* p2 = ten_addPattern( ten, "II" );
+    ten_Pattern* p3 = ten_addPattern( ten, "III" );
+    ten_Pattern* p4 = ten_addPattern( ten, "IIII" );
+    
+    // From the middle, the head, and the tail of the list.
+    ten_freePattern( ten, p2 );
+    ten_freePattern( ten, p4 );
+    ten_freePattern( ten, p1 );
+    
+    ten_Tup tup = ten_pushP( ten, p3, 1L, 2L, 3L );
+    ten_Var v2  = ten_var( tup, 2 );
+    return ten_size( ten, &tup ) == 3 && ten_getInt( ten, &v2 ) == 3;
+}
+
+static bool
+bulkPushes( ten_State* ten ) {
+    long const        ints[] = { 1, -2, 3 };
+    double const      decs[] = { 0.5, -1.25 };
+    char const* const strs[] = { "one", "", "three" };
+    
+    ten_Tup iTup = ten_pushInts( ten, ints, 3 );
+    ten_Tup dTup = ten_pushDecs( ten, decs, 2 );
+    ten_Tup sTup = ten_pushStrs( ten, strs, 3 );
+    ten_Tup eTup = ten_pushInts( ten, NULL, 0 );
+    
+    ten_Var i1 = ten_var( iTup, 1 );
+    ten_Var d1 = ten_var( dTup, 1 );
+    ten_Var s0 = ten_var( sTup, 0 );
+    ten_Var s1 = ten_var( sTup, 1 );
+    ten_Var s2 = ten_var( sTup, 2 );
+    return
+        ten_size( ten, &iTup ) == 3 &&
+        ten_size( ten, &dTup ) == 2 &&
+        ten_size( ten, &sTup ) == 3 &&
+        ten_size( ten, &eTup ) == 0 &&
+        ten_getInt( ten, &i1 ) == -2 &&
+        ten_getDec( ten, &d1 ) == -1.25 &&
+        isStr( ten, &s0, "one" ) &&
+        isStr( ten, &s1, "" ) &&
+        isStr( ten, &s2, "three" );
+}
+
+void
+testPatterns( void ) {
+    group( "Patterns" );
+    check( "Push Pattern", NULL, pushPattern );
+    check( "Push Plain Pattern", NULL, pushPlain );
+    check( "Read Pattern", NULL, readPattern );
+    check( "Read Pattern Mismatch", NULL, readMismatch );
+    check( "Free Patterns", NULL, freePatterns );
+    check( "Bulk Pushes", NULL, bulkPushes );
+}
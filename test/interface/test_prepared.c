@@ -0,0 +1,166 @@
+#include "interface.h"
+
+// The prepared call made by each test, and the arguments `run()`
+// passes to it.
+static ten_Prep* prep;
+static long      args[4];
+static unsigned  argc;
+
+ten_define(run) {
+    ten_State* ten = call->ten;
+    ten_Tup    tup = ten_pushCall( ten, prep );
+    for( unsigned i = 0 ; i < argc ; i++ ) {
+        ten_Var arg = ten_var( tup, i );
+        ten_copy( ten, ten_int( ten, args[i] ), &arg );
+    }
+    return ten_callPrepared( ten, prep );
+}
+
+// Defines the global `run()`, which makes the prepared call from
+// inside a running fiber.
+static void
+defRun( ten_State* ten ) {
+    ten_Tup tup = ten_pushA( ten, "UU" );
+    ten_Var fun = ten_var( tup, 0 );
+    ten_Var cls = ten_var( tup, 1 );
+    
+    ten_FunParams p = {
+        .name   = "run",
+        .params = (char const*[]){ NULL },
+        .cb     = ten_fun(run)
+    };
+    ten_newFun( ten, &p, &fun );
+    ten_newCls( ten, &fun, NULL, &cls );
+    ten_def( ten, ten_sym( ten, "run" ), &cls );
+    ten_pop( ten );
+}
+
+static void
+prepare( ten_State* ten, char const* name, unsigned n ) {
+    ten_Tup tup = ten_pushA( ten, "U" );
+    ten_Var cls = ten_var( tup, 0 );
+    ten_get( ten, ten_sym( ten, name ), &cls );
+    prep = ten_prepareCall( ten, &cls, n );
+    argc = n;
+    ten_pop( ten );
+}
+
+static bool
+fixedArity( ten_State* ten ) {
+    defRun( ten );
+    script( ten, "def add: [ a, b ] a * 10 + b" );
+    prepare( ten, "add", 2 );
+    
+    args[0] = 1; args[1] = 2;
+    if( !holds( ten, "run() = 12" ) )
+        return false;
+    
+    // The same handle is good for any number of calls.
+    args[0] = 3; args[1] = 4;
+    return holds( ten, "run() + run() = 68" );
+}
+
+static bool
+noArgs( ten_State* ten ) {
+    defRun( ten );
+    script( ten, "def cnt: 0\ndef tick: [] do set cnt: cnt + 1 for cnt" );
+    prepare( ten, "tick", 0 );
+    
+    return
+        holds( ten, "run() = 1" ) &&
+        holds( ten, "run() = 2" ) &&
+        holds( ten, "cnt = 2" );
+}
+
+static bool
+variadic( ten_State* ten ) {
+    defRun( ten );
+    script( ten, "def sum: [ a, rest... ] fold( vals( rest ), a, [ s, v ] s + v )" );
+    
+    // Extra arguments go in the variadic record, and it's left
+    // empty if there aren't any.
+    prepare( ten, "sum", 4 );
+    args[0] = 1; args[1] = 2; args[2] = 3; args[3] = 4;
+    if( !holds( ten, "run() = 10" ) )
+        return false;
+    
+    prepare( ten, "sum", 1 );
+    return holds( ten, "run() = 1" );
+}
+
+static void
+prepareBad( ten_State* ten, void* udata ) {
+    unsigned const* n = udata;
+    prepare( ten, "add", *n );
+}
+
+static void
+prepareBadVariadic( ten_State* ten, void* udata ) {
+    prepare( ten, "sum", 0 );
+}
+
+static bool
+wrongCount( ten_State* ten ) {
+    script( ten, "def add: [ a, b ] a + b" );
+    script( ten, "def sum: [ a, rest... ] a" );
+    
+    unsigned fewer = 1;
+    if( !fails( ten, prepareBad, &fewer ) )
+        return false;
+    if( ten_getErrNum( ten, NULL ) != ten_ERR_CALL )
+        return false;
+    ten_clearError( ten, NULL );
+    
+    unsigned more = 3;
+    if( !fails( ten, prepareBad, &more ) )
+        return false;
+    if( ten_getErrNum( ten, NULL ) != ten_ERR_CALL )
+        return false;
+    ten_clearError( ten, NULL );
+    
+    if( !fails( ten, prepareBadVariadic, NULL ) )
+        return false;
+    return ten_getErrNum( ten, NULL ) == ten_ERR_CALL;
+}
+
+static unsigned freed;
+
+static void
+countFree( char const* buf, size_t len, void* udata ) {
+    freed++;
+}
+
+static bool
+release( ten_State* ten ) {
+    static char const text[] = "external";
+    freed = 0;
+    
+    // The closure captures an external String, so we can tell
+    // when it's been collected.
+    ten_Tup tup = ten_pushA( ten, "U" );
+    ten_Var str = ten_var( tup, 0 );
+    ten_newExtStr( ten, text, sizeof(text) - 1, countFree, NULL, &str );
+    ten_def( ten, ten_sym( ten, "ext" ), &str );
+    ten_pop( ten );
+    
+    script( ten, "def get: do def s: ext for [] s\ndef ext: udf" );
+    prepare( ten, "get", 0 );
+    
+    script( ten, "def get: udf\ncollect()" );
+    if( freed != 0 )
+        return false;
+    
+    ten_freePrep( ten, prep );
+    script( ten, "collect()" );
+    return freed == 1;
+}
+
+void
+testPrepared( void ) {
+    group( "Prepared Calls" );
+    check( "Fixed Arity Call", NULL, fixedArity );
+    check( "Zero Argument Call", NULL, noArgs );
+    check( "Variadic Call", NULL, variadic );
+    check( "Wrong Argument Count", NULL, wrongCount );
+    check( "Free Prepared Call", NULL, release );
+}
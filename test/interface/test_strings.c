@@ -0,0 +1,147 @@
+#include "interface.h"
+#include <string.h>
+
+// The host's bytes, the part past the `|` is left out of the String
+// so its buffer isn't terminated.
+static char const text[] =
+    "alpha,beta,gamma,delta,epsilon,zeta,eta,theta,iota|junk";
+
+static size_t const textLen = sizeof(text) - sizeof("|junk");
+
+typedef struct {
+    unsigned calls;
+    bool     match;
+} Freed;
+
+static void
+countFree( char const* buf, size_t len, void* udata ) {
+    Freed* freed = udata;
+    freed->calls++;
+    freed->match = buf == text && len == textLen;
+}
+
+// Defines a global external String of `text`, counting its releases
+// in `freed` if given; which must outlive the State.
+static void
+defExt( ten_State* ten, char const* name, Freed* freed ) {
+    ten_Tup tup = ten_pushA( ten, "U" );
+    ten_Var str = ten_var( tup, 0 );
+    ten_newExtStr( ten, text, textLen, freed ? countFree : NULL, freed, &str );
+    ten_def( ten, ten_sym( ten, name ), &str );
+    ten_pop( ten );
+}
+
+static bool
+terminated( ten_State* ten ) {
+    defExt( ten, "ext", NULL );
+    
+    ten_Tup tup = ten_pushA( ten, "U" );
+    ten_Var str = ten_var( tup, 0 );
+    ten_get( ten, ten_sym( ten, "ext" ), &str );
+    
+    char const* buf = ten_getStrBuf( ten, &str );
+    return
+        ten_getStrLen( ten, &str ) == textLen &&
+        strlen( buf ) == textLen &&
+        !memcmp( buf, text, textLen );
+}
+
+static bool
+slicing( ten_State* ten ) {
+    defExt( ten, "ext", NULL );
+    
+    // Long substrings are slices of the external String, short
+    // ones are copies.
+    return
+        holds( ten, "blen( ext ) = 50" ) &&
+        holds( ten, "bcmp( bsub( ext, 5 ), '=', \"alpha\" )" ) &&
+        holds( ten, "bcmp( bsub( ext, -4 ), '=', \"iota\" )" ) &&
+        holds( ten, "blen( bsub( ext, 40 ) ) = 40" ) &&
+        holds( ten, "bcmp( bsub( bsub( ext, 40 ), -3 ), '=', \"ta,\" )" ) &&
+        holds( ten, "bcmp( bsub( ext, -40 ), '=', \",gamma,delta,epsilon,zeta,eta,theta,iota\" )" );
+}
+
+static bool
+splitting( ten_State* ten ) {
+    defExt( ten, "ext", NULL );
+    
+    return
+        holds( ten, "fold( split( ext, \",\" ), 0, [ n, s ] n + 1 ) = 9" ) &&
+        holds( ten, "do def parts: splits( ext, \",\" ) for bcmp( parts@8, '=', \"iota\" )" ) &&
+        holds( ten, "do def parts: splits( ext, \",\" ) for bcmp( parts@0, '=', \"alpha\" )" );
+}
+
+static bool
+recordKey( ten_State* ten ) {
+    defExt( ten, "ext", NULL );
+    script( ten, "def key: \"alpha,beta,gamma,delta,epsilon,zeta,eta,theta,iota\"\n" );
+    
+    // Keys are compared by contents, whichever side is external.
+    return
+        holds( ten, "do def r: { @ext: 1 } for r@key = 1" ) &&
+        holds( ten, "do def r: { @key: 2 } for r@ext = 2" ) &&
+        holds( ten, "do def r: { @( bsub( ext, 40 ) ): 3 } for r@( bsub( key, 40 ) ) = 3" );
+}
+
+static bool
+terminatedSlice( ten_State* ten ) {
+    script( ten, "def long: cat( \"abcdefghijklmnopqrstuvwxyz\", \"0123456789\", \"ABCDEFGHIJKLMNOPQRSTUVWXYZ\" )\ndef s: bsub( long, 40 )" );
+    
+    ten_Tup tup = ten_pushA( ten, "U" );
+    ten_Var str = ten_var( tup, 0 );
+    ten_get( ten, ten_sym( ten, "s" ), &str );
+    
+    char const* buf = ten_getStrBuf( ten, &str );
+    if( strlen( buf ) != 40 || memcmp( buf, "abcdefghijklmnopqrstuvwxyz0123456789ABCD", 40 ) )
+        return false;
+    
+    // The terminated copy is kept with the slice, which still
+    // keeps its parent alive.
+    script( ten, "def long: udf\ncollect()" );
+    return
+        ten_getStrBuf( ten, &str ) == buf &&
+        holds( ten, "bcmp( bsub( s, -4 ), '=', \"ABCD\" )" ) &&
+        holds( ten, "bcmp( bsub( s, 36 ), '=', \"abcdefghijklmnopqrstuvwxyz0123456789\" )" );
+}
+
+static bool
+destructor( ten_State* ten ) {
+    Freed collected = { 0 };
+    Freed released  = { 0 };
+    
+    jmp_buf    jmp;
+    ten_State* other = ten_make( NULL, &jmp );
+    if( setjmp( jmp ) ) {
+        ten_free( other );
+        return false;
+    }
+    
+    // A slice keeps its external parent alive.
+    defExt( other, "ext", &collected );
+    script( other, "def keep: bsub( ext, 40 )\ndef ext: udf\ncollect()" );
+    bool kept = collected.calls == 0;
+    
+    script( other, "def keep: udf\ncollect()\ncollect()" );
+    bool dropped = collected.calls == 1 && collected.match;
+    
+    // Strings still alive are released with the State.
+    defExt( other, "ext", &released );
+    ten_free( other );
+    return
+        kept && dropped &&
+        collected.calls == 1 &&
+        released.calls == 1 && released.match;
+}
+
+void
+testStrings( void ) {
+    group( "External Strings" );
+    check( "Terminated Buffer", NULL, terminated );
+    check( "Slicing", NULL, slicing );
+    check( "Splitting", NULL, splitting );
+    check( "Record Keys", NULL, recordKey );
+    check( "Destructor Called Once", NULL, destructor );
+    
+    group( "String Slices" );
+    check( "Terminated Slice", NULL, terminatedSlice );
+}
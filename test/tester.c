@@ -2,6 +2,104 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include "interface/interface.h"
+
+// Interface tests, these are run once before the script tests.
+static struct {
+    char const* file;
+    void      (*run)( void );
+} interfaceTests[] = {
+    { "interface/test_images.c", testImages },
+    { "interface/test_memory.c", testMemory },
+    { "interface/test_patterns.c", testPatterns },
+    { "interface/test_globals.c", testGlobals },
+    { "interface/test_prepared.c", testPrepared },
+    { "interface/test_strings.c", testStrings }
+};
+
+void
+group( char const* name ) {
+    printf( "\n" );
+    printf( "Group: %s\n", name );
+    printf( "------------------------------------------\n" );
+}
+
+void
+check( char const* what, ten_Config* config, Test test ) {
+    ten_State* volatile ten    = NULL;
+    bool       volatile passed = false;
+    jmp_buf             jmp;
+    if( setjmp( jmp ) == 0 ) {
+        ten    = ten_make( config, &jmp );
+        passed = test( ten );
+    }
+    if( ten )
+        ten_free( ten );
+    
+    printf( "Testing: %-45s%s\n", what, passed ? "PASSED" : "FAILED" );
+}
+
+bool
+fails( ten_State* ten, void (*fun)( ten_State* ten, void* udata ), void* udata ) {
+    jmp_buf  jmp;
+    jmp_buf* old = ten_swapErrJmp( ten, &jmp );
+    if( setjmp( jmp ) ) {
+        ten_swapErrJmp( ten, old );
+        return true;
+    }
+    
+    fun( ten, udata );
+    ten_swapErrJmp( ten, old );
+    return false;
+}
+
+void
+script( ten_State* ten, char const* src ) {
+    ten_Source* s = ten_stringSource( ten, src, "<script>" );
+    ten_executeScript( ten, s, ten_SCOPE_GLOBAL );
+}
+
+bool
+holds( ten_State* ten, char const* expr ) {
+    ten_Source* s    = ten_stringSource( ten, expr, "<expr>" );
+    ten_Tup     rets = ten_executeExpr( ten, s, ten_SCOPE_GLOBAL );
+    ten_Var     ret  = ten_var( rets, 0 );
+    
+    bool result = ten_size( ten, &rets ) == 1 && ten_isLog( ten, &ret ) && ten_getLog( ten, &ret );
+    ten_pop( ten );
+    return result;
+}
+
+// Globals available to jobs submitted to the test pool's workers.
+static void
+setupWorker( ten_State* ten, void* udata ) {
+    ten_Source* src = ten_stringSource( ten, "def square: [ x ] x * x", "setup" );
+    ten_executeScript( ten, src, ten_SCOPE_GLOBAL );
+}
+
+// Run initialization script.
+static void
+runInit( ten_State* ten ) {
+    ten_Source* initSrc = ten_pathSource( ten, "init.ten" );
+    ten_executeScript( ten, initSrc, ten_SCOPE_GLOBAL );
+}
+
+// Run the tests.
+static void
+runTests( ten_State* ten, char const* pass, char const** tests ) {
+    printf( "\n\n" );
+    printf( "Pass: %s\n", pass );
+    printf( "##########################################\n" );
+    
+    for( unsigned i = 1 ; tests[i] != NULL ; i++ ) {
+        ten_Source* testSrc = ten_pathSource( ten, tests[i] );
+        printf( "\n\n" );
+        printf( "File: %s\n", tests[i] );
+        printf( "==========================================\n" );
+        
+        ten_executeScript( ten, testSrc, ten_SCOPE_LOCAL );
+    }
+}
 
 int
 main( int argc, char const** argv ) {
@@ -38,22 +136,54 @@ main( int argc, char const** argv ) {
         ten_free( ten );
         exit( 1 );
     }
-    ten = ten_make( NULL, &jmp );
     
-    // Run initialization script.
-    ten_Source* initSrc = ten_pathSource( ten, "init.ten" );
-    ten_executeScript( ten, initSrc, ten_SCOPE_GLOBAL );
-
-    // Run the tests.
-    for( unsigned i = 1 ; argv[i] != NULL ; i++ ) {
-        ten_Source* testSrc = ten_pathSource( ten, argv[i] );
+    for( unsigned i = 0 ; i < sizeof(interfaceTests)/sizeof(interfaceTests[0]) ; i++ ) {
         printf( "\n\n" );
-        printf( "File: %s\n", argv[i] );
+        printf( "File: %s\n", interfaceTests[i].file );
         printf( "==========================================\n" );
         
-        ten_executeScript( ten, testSrc, ten_SCOPE_LOCAL );
+        interfaceTests[i].run();
     }
     
+    // Then run the script tests in a plain State.
+    ten = ten_make( NULL, &jmp );
+    runInit( ten );
+    runTests( ten, "Plain State", argv );
+    ten_free( ten );
+    
+    // Then run them again with the State and a worker pool
+    // sharing a symbol table, and in a fork of a State that's
+    // been restored from an image of the initialized one; so
+    // the suite covers all of those as well.
+    ten_SymTab* symtab   = ten_makeSymTab( NULL );
+    ten_Config  poolBase = { .symtab = symtab };
+    ten_PoolConfig poolConfig = {
+        .config  = &poolBase,
+        .workers = 2,
+        .setup   = setupWorker,
+        .udata   = NULL
+    };
+    ten_Pool*  pool   = ten_makePool( &poolConfig );
+    ten_Config config = { .pool = pool, .symtab = symtab };
+    
+    ten = ten_make( &config, &jmp );
+    runInit( ten );
+    
+    ten_Image* img = ten_snapshot( ten );
+    ten_free( ten );
+    ten = ten_make( &config, &jmp );
+    ten_restore( ten, img );
+    ten_freeImage( img );
+    
+    ten_State* parent = ten;
+    ten = ten_fork( parent, &jmp );
+    ten_free( parent );
+    
+    runTests( ten, "Shared Symbols, Image, and Fork", argv );
+    
     ten_free( ten );
+    if( pool )
+        ten_freePool( pool );
+    ten_freeSymTab( symtab );
     return 0;
 }